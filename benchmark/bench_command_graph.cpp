@@ -0,0 +1,119 @@
+/*
+ * bench_command_graph.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ *
+ * Host submission latency per frame: enqueueing kernels one by one vs. CommandGraph::replay(),
+ * with static arguments and with one buffer argument patched every frame. Two frames are kept in flight.
+ */
+
+#include <automy/basic_opencl/CommandGraph.h>
+#include <automy/basic_opencl/Buffer1D.h>
+#include <automy/basic_opencl/Program.h>
+
+#include <bench_util.h>
+
+#include <deque>
+#include <iomanip>
+
+using namespace automy::basic_opencl;
+
+static const char* add_one_source =
+	"__kernel void add_one(__global float* data, const uint num)\n"
+	"{\n"
+	"	const uint i = get_global_id(0);\n"
+	"	if(i < num) {\n"
+	"		data[i] += 1;\n"
+	"	}\n"
+	"}\n";
+
+static const size_t num_frames = 1000;
+static const size_t frames_in_flight = 2;
+
+/*
+ * Returns the median host time of submit() in microseconds, waiting for the frame before last each time.
+ */
+static double time_submit_us(std::shared_ptr<CommandQueue> queue, const std::function<Event(size_t)>& submit)
+{
+	std::deque<Event> pending;
+	std::vector<double> times;
+	for(size_t i = 0; i < num_frames; ++i) {
+		if(pending.size() >= frames_in_flight) {
+			pending.front().wait();
+			pending.pop_front();
+		}
+		const auto time_begin = std::chrono::steady_clock::now();
+		pending.push_back(submit(i));
+		times.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - time_begin).count());
+	}
+	queue->finish();
+	std::sort(times.begin(), times.end());
+	return times[times.size() / 2];
+}
+
+
+int main(int argc, char** argv)
+{
+	try {
+		const auto env = bench::init(argc, argv);
+		const auto queue = env.context->get_queue();
+
+		auto program = Program::create(env.context->get());
+		program->add_source_code(add_one_source);
+		program->create_from_source();
+		if(!program->build({env.device})) {
+			program->print_build_log(std::cerr);
+			return -1;
+		}
+		const size_t num = 4096;
+		const size_t local_size = 64;
+
+		Buffer1D<float> buffer_a(env.context->get_buffer_pool(), num);
+		Buffer1D<float> buffer_b(env.context->get_buffer_pool(), num);
+		buffer_a.set_zero(queue);
+		buffer_b.set_zero(queue);
+
+		std::cout << std::setw(10) << "kernels" << std::setw(14) << "direct us" << std::setw(14) << "graph us"
+				<< std::setw(14) << "patched us" << std::setw(10) << "native" << std::endl;
+
+		for(const size_t num_kernels : {1, 4, 16, 64}) {
+			std::vector<std::shared_ptr<Kernel>> kernels;
+			auto graph = CommandGraph::create();
+			for(size_t k = 0; k < num_kernels; ++k) {
+				auto kernel = program->create_kernel("add_one");
+				kernel->set_args(buffer_a, cl_uint(num));
+				graph->add_kernel(kernel, num, local_size);
+				kernels.push_back(kernel);
+			}
+
+			const double time_direct = time_submit_us(queue, [&](size_t frame) -> Event {
+				Event event;
+				for(const auto& kernel : kernels) {
+					kernel->set(0, frame % 2 ? buffer_b : buffer_a);
+					event = kernel->enqueue(queue, num, local_size, std::vector<Event>());
+				}
+				return event;
+			});
+
+			const double time_graph = time_submit_us(queue, [&](size_t) -> Event {
+				return graph->replay(queue);
+			});
+			const bool is_native = graph->is_native();
+
+			const double time_patched = time_submit_us(queue, [&](size_t frame) -> Event {
+				graph->set_arg(0, 0, frame % 2 ? buffer_b : buffer_a);
+				return graph->replay(queue);
+			});
+
+			std::cout << std::setw(10) << num_kernels << std::fixed << std::setprecision(2)
+					<< std::setw(14) << time_direct << std::setw(14) << time_graph << std::setw(14) << time_patched
+					<< std::setw(10) << (is_native ? "yes" : "no") << std::defaultfloat << std::endl;
+		}
+	}
+	catch(const std::exception& ex) {
+		std::cerr << ex.what() << std::endl;
+		return -1;
+	}
+	return 0;
+}
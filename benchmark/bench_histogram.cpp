@@ -0,0 +1,83 @@
+/*
+ * bench_histogram.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ *
+ * Histogram::count() and sum() with uniform vs. skewed point distributions,
+ * for grids which are accumulated in local memory and grids which are not.
+ */
+
+#include <automy/basic_opencl/Histogram.h>
+
+#include <bench_util.h>
+
+#include <random>
+#include <iomanip>
+
+using namespace automy::basic_opencl;
+
+
+int main(int argc, char** argv)
+{
+	try {
+		const auto env = bench::init(argc, argv);
+		const auto queue = env.context->get_queue();
+		auto histogram = Histogram::create(env.context->get(), env.device, env.kernel_path);
+
+		const size_t num_points = 10000000;
+		const std::vector<std::array<size_t, 3>> grids = {{{256, 1, 1}}, {{64, 64, 1}}, {{128, 128, 64}}};
+
+		std::cout << std::setw(16) << "grid" << std::setw(12) << "local" << std::setw(12) << "dist"
+				<< std::setw(12) << "count ms" << std::setw(12) << "sum ms" << std::setw(14) << "Mpoints/s" << std::endl;
+
+		for(const auto& size : grids) {
+			Histogram::grid_t grid;
+			Buffer3D<cl_uint> counts(env.context->get(), size[0], size[1], size[2]);
+			Buffer3D<cl_float> sums(env.context->get(), size[0], size[1], size[2]);
+
+			for(const bool skewed : {false, true}) {
+				// skewed: 90% of the points fall into a single bin, the rest is spread normally around it
+				std::mt19937 generator(1);
+				std::uniform_real_distribution<float> uniform(0, 1);
+				std::normal_distribution<float> normal(0.5f, 0.05f);
+				std::vector<cl_float4> data(num_points);
+				for(auto& point : data) {
+					for(int i = 0; i < 3; ++i) {
+						float f = 0.5f;
+						if(!skewed) {
+							f = uniform(generator);
+						} else if(uniform(generator) > 0.9f) {
+							f = std::min(std::max(normal(generator), 0.f), 0.999f);
+						}
+						point.s[i] = f * size[i];
+					}
+					point.s[3] = 1;
+				}
+				Buffer1D<cl_float4> points(env.context->get(), num_points);
+				points.upload(queue, data);
+
+				const double time_count = bench::time_ms([&]() {
+					histogram->count(queue, points, grid, counts);
+					queue->finish();
+				});
+				const double time_sum = bench::time_ms([&]() {
+					histogram->sum(queue, points, grid, sums);
+					queue->finish();
+				});
+				const size_t num_bins = size[0] * size[1] * size[2];
+
+				std::cout << std::setw(16) << (std::to_string(size[0]) + "x" + std::to_string(size[1]) + "x" + std::to_string(size[2]))
+						<< std::setw(12) << (histogram->is_privatized(num_bins) ? "yes" : "no")
+						<< std::setw(12) << (skewed ? "skewed" : "uniform") << std::fixed << std::setprecision(3)
+						<< std::setw(12) << time_count << std::setw(12) << time_sum
+						<< std::setw(14) << num_points / (time_count * 1e3) << std::endl;
+			}
+		}
+	}
+	catch(const std::exception& ex) {
+		std::cerr << ex.what() << std::endl;
+		return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,86 @@
+/*
+ * bench_radix_sort.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ *
+ * RadixSort::sort() vs. std::sort() on the host, for 1K to 100M keys.
+ * Device times are given without and with the transfers a host sort would replace.
+ */
+
+#include <automy/basic_opencl/RadixSort.h>
+
+#include <bench_util.h>
+
+#include <random>
+#include <iomanip>
+
+using namespace automy::basic_opencl;
+
+
+template<typename K, typename Dist>
+static void run(const bench::env_t& env, std::shared_ptr<RadixSort> sort, const std::string& name, Dist dist)
+{
+	const auto queue = env.context->get_queue();
+	std::mt19937 generator(1);
+
+	std::cout << std::endl << name << " keys:" << std::endl;
+	std::cout << std::setw(12) << "N" << std::setw(14) << "device ms" << std::setw(16) << "+transfer ms"
+			<< std::setw(16) << "std::sort ms" << std::setw(12) << "speedup" << std::setw(14) << "Mkeys/s" << std::endl;
+
+	for(const auto num : bench::get_sizes(env.device, sizeof(K) * 2, 1000, 100000000)) {
+		std::vector<K> data(num);
+		for(auto& value : data) {
+			value = dist(generator);
+		}
+		Buffer1D<K> keys(env.context->get_buffer_pool(), num);
+		std::vector<K> result(num);
+
+		const double time_device = bench::time_ms(
+			[&]() {
+				sort->sort(queue, keys);
+				queue->finish();
+			},
+			[&]() {
+				keys.upload(queue, data);
+				queue->finish();
+			});
+		const double time_transfer = bench::time_ms([&]() {
+			keys.upload(queue, data);
+			sort->sort(queue, keys);
+			keys.download(queue, result.data());
+		});
+
+		std::vector<K> expected;
+		const double time_host = bench::time_ms([&]() {
+			expected = data;
+			std::sort(expected.begin(), expected.end());
+		});
+		const bool match = std::equal(expected.begin(), expected.end(), result.begin(),
+				[](const K& a, const K& b) { return a == b || (a != a && b != b); });
+
+		std::cout << std::setw(12) << num << std::fixed << std::setprecision(3)
+				<< std::setw(14) << time_device << std::setw(16) << time_transfer << std::setw(16) << time_host
+				<< std::setw(12) << time_host / time_transfer << std::setw(14) << num / (time_device * 1e3)
+				<< (match ? "" : "  MISMATCH") << std::endl;
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	try {
+		const auto env = bench::init(argc, argv);
+		auto scan = Scan::create(env.context->get(), env.device, env.kernel_path);
+		auto sort = RadixSort::create(scan, env.kernel_path);
+
+		run<cl_uint>(env, sort, "uint", std::uniform_int_distribution<cl_uint>());
+		run<cl_float>(env, sort, "float", std::normal_distribution<cl_float>(0, 1000));
+		run<cl_ulong>(env, sort, "ulong", std::uniform_int_distribution<cl_ulong>());
+	}
+	catch(const std::exception& ex) {
+		std::cerr << ex.what() << std::endl;
+		return -1;
+	}
+	return 0;
+}
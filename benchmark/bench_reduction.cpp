@@ -0,0 +1,98 @@
+/*
+ * bench_reduction.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ *
+ * Reduction::sum() vs. the previous approach of local_sum() per work group plus atomic_add_g_f() into one result.
+ */
+
+#include <automy/basic_opencl/Reduction.h>
+#include <automy/basic_opencl/Kernel.h>
+
+#include <bench_util.h>
+
+#include <cmath>
+#include <random>
+#include <iomanip>
+
+using namespace automy::basic_opencl;
+
+static const char* atomic_sum_source =
+	"#include \"local_reduce.cl\"\n"
+	"#include \"atomics.cl\"\n"
+	"__kernel void atomic_sum(__global const float* in, const uint num, __global float* out, __local float* data)\n"
+	"{\n"
+	"	const uint i = get_global_id(0);\n"
+	"	data[get_local_id(0)] = i < num ? in[i] : 0;\n"
+	"	barrier(CLK_LOCAL_MEM_FENCE);\n"
+	"	local_sum(data);\n"
+	"	if(get_local_id(0) == 0) {\n"
+	"		atomic_add_g_f(out, data[0]);\n"
+	"	}\n"
+	"}\n";
+
+
+int main(int argc, char** argv)
+{
+	try {
+		const auto env = bench::init(argc, argv);
+		const auto queue = env.context->get_queue();
+
+		auto reduction = Reduction::create(env.context->get(), env.device, env.kernel_path);
+		reduction->pool = env.context->get_buffer_pool();
+
+		auto program = Program::create(env.context->get());
+		program->add_include_path(env.kernel_path);
+		program->add_source_code(atomic_sum_source);
+		program->create_from_source();
+		if(!program->build({env.device})) {
+			program->print_build_log(std::cerr);
+			return -1;
+		}
+		auto atomic_sum = program->create_kernel("atomic_sum");
+		const size_t local_size = 256;
+
+		std::mt19937 generator(1);
+		std::uniform_real_distribution<float> dist(0, 1);
+
+		std::cout << std::setw(12) << "N" << std::setw(16) << "Reduction ms" << std::setw(16) << "atomic ms"
+				<< std::setw(12) << "speedup" << std::setw(14) << "GB/s" << std::setw(14) << "rel. diff" << std::endl;
+
+		for(const auto num : bench::get_sizes(env.device, sizeof(float), 1000, 100000000)) {
+			std::vector<float> data(num);
+			for(auto& value : data) {
+				value = dist(generator);
+			}
+			Buffer1D<float> in(env.context->get_buffer_pool(), num);
+			in.upload(queue, data);
+			Buffer1D<float> out(env.context->get_buffer_pool(), 1);
+
+			float sum_reduction = 0;
+			const double time_reduction = bench::time_ms([&]() {
+				sum_reduction = reduction->sum(queue, in);
+			});
+
+			float sum_atomic = 0;
+			const double time_atomic = bench::time_ms([&]() {
+				out.set_zero(queue);
+				atomic_sum->set_args(in, cl_uint(num), out, Kernel::local_t(local_size * sizeof(float)));
+				atomic_sum->enqueue_ceiled(queue, num, local_size);
+				out.download(queue, &sum_atomic);
+			});
+
+			std::cout << std::setw(12) << num << std::fixed << std::setprecision(3)
+					<< std::setw(16) << time_reduction << std::setw(16) << time_atomic
+					<< std::setw(12) << time_atomic / time_reduction
+					<< std::setw(14) << num * sizeof(float) / (time_reduction * 1e6)
+					<< std::setw(14) << std::scientific << std::setprecision(2)
+					<< std::fabs(sum_reduction - sum_atomic) / std::max(std::fabs(sum_reduction), 1e-30f)
+					<< std::defaultfloat << std::endl;
+		}
+	}
+	catch(const std::exception& ex) {
+		std::cerr << ex.what() << std::endl;
+		return -1;
+	}
+	return 0;
+}
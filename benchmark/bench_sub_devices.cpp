@@ -0,0 +1,130 @@
+/*
+ * bench_sub_devices.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ *
+ * Bandwidth bound triad (c = a + s * b) on the whole device vs. split across sub-devices with MultiDevice,
+ * partitioned by affinity domain and equally into halves. Partitioning is mostly supported by CPU devices.
+ * Each sub-device works on its own sub-buffers, migrated and initialized on its queue (first touch on its NUMA node).
+ */
+
+#include <automy/basic_opencl/MultiDevice.h>
+#include <automy/basic_opencl/DeviceInfo.h>
+#include <automy/basic_opencl/Program.h>
+#include <automy/basic_opencl/Kernel.h>
+
+#include <bench_util.h>
+
+#include <iomanip>
+
+using namespace automy::basic_opencl;
+
+static const char* triad_source =
+	"__kernel void triad(__global const float* a, __global const float* b, __global float* c, const float s, const uint num)\n"
+	"{\n"
+	"	const uint i = get_global_id(0);\n"
+	"	if(i < num) {\n"
+	"		c[i] = a[i] + s * b[i];\n"
+	"	}\n"
+	"}\n";
+
+static const size_t local_size = 64;
+
+/*
+ * Returns the median time of one triad over num elements in milliseconds, split across devices.
+ */
+static double time_triad(cl_platform_id platform, const std::vector<cl_device_id>& devices, size_t num)
+{
+	auto context = Context::create(platform, devices);
+	auto multi = MultiDevice::create(context->get(), devices);
+
+	auto program = Program::create(context->get());
+	program->add_source_code(triad_source);
+	program->create_from_source();
+	if(!program->build(devices)) {
+		program->print_build_log(std::cerr);
+		throw std::runtime_error("build failed");
+	}
+	Buffer1D<float> a(context->get_buffer_pool(), num);
+	Buffer1D<float> b(context->get_buffer_pool(), num);
+	Buffer1D<float> c(context->get_buffer_pool(), num);
+
+	// fixed split, so every part keeps its sub-buffers on the same sub-device
+	const auto ranges = multi->split(num, multi->get_granularity(sizeof(float)));
+	const auto sub_a = MultiDevice::get_sub_buffers(a, ranges);
+	const auto sub_b = MultiDevice::get_sub_buffers(b, ranges);
+	const auto sub_c = MultiDevice::get_sub_buffers(c, ranges);
+
+	std::vector<std::shared_ptr<Kernel>> kernels;
+	std::vector<Event> events;
+	for(size_t i = 0; i < ranges.size(); ++i) {
+		const auto queue = multi->get_queue(ranges[i].device);
+		const std::vector<Event> migrated = {
+			queue->enqueue_migrate({sub_a[i]->data(), sub_b[i]->data(), sub_c[i]->data()}, CL_MIGRATE_MEM_OBJECT_CONTENT_UNDEFINED)
+		};
+		events.push_back(sub_a[i]->set_zero(queue, migrated));
+		events.push_back(sub_b[i]->set_zero(queue, migrated));
+
+		auto kernel = program->create_kernel("triad");
+		kernel->set_args(*sub_a[i], *sub_b[i], *sub_c[i], cl_float(2), cl_uint(ranges[i].count));
+		kernels.push_back(kernel);
+	}
+	Event::wait(events);
+
+	return bench::time_ms([&]() {
+		std::vector<Event> events;
+		for(size_t i = 0; i < ranges.size(); ++i) {
+			events.push_back(kernels[i]->enqueue_ceiled(multi->get_queue(ranges[i].device), ranges[i].count, local_size, std::vector<Event>()));
+		}
+		Event::wait(events);
+	});
+}
+
+
+int main(int argc, char** argv)
+{
+	try {
+		const auto env = bench::init(argc, argv);
+		const auto info = DeviceInfo::get(env.device);
+
+		std::vector<std::pair<std::string, std::vector<cl_device_id>>> configs;
+		configs.emplace_back("whole device", std::vector<cl_device_id>{env.device});
+		try {
+			configs.emplace_back("by affinity", create_sub_devices_by_affinity(env.device, CL_DEVICE_AFFINITY_DOMAIN_NEXT_PARTITIONABLE));
+		} catch(const std::exception& ex) {
+			std::cout << "by affinity: " << ex.what() << std::endl;
+		}
+		if(info->compute_units > 1) {
+			try {
+				configs.emplace_back("equally / 2", create_sub_devices_equally(env.device, info->compute_units / 2));
+			} catch(const std::exception& ex) {
+				std::cout << "equally / 2: " << ex.what() << std::endl;
+			}
+		}
+
+		std::cout << std::setw(12) << "N";
+		for(const auto& config : configs) {
+			std::cout << std::setw(24) << config.first + " (" + std::to_string(config.second.size()) + ") GB/s";
+		}
+		std::cout << std::endl;
+
+		for(const auto num : bench::get_sizes(env.device, sizeof(float), 1000000, 100000000)) {
+			std::cout << std::setw(12) << num << std::fixed << std::setprecision(1);
+			for(const auto& config : configs) {
+				const double time = time_triad(env.platform, config.second, num);
+				std::cout << std::setw(24) << 3 * num * sizeof(float) / (time * 1e6);
+			}
+			std::cout << std::defaultfloat << std::endl;
+		}
+
+		for(size_t i = 1; i < configs.size(); ++i) {
+			release_devices(configs[i].second);
+		}
+	}
+	catch(const std::exception& ex) {
+		std::cerr << ex.what() << std::endl;
+		return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * bench_util.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#ifndef BENCHMARK_BENCH_UTIL_H_
+#define BENCHMARK_BENCH_UTIL_H_
+
+#include <automy/basic_opencl/Context.h>
+#include <automy/basic_opencl/DeviceInfo.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
+
+
+namespace bench {
+
+using namespace automy::basic_opencl;
+
+struct env_t {
+	std::string kernel_path;
+	cl_platform_id platform = nullptr;
+	cl_device_id device = nullptr;
+	std::shared_ptr<Context> context;
+};
+
+/*
+ * Usage: <program> <kernel_path> [platform index] [device index]
+ */
+inline env_t init(int argc, char** argv, cl_command_queue_properties queue_properties = 0)
+{
+	if(argc < 2) {
+		throw std::logic_error(std::string("usage: ") + argv[0] + " <kernel_path> [platform] [device]");
+	}
+	env_t env;
+	env.kernel_path = argv[1];
+	if(!env.kernel_path.empty() && env.kernel_path.back() != '/' && env.kernel_path.back() != '\\') {
+		env.kernel_path += '/';
+	}
+	const auto platforms = get_platforms();
+	const size_t platform_index = argc > 2 ? std::stoul(argv[2]) : 0;
+	if(platform_index >= platforms.size()) {
+		throw std::runtime_error("no such platform");
+	}
+	env.platform = platforms[platform_index];
+	env.device = get_device(env.platform, CL_DEVICE_TYPE_ALL, argc > 3 ? std::stoul(argv[3]) : 0);
+	env.context = Context::create(env.platform, {env.device}, queue_properties);
+	env.context->include_paths.push_back(env.kernel_path);
+
+	std::cout << "platform: " << get_platform_name(env.platform) << std::endl;
+	std::cout << "device: " << get_device_name(env.device) << " (" << get_driver_version(env.device) << ")" << std::endl;
+	return env;
+}
+
+/*
+ * Returns the median wall time of func in milliseconds, after one warm-up run.
+ * func needs to block until its work has finished, setup (optional) is run before each call without being timed.
+ */
+inline double time_ms(const std::function<void()>& func, const std::function<void()>& setup = nullptr, size_t num_runs = 5)
+{
+	if(setup) {
+		setup();
+	}
+	func();
+	std::vector<double> times;
+	for(size_t i = 0; i < std::max<size_t>(num_runs, 1); ++i) {
+		if(setup) {
+			setup();
+		}
+		const auto time_begin = std::chrono::steady_clock::now();
+		func();
+		times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - time_begin).count());
+	}
+	std::sort(times.begin(), times.end());
+	return times[times.size() / 2];
+}
+
+/*
+ * Sizes from first to last (inclusive), multiplied by factor each step.
+ * Sizes where a buffer of size * item_size bytes exceeds CL_DEVICE_MAX_MEM_ALLOC_SIZE are skipped.
+ */
+inline std::vector<size_t> get_sizes(cl_device_id device, size_t item_size, size_t first, size_t last, size_t factor = 10)
+{
+	const auto max_alloc_size = DeviceInfo::get(device)->max_alloc_size;
+	std::vector<size_t> sizes;
+	for(size_t size = first; size <= last; size *= factor) {
+		if(size * item_size <= max_alloc_size) {
+			sizes.push_back(size);
+		} else {
+			std::cout << "skipping N = " << size << ", exceeds CL_DEVICE_MAX_MEM_ALLOC_SIZE" << std::endl;
+		}
+	}
+	return sizes;
+}
+
+} // bench
+
+#endif /* BENCHMARK_BENCH_UTIL_H_ */
@@ -0,0 +1,111 @@
+/*
+ * BatchMath.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#ifndef INCLUDE_AUTOMY_BASIC_OPENCL_BATCHMATH_H_
+#define INCLUDE_AUTOMY_BASIC_OPENCL_BATCHMATH_H_
+
+#include <automy/basic_opencl/Program.h>
+#include <automy/basic_opencl/Matrix.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <memory>
+
+
+namespace automy {
+namespace basic_opencl {
+
+/*
+ * Small matrix operations over whole Matrix<float, Rows, Cols> batches (depth = batch), using kernel/batch_math.cl.
+ * In SOA layout element i of matrix b is stored at [i * depth + b] instead of [b * Rows * Cols + i],
+ * which gives coalesced access on GPUs, see to_soa() and to_aos().
+ */
+class BatchMath {
+public:
+	enum layout_e {
+		AOS,
+		SOA,
+	};
+
+	std::shared_ptr<BinaryCache> binary_cache;		// optional, set before first use
+
+	/*
+	 * kernel_path is the directory containing batch_math.cl and math.cl
+	 */
+	BatchMath(cl_context context, cl_device_id device, const std::string& kernel_path, layout_e layout = AOS);
+
+	BatchMath(const BatchMath&) = delete;
+	BatchMath& operator=(const BatchMath&) = delete;
+
+	static std::shared_ptr<BatchMath> create(cl_context context, cl_device_id device, const std::string& kernel_path, layout_e layout = AOS);
+
+	void inverse(std::shared_ptr<CommandQueue> queue, const Matrix<float, 3, 3>& A, Matrix<float, 3, 3>& Y);
+
+	void inverse(std::shared_ptr<CommandQueue> queue, const Matrix<float, 4, 4>& A, Matrix<float, 4, 4>& Y);
+
+	/*
+	 * Converts 2D poses (x, y, theta) to 3x3 homogeneous transforms.
+	 */
+	void pose2_to_matrix(std::shared_ptr<CommandQueue> queue, const Matrix<float, 3, 1>& poses, Matrix<float, 3, 3>& Y);
+
+	/*
+	 * out = T * (p, 1), T can have depth 1 to transform all points with the same matrix.
+	 */
+	void transform(std::shared_ptr<CommandQueue> queue, const Matrix<float, 3, 4>& T, const Matrix<float, 3, 1>& points, Matrix<float, 3, 1>& out);
+
+	/*
+	 * Eigen decomposition of symmetric matrices, eigen values in descending order, vectors as columns.
+	 */
+	void eigen_sym(std::shared_ptr<CommandQueue> queue, const Matrix<float, 3, 3>& A, Matrix<float, 3, 1>& values, Matrix<float, 3, 3>& vectors);
+
+	/*
+	 * A = U * diag(S) * V^T, S in descending order.
+	 */
+	void svd(	std::shared_ptr<CommandQueue> queue, const Matrix<float, 3, 3>& A,
+				Matrix<float, 3, 3>& U, Matrix<float, 3, 1>& S, Matrix<float, 3, 3>& V);
+
+	/*
+	 * Solves A * x = b for symmetric positive definite A, x is NaN otherwise.
+	 */
+	void cholesky_solve(std::shared_ptr<CommandQueue> queue, const Matrix<float, 6, 6>& A, const Matrix<float, 6, 1>& b, Matrix<float, 6, 1>& x);
+
+	/*
+	 * Layout conversion, for any Buffer3D<float> of width * height elements per matrix.
+	 */
+	void to_soa(std::shared_ptr<CommandQueue> queue, const Buffer3D<float>& in, Buffer3D<float>& out);
+
+	void to_aos(std::shared_ptr<CommandQueue> queue, const Buffer3D<float>& in, Buffer3D<float>& out);
+
+	layout_e get_layout() const {
+		return layout;
+	}
+
+private:
+	std::shared_ptr<Kernel> get_kernel(const std::string& name);
+
+	void convert(std::shared_ptr<CommandQueue> queue, const std::string& name, const Buffer3D<float>& in, Buffer3D<float>& out);
+
+	void launch(std::shared_ptr<CommandQueue> queue, std::shared_ptr<Kernel> kernel, size_t num);
+
+private:
+	cl_context context;
+	cl_device_id device;
+	std::string kernel_path;
+	layout_e layout;
+
+	std::mutex mutex;
+	std::shared_ptr<Program> program;
+	std::map<std::string, std::shared_ptr<Kernel>> kernels;
+
+};
+
+
+} // basic_opencl
+} // automy
+
+#endif /* INCLUDE_AUTOMY_BASIC_OPENCL_BATCHMATH_H_ */
@@ -0,0 +1,117 @@
+/*
+ * BatchedGemm.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#ifndef INCLUDE_AUTOMY_BASIC_OPENCL_BATCHEDGEMM_H_
+#define INCLUDE_AUTOMY_BASIC_OPENCL_BATCHEDGEMM_H_
+
+#include <automy/basic_opencl/Program.h>
+#include <automy/basic_opencl/Matrix.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <memory>
+
+
+namespace automy {
+namespace basic_opencl {
+
+/*
+ * Batched matrix multiplication over Matrix<T, Rows, Cols> stacks (depth = batch), using kernel/gemm.cl.
+ * A program is built per shape, with the dimensions as compile time constants.
+ * Small matrices (all dimensions <= 8) are computed in registers, one batch element per work item,
+ * larger ones with local memory tiling and register blocking.
+ * If A or B has depth 1 it is used for all batch elements. T = cl_float or cl_double.
+ */
+class BatchedGemm {
+public:
+	std::shared_ptr<BinaryCache> binary_cache;		// optional
+
+	/*
+	 * kernel_path is the directory containing gemm.cl
+	 */
+	BatchedGemm(cl_context context, cl_device_id device, const std::string& kernel_path);
+
+	BatchedGemm(const BatchedGemm&) = delete;
+	BatchedGemm& operator=(const BatchedGemm&) = delete;
+
+	static std::shared_ptr<BatchedGemm> create(cl_context context, cl_device_id device, const std::string& kernel_path);
+
+	/*
+	 * Y = A * B
+	 */
+	template<typename T, size_t N, size_t M, size_t K>
+	void multiply(std::shared_ptr<CommandQueue> queue, const Matrix<T, N, M>& A, const Matrix<T, M, K>& B, Matrix<T, N, K>& Y) {
+		Y.resize(context, get_batch_size(A.depth(), B.depth()));
+		gemm(queue, get_type<T>(), N, M, K, false, false, A, B, Y, A.depth(), B.depth());
+	}
+
+	/*
+	 * Y = A^T * B
+	 */
+	template<typename T, size_t N, size_t M, size_t K>
+	void multiply_AT(std::shared_ptr<CommandQueue> queue, const Matrix<T, M, N>& A, const Matrix<T, M, K>& B, Matrix<T, N, K>& Y) {
+		Y.resize(context, get_batch_size(A.depth(), B.depth()));
+		gemm(queue, get_type<T>(), N, M, K, true, false, A, B, Y, A.depth(), B.depth());
+	}
+
+	/*
+	 * Y = A * B^T
+	 */
+	template<typename T, size_t N, size_t M, size_t K>
+	void multiply_BT(std::shared_ptr<CommandQueue> queue, const Matrix<T, N, M>& A, const Matrix<T, K, M>& B, Matrix<T, N, K>& Y) {
+		Y.resize(context, get_batch_size(A.depth(), B.depth()));
+		gemm(queue, get_type<T>(), N, M, K, false, true, A, B, Y, A.depth(), B.depth());
+	}
+
+	/*
+	 * Y = A^T * B^T
+	 */
+	template<typename T, size_t N, size_t M, size_t K>
+	void multiply_ATBT(std::shared_ptr<CommandQueue> queue, const Matrix<T, M, N>& A, const Matrix<T, K, M>& B, Matrix<T, N, K>& Y) {
+		Y.resize(context, get_batch_size(A.depth(), B.depth()));
+		gemm(queue, get_type<T>(), N, M, K, true, true, A, B, Y, A.depth(), B.depth());
+	}
+
+	/*
+	 * Generic entry point, Y needs to hold max(depth_a, depth_b) matrices of N x K.
+	 */
+	void gemm(	std::shared_ptr<CommandQueue> queue, const std::string& type, size_t N, size_t M, size_t K,
+				bool trans_a, bool trans_b, const Buffer& A, const Buffer& B, Buffer& Y, size_t depth_a, size_t depth_b);
+
+private:
+	struct kernels_t {
+		std::shared_ptr<Program> program;
+		std::shared_ptr<Kernel> kernel;
+		bool is_small = false;
+	};
+
+	template<typename T>
+	static std::string get_type();
+
+	static size_t get_batch_size(size_t depth_a, size_t depth_b);
+
+	kernels_t get_kernels(const std::string& type, size_t N, size_t M, size_t K, bool trans_a, bool trans_b);
+
+private:
+	cl_context context;
+	cl_device_id device;
+	std::string kernel_path;
+
+	std::mutex mutex;
+	std::map<std::string, kernels_t> kernels;
+
+};
+
+template<> inline std::string BatchedGemm::get_type<cl_float>() { return "FLOAT"; }
+template<> inline std::string BatchedGemm::get_type<cl_double>() { return "DOUBLE"; }
+
+
+} // basic_opencl
+} // automy
+
+#endif /* INCLUDE_AUTOMY_BASIC_OPENCL_BATCHEDGEMM_H_ */
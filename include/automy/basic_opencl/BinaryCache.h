@@ -0,0 +1,118 @@
+/*
+ * BinaryCache.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#ifndef INCLUDE_AUTOMY_BASIC_OPENCL_BINARYCACHE_H_
+#define INCLUDE_AUTOMY_BASIC_OPENCL_BINARYCACHE_H_
+
+#include <automy/basic_opencl/Context.h>
+
+#include <set>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+
+
+namespace automy {
+namespace basic_opencl {
+
+/*
+ * Persistent on-disk cache for compiled program binaries.
+ * Entries are written to a temporary file and renamed into place, so concurrent
+ * writers (threads or processes) never expose a partial file.
+ * Least recently used entries are evicted once the total size exceeds max_size.
+ * Temporary files left behind by crashed writers are removed when the cache is opened.
+ */
+class BinaryCache {
+public:
+	BinaryCache(const std::string& path, size_t max_size = 256 * 1024 * 1024);
+
+	BinaryCache(const BinaryCache&) = delete;
+	BinaryCache& operator=(const BinaryCache&) = delete;
+
+	static std::shared_ptr<BinaryCache> create(const std::string& path, size_t max_size = 256 * 1024 * 1024);
+
+	/*
+	 * Computes a key from the program sources, the effective build options and
+	 * platform / device / driver versions of the given device.
+	 * sources should include the files pulled in via #include, see get_includes().
+	 */
+	static std::string get_key(const std::vector<std::string>& sources, const std::string& options, cl_device_id device);
+
+	/*
+	 * Returns the contents of all files included by sources (recursively), which are found
+	 * in the current directory or include_paths. Includes which cannot be found are skipped.
+	 */
+	static std::vector<std::string> get_includes(const std::vector<std::string>& sources, const std::set<std::string>& include_paths);
+
+	/*
+	 * 64-bit FNV-1a hash of data as 16 hex digits, items are separated so that {"ab", "c"} != {"a", "bc"}.
+	 */
+	static std::string get_hash(const std::vector<std::string>& data);
+
+	/*
+	 * Returns a temporary file name next to file_name which is unique across threads and processes,
+	 * to be renamed into place once written.
+	 */
+	static std::string get_tmp_file_name(const std::string& file_name);
+
+	bool load(const std::string& key, std::vector<unsigned char>& binary);
+
+	void store(const std::string& key, const std::vector<unsigned char>& binary);
+
+	/*
+	 * Removes an entry which was loaded but rejected by the driver.
+	 */
+	void invalidate(const std::string& key);
+
+	/*
+	 * Counts one hit or miss, called once per program by Program::build(),
+	 * since a program for multiple devices only loads if all entries are usable.
+	 */
+	void add_result(bool is_hit);
+
+	void clear();
+
+	const std::string& get_path() const {
+		return path;
+	}
+
+	size_t get_max_size() const {
+		return max_size;
+	}
+
+	size_t get_num_hits() const {
+		return num_hits;
+	}
+
+	size_t get_num_misses() const {
+		return num_misses;
+	}
+
+private:
+	void evict();
+
+	void remove_stale_tmp_files();
+
+	std::string get_file_name(const std::string& key) const;
+
+private:
+	std::string path;
+	size_t max_size = 0;
+
+	std::mutex mutex;
+	std::atomic<size_t> num_hits {0};
+	std::atomic<size_t> num_misses {0};
+
+};
+
+
+} // basic_opencl
+} // automy
+
+#endif /* INCLUDE_AUTOMY_BASIC_OPENCL_BINARYCACHE_H_ */
@@ -9,18 +9,29 @@
 #define INCLUDE_AUTOMY_BASIC_OPENCL_BUFFER_H_
 
 #include <automy/basic_opencl/Context.h>
+#include <automy/basic_opencl/BufferPool.h>
 
 
 namespace automy {
 namespace basic_opencl {
 
+/*
+ * Storage from a BufferPool is reused as soon as the buffer is destroyed or re-allocated,
+ * which assumes all commands using it were enqueued to a single in-order queue.
+ * Otherwise call release_after() with the last such command first.
+ * Storage not from a pool is released by OpenCL once all commands using it have finished.
+ */
 class Buffer {
 public:
 	Buffer() {}
 	
 	~Buffer() {
 		if(data_) {
-			clReleaseMemObject(data_);
+			if(pool_) {
+				pool_->free(data_, capacity_, release_event_);
+			} else {
+				clReleaseMemObject(data_);
+			}
 		}
 	}
 	
@@ -31,8 +42,78 @@ public:
 		return data_;
 	}
 	
+	std::shared_ptr<BufferPool> pool() const {
+		return pool_;
+	}
+	
+	/*
+	 * Defers reuse of pooled storage by the next release until event has completed.
+	 */
+	void release_after(const Event& event) {
+		release_event_ = event;
+	}
+	
+protected:
+	void alloc_data(cl_context context, size_t num_bytes, cl_mem_flags flags, void* host_ptr = nullptr) {
+		release_data();
+		if(num_bytes) {
+			cl_int err = 0;
+			data_ = clCreateBuffer(context, flags, num_bytes, host_ptr, &err);
+			if(err) {
+				throw opencl_error_t("clCreateBuffer() failed with " + get_error_string(err));
+			}
+			capacity_ = num_bytes;
+		}
+	}
+	
+	/*
+	 * Uses a region of parent as storage (clCreateSubBuffer), parent is retained by OpenCL.
+	 */
+	void alloc_sub_data(cl_mem parent, size_t offset, size_t num_bytes) {
+		release_data();
+		if(num_bytes) {
+			cl_buffer_region region;
+			region.origin = offset;
+			region.size = num_bytes;
+			cl_int err = 0;
+			data_ = clCreateSubBuffer(parent, 0, CL_BUFFER_CREATE_TYPE_REGION, &region, &err);
+			if(err) {
+				throw opencl_error_t("clCreateSubBuffer() failed with " + get_error_string(err));
+			}
+			capacity_ = num_bytes;
+		}
+	}
+	
+	void alloc_data(std::shared_ptr<BufferPool> pool, size_t num_bytes) {
+		if(pool == pool_ && data_ && pool->get_size_class(num_bytes) == capacity_) {
+			return;
+		}
+		release_data();
+		if(num_bytes) {
+			data_ = pool->alloc(num_bytes, capacity_);
+			pool_ = pool;
+		}
+	}
+	
+	void release_data() {
+		if(data_) {
+			if(pool_) {
+				pool_->free(data_, capacity_, release_event_);
+			} else if(cl_int err = clReleaseMemObject(data_)) {
+				throw opencl_error_t("clReleaseMemObject() failed with " + get_error_string(err));
+			}
+			data_ = nullptr;
+		}
+		pool_ = nullptr;
+		capacity_ = 0;
+		release_event_ = Event();
+	}
+	
 protected:
 	cl_mem data_ = 0;
+	size_t capacity_ = 0;
+	std::shared_ptr<BufferPool> pool_;
+	Event release_event_;
 	
 };
 
@@ -9,6 +9,7 @@
 #define INCLUDE_AUTOMY_BASIC_OPENCL_BUFFER1D_H_
 
 #include <automy/basic_opencl/Buffer.h>
+#include <automy/basic_opencl/MappedView.h>
 
 
 namespace automy {
@@ -23,6 +24,10 @@ public:
 		alloc(context, width, flags);
 	}
 
+	Buffer1D(std::shared_ptr<BufferPool> pool, size_t width) {
+		alloc(pool, width);
+	}
+
 	static std::shared_ptr<Buffer1D<T>> create() {
 		return std::make_shared<Buffer1D<T>>();
 	}
@@ -31,32 +36,57 @@ public:
 		return std::make_shared<Buffer1D<T>>(context, width, flags);
 	}
 
+	static std::shared_ptr<Buffer1D<T>> create(std::shared_ptr<BufferPool> pool, size_t width) {
+		return std::make_shared<Buffer1D<T>>(pool, width);
+	}
+
 	void alloc(cl_context context, size_t new_size, cl_mem_flags flags = 0) {
-		if(new_size != size() || flags != flags_) {
-			if(data_) {
-				if(cl_int err = clReleaseMemObject(data_)) {
-					throw opencl_error_t("clReleaseMemObject() failed with " + get_error_string(err));
-				}
-				data_ = nullptr;
-			}
-			if(new_size) {
-				cl_int err = 0;
-				data_ = clCreateBuffer(context, flags, new_size * sizeof(T), nullptr, &err);
-				if(err) {
-					throw opencl_error_t("clCreateBuffer() failed with " + get_error_string(err));
-				}
-			}
+		if(pool_ || new_size != size() || flags != flags_) {
+			alloc_data(context, new_size * sizeof(T), flags);
 		}
 		size_ = new_size;
 		flags_ = flags;
 	}
 
+	/*
+	 * Takes storage from the pool, the old storage is returned to the pool.
+	 */
+	void alloc(std::shared_ptr<BufferPool> pool, size_t new_size) {
+		alloc_data(pool, new_size * sizeof(T));
+		size_ = new_size;
+		flags_ = pool->get_flags();
+	}
+
 	void alloc_min(cl_context context, size_t min_size, cl_mem_flags flags = 0) {
 		if(min_size > size() || flags != flags_) {
 			alloc(context, min_size, flags);
 		}
 	}
 
+	/*
+	 * Uses host memory as storage (CL_MEM_USE_HOST_PTR), which needs to stay valid for the lifetime of the buffer.
+	 * For zero-copy access host_ptr should be aligned to 4096 bytes and the size a multiple of 64 bytes.
+	 * Use alloc() with CL_MEM_ALLOC_HOST_PTR to let the driver allocate host accessible memory instead.
+	 */
+	void use_host_ptr(cl_context context, T* host_ptr, size_t new_size, cl_mem_flags flags = 0) {
+		flags |= CL_MEM_USE_HOST_PTR;
+		alloc_data(context, new_size * sizeof(T), flags, host_ptr);
+		size_ = new_size;
+		flags_ = flags;
+	}
+
+	/*
+	 * Makes this a view of [offset, offset + count) of parent, without copying.
+	 * offset * sizeof(T) needs to be a multiple of CL_DEVICE_MEM_BASE_ADDR_ALIGN (in bytes) of all devices.
+	 * Different devices may write to non-overlapping sub-buffers of the same parent concurrently.
+	 */
+	void alloc_sub(const Buffer1D<T>& parent, size_t offset, size_t count) {
+		parent.check_range(offset, count);
+		alloc_sub_data(parent.data(), offset * sizeof(T), count * sizeof(T));
+		size_ = count;
+		flags_ = parent.flags();
+	}
+
 	size_t size() const {
 		return size_;
 	}
@@ -67,9 +97,11 @@ public:
 
 	void upload(std::shared_ptr<CommandQueue> queue, const T* data, bool copy = true) {
 		if(data_) {
-			if(cl_int err = clEnqueueWriteBuffer(queue->get(), data_, copy ? CL_TRUE : CL_FALSE, 0, num_bytes(), data, 0, 0, 0)) {
+			Event event;
+			if(cl_int err = clEnqueueWriteBuffer(queue->get(), data_, copy ? CL_TRUE : CL_FALSE, 0, num_bytes(), data, 0, 0, queue->get_event(event))) {
 				throw opencl_error_t("clEnqueueWriteBuffer() failed with " + get_error_string(err));
 			}
+			queue->record(event, Profiler::WRITE, num_bytes());
 		}
 	}
 
@@ -79,35 +111,43 @@ public:
 
 	void download(std::shared_ptr<CommandQueue> queue, T* data, bool blocking = true) const {
 		if(data_) {
-			if(cl_int err = clEnqueueReadBuffer(queue->get(), data_, blocking ? CL_TRUE : CL_FALSE, 0, num_bytes(), data, 0, 0, 0)) {
+			Event event;
+			if(cl_int err = clEnqueueReadBuffer(queue->get(), data_, blocking ? CL_TRUE : CL_FALSE, 0, num_bytes(), data, 0, 0, queue->get_event(event))) {
 				throw opencl_error_t("clEnqueueReadBuffer() failed with " + get_error_string(err));
 			}
+			queue->record(event, Profiler::READ, num_bytes());
 		}
 	}
 
 	void download_count(std::shared_ptr<CommandQueue> queue, T* data, size_t count, bool blocking = true) const {
 		if(data_) {
-			if(cl_int err = clEnqueueReadBuffer(queue->get(), data_, blocking ? CL_TRUE : CL_FALSE, 0, count * sizeof(T), data, 0, 0, 0)) {
+			Event event;
+			if(cl_int err = clEnqueueReadBuffer(queue->get(), data_, blocking ? CL_TRUE : CL_FALSE, 0, count * sizeof(T), data, 0, 0, queue->get_event(event))) {
 				throw opencl_error_t("clEnqueueReadBuffer() failed with " + get_error_string(err));
 			}
+			queue->record(event, Profiler::READ, count * sizeof(T));
 		}
 	}
 
 	std::vector<T> download(std::shared_ptr<CommandQueue> queue) const {
 		std::vector<T> res(size());
 		if(data_) {
-			if(cl_int err = clEnqueueReadBuffer(queue->get(), data_, CL_TRUE, 0, num_bytes(), res.data(), 0, 0, 0)) {
+			Event event;
+			if(cl_int err = clEnqueueReadBuffer(queue->get(), data_, CL_TRUE, 0, num_bytes(), res.data(), 0, 0, queue->get_event(event))) {
 				throw opencl_error_t("clEnqueueReadBuffer() failed with " + get_error_string(err));
 			}
+			queue->record(event, Profiler::READ, num_bytes());
 		}
 		return res;
 	}
 
 	void copy_from(std::shared_ptr<CommandQueue> queue, const Buffer1D<T>& other) {
 		if(data_) {
-			if(cl_int err = clEnqueueCopyBuffer(queue->get(), other.data(), data_, 0, 0, num_bytes(), 0, 0, 0)) {
+			Event event;
+			if(cl_int err = clEnqueueCopyBuffer(queue->get(), other.data(), data_, 0, 0, num_bytes(), 0, 0, queue->get_event(event))) {
 				throw opencl_error_t("clEnqueueCopyBuffer() failed with " + get_error_string(err));
 			}
+			queue->record(event, Profiler::COPY, num_bytes());
 		}
 	}
 
@@ -117,9 +157,149 @@ public:
 
 	void memset(std::shared_ptr<CommandQueue> queue, const T value) {
 		if(data_) {
-			if(cl_int err = clEnqueueFillBuffer(queue->get(), data_, &value, sizeof(T), 0, num_bytes(), 0, 0, 0)) {
+			Event event;
+			if(cl_int err = clEnqueueFillBuffer(queue->get(), data_, &value, sizeof(T), 0, num_bytes(), 0, 0, queue->get_event(event))) {
+				throw opencl_error_t("clEnqueueFillBuffer() failed with " + get_error_string(err));
+			}
+			queue->record(event, Profiler::FILL, num_bytes());
+		}
+	}
+
+	/*
+	 * Transfer only count elements starting at element offset of the buffer.
+	 */
+	void upload_range(std::shared_ptr<CommandQueue> queue, const T* data, size_t offset, size_t count, bool blocking = true) {
+		check_range(offset, count);
+		if(count) {
+			Event event;
+			if(cl_int err = clEnqueueWriteBuffer(queue->get(), data_, blocking ? CL_TRUE : CL_FALSE, offset * sizeof(T), count * sizeof(T), data, 0, 0, queue->get_event(event))) {
+				throw opencl_error_t("clEnqueueWriteBuffer() failed with " + get_error_string(err));
+			}
+			queue->record(event, Profiler::WRITE, count * sizeof(T));
+		}
+	}
+
+	void download_range(std::shared_ptr<CommandQueue> queue, T* data, size_t offset, size_t count, bool blocking = true) const {
+		check_range(offset, count);
+		if(count) {
+			Event event;
+			if(cl_int err = clEnqueueReadBuffer(queue->get(), data_, blocking ? CL_TRUE : CL_FALSE, offset * sizeof(T), count * sizeof(T), data, 0, 0, queue->get_event(event))) {
+				throw opencl_error_t("clEnqueueReadBuffer() failed with " + get_error_string(err));
+			}
+			queue->record(event, Profiler::READ, count * sizeof(T));
+		}
+	}
+
+	void copy_range_from(std::shared_ptr<CommandQueue> queue, const Buffer1D<T>& other, size_t src_offset, size_t dst_offset, size_t count) {
+		other.check_range(src_offset, count);
+		check_range(dst_offset, count);
+		if(count) {
+			Event event;
+			if(cl_int err = clEnqueueCopyBuffer(queue->get(), other.data(), data_, src_offset * sizeof(T), dst_offset * sizeof(T), count * sizeof(T), 0, 0, queue->get_event(event))) {
+				throw opencl_error_t("clEnqueueCopyBuffer() failed with " + get_error_string(err));
+			}
+			queue->record(event, Profiler::COPY, count * sizeof(T));
+		}
+	}
+
+	/*
+	 * Non-blocking variants: wait for all events in wait_list, the returned event signals completion.
+	 * Host memory needs to stay valid until then.
+	 */
+	Event upload(std::shared_ptr<CommandQueue> queue, const T* data, const std::vector<Event>& wait_list) {
+		Event event;
+		if(data_) {
+			const EventList list(wait_list);
+			if(cl_int err = clEnqueueWriteBuffer(queue->get(), data_, CL_FALSE, 0, num_bytes(), data, list.size(), list.data(), event.reset())) {
+				throw opencl_error_t("clEnqueueWriteBuffer() failed with " + get_error_string(err));
+			}
+			queue->record(event, Profiler::WRITE, num_bytes());
+		}
+		return event;
+	}
+
+	Event upload(std::shared_ptr<CommandQueue> queue, const std::vector<T>& vec, const std::vector<Event>& wait_list) {
+		return upload(queue, vec.data(), wait_list);
+	}
+
+	Event download(std::shared_ptr<CommandQueue> queue, T* data, const std::vector<Event>& wait_list) const {
+		Event event;
+		if(data_) {
+			const EventList list(wait_list);
+			if(cl_int err = clEnqueueReadBuffer(queue->get(), data_, CL_FALSE, 0, num_bytes(), data, list.size(), list.data(), event.reset())) {
+				throw opencl_error_t("clEnqueueReadBuffer() failed with " + get_error_string(err));
+			}
+			queue->record(event, Profiler::READ, num_bytes());
+		}
+		return event;
+	}
+
+	Event copy_from(std::shared_ptr<CommandQueue> queue, const Buffer1D<T>& other, const std::vector<Event>& wait_list) {
+		Event event;
+		if(data_) {
+			const EventList list(wait_list);
+			if(cl_int err = clEnqueueCopyBuffer(queue->get(), other.data(), data_, 0, 0, num_bytes(), list.size(), list.data(), event.reset())) {
+				throw opencl_error_t("clEnqueueCopyBuffer() failed with " + get_error_string(err));
+			}
+			queue->record(event, Profiler::COPY, num_bytes());
+		}
+		return event;
+	}
+
+	Event set_zero(std::shared_ptr<CommandQueue> queue, const std::vector<Event>& wait_list) {
+		return memset(queue, T(), wait_list);
+	}
+
+	Event memset(std::shared_ptr<CommandQueue> queue, const T value, const std::vector<Event>& wait_list) {
+		Event event;
+		if(data_) {
+			const EventList list(wait_list);
+			if(cl_int err = clEnqueueFillBuffer(queue->get(), data_, &value, sizeof(T), 0, num_bytes(), list.size(), list.data(), event.reset())) {
 				throw opencl_error_t("clEnqueueFillBuffer() failed with " + get_error_string(err));
 			}
+			queue->record(event, Profiler::FILL, num_bytes());
+		}
+		return event;
+	}
+
+	/*
+	 * Maps the buffer into host memory (blocking), unmapped when the view is destroyed.
+	 */
+	MappedView<const T> map_read(std::shared_ptr<CommandQueue> queue) const {
+		return map_read(queue, 0, size());
+	}
+
+	MappedView<const T> map_read(std::shared_ptr<CommandQueue> queue, size_t offset, size_t count) const {
+		return MappedView<const T>(queue, data_, CL_MAP_READ, offset, count);
+	}
+
+	/*
+	 * Previous content is undefined, the whole view needs to be written.
+	 */
+	MappedView<T> map_write(std::shared_ptr<CommandQueue> queue) {
+		return map_write(queue, 0, size());
+	}
+
+	MappedView<T> map_write(std::shared_ptr<CommandQueue> queue, size_t offset, size_t count) {
+		return MappedView<T>(queue, data_, CL_MAP_WRITE_INVALIDATE_REGION, offset, count);
+	}
+
+	MappedView<T> map_read_write(std::shared_ptr<CommandQueue> queue) {
+		return map_read_write(queue, 0, size());
+	}
+
+	MappedView<T> map_read_write(std::shared_ptr<CommandQueue> queue, size_t offset, size_t count) {
+		return MappedView<T>(queue, data_, CL_MAP_READ | CL_MAP_WRITE, offset, count);
+	}
+
+	cl_mem_flags flags() const {
+		return flags_;
+	}
+
+private:
+	void check_range(size_t offset, size_t count) const {
+		if(offset > size() || count > size() - offset) {
+			throw std::logic_error("range out of bounds: " + std::to_string(offset) + " + " + std::to_string(count) + " > " + std::to_string(size()));
 		}
 	}
 
@@ -9,6 +9,9 @@
 #define INCLUDE_AUTOMY_BASIC_OPENCL_BUFFER3D_H_
 
 #include <automy/basic_opencl/Buffer.h>
+#include <automy/basic_opencl/MappedView.h>
+
+#include <array>
 
 #ifdef WITH_AUTOMY_BASIC
 #include <automy/basic/Image.hpp>
@@ -27,8 +30,12 @@ class Buffer3D : public Buffer {
 public:
 	Buffer3D() {}
 	
-	Buffer3D(cl_context context, size_t width, size_t height, size_t depth = 1) {
-		resize(context, width, height, depth);
+	Buffer3D(cl_context context, size_t width, size_t height, size_t depth = 1, cl_mem_flags flags = 0) {
+		resize(context, width, height, depth, flags);
+	}
+	
+	Buffer3D(std::shared_ptr<BufferPool> pool, size_t width, size_t height, size_t depth = 1) {
+		resize(pool, width, height, depth);
 	}
 	
 	static std::shared_ptr<Buffer3D<T>> create() {
@@ -39,26 +46,71 @@ public:
 		return std::make_shared<Buffer3D<T>>(width, height, depth);
 	}
 	
-	void resize(cl_context context, size_t width, size_t height, size_t depth = 1) {
+	static std::shared_ptr<Buffer3D<T>> create(std::shared_ptr<BufferPool> pool, size_t width, size_t height, size_t depth = 1) {
+		return std::make_shared<Buffer3D<T>>(pool, width, height, depth);
+	}
+	
+	void resize(cl_context context, size_t width, size_t height, size_t depth = 1, cl_mem_flags flags = 0) {
 		const size_t new_size = width * height * depth;
-		if(new_size != size()) {
-			if(data_) {
-				if(cl_int err = clReleaseMemObject(data_)) {
-					throw opencl_error_t("clReleaseMemObject() failed with " + get_error_string(err));
-				}
-				data_ = 0;
-			}
-			if(new_size) {
-				cl_int err = 0;
-				data_ = clCreateBuffer(context, 0, width * height * depth * sizeof(T), nullptr, &err);
-				if(err) {
-					throw opencl_error_t("clCreateBuffer() failed with " + get_error_string(err));
-				}
-			}
+		if(pool_ || new_size != size() || flags != flags_) {
+			alloc_data(context, new_size * sizeof(T), flags);
 		}
 		width_ = width;
 		height_ = height;
 		depth_ = depth;
+		flags_ = flags;
+	}
+	
+	/*
+	 * Uses host memory as storage (CL_MEM_USE_HOST_PTR), which needs to stay valid for the lifetime of the buffer.
+	 * For zero-copy access host_ptr should be aligned to 4096 bytes and the size a multiple of 64 bytes.
+	 */
+	void use_host_ptr(cl_context context, T* host_ptr, size_t width, size_t height, size_t depth = 1, cl_mem_flags flags = 0) {
+		flags |= CL_MEM_USE_HOST_PTR;
+		alloc_data(context, width * height * depth * sizeof(T), flags, host_ptr);
+		width_ = width;
+		height_ = height;
+		depth_ = depth;
+		flags_ = flags;
+	}
+	
+	/*
+	 * Takes storage from the pool, the old storage is returned to the pool.
+	 */
+	void resize(std::shared_ptr<BufferPool> pool, size_t width, size_t height, size_t depth = 1) {
+		alloc_data(pool, width * height * depth * sizeof(T));
+		width_ = width;
+		height_ = height;
+		depth_ = depth;
+		flags_ = pool->get_flags();
+	}
+	
+	/*
+	 * Makes this a view of slices [z, z + depth) of parent, without copying, see Buffer1D::alloc_sub().
+	 */
+	void alloc_sub(const Buffer3D<T>& parent, size_t z, size_t depth) {
+		parent.check_region({{0, 0, z}}, {{parent.width_, parent.height_, depth}});
+		const size_t slice = parent.width_ * parent.height_;
+		alloc_sub_data(parent.data(), z * slice * sizeof(T), depth * slice * sizeof(T));
+		width_ = parent.width_;
+		height_ = parent.height_;
+		depth_ = depth;
+		flags_ = parent.flags();
+	}
+	
+	/*
+	 * Makes this a view of rows [y, y + height) of a 2D parent (depth == 1), without copying.
+	 */
+	void alloc_sub_rows(const Buffer3D<T>& parent, size_t y, size_t height) {
+		if(parent.depth_ != 1) {
+			throw std::logic_error("alloc_sub_rows(): depth != 1");
+		}
+		parent.check_region({{0, y, 0}}, {{parent.width_, height, 1}});
+		alloc_sub_data(parent.data(), y * parent.width_ * sizeof(T), height * parent.width_ * sizeof(T));
+		width_ = parent.width_;
+		height_ = height;
+		depth_ = 1;
+		flags_ = parent.flags();
 	}
 	
 	size_t width() const {
@@ -79,9 +131,11 @@ public:
 	
 	void upload(std::shared_ptr<CommandQueue> queue, const T* data, bool copy = true) {
 		if(data_) {
-			if(cl_int err = clEnqueueWriteBuffer(queue->get(), data_, copy ? CL_TRUE : CL_FALSE, 0, size() * sizeof(T), data, 0, 0, 0)) {
+			Event event;
+			if(cl_int err = clEnqueueWriteBuffer(queue->get(), data_, copy ? CL_TRUE : CL_FALSE, 0, size() * sizeof(T), data, 0, 0, queue->get_event(event))) {
 				throw opencl_error_t("clEnqueueWriteBuffer() failed with " + get_error_string(err));
 			}
+			queue->record(event, Profiler::WRITE, size() * sizeof(T));
 		}
 	}
 	
@@ -91,9 +145,11 @@ public:
 	
 	void download(std::shared_ptr<CommandQueue> queue, T* data, bool blocking = true) const {
 		if(data_) {
-			if(cl_int err = clEnqueueReadBuffer(queue->get(), data_, blocking ? CL_TRUE : CL_FALSE, 0, size() * sizeof(T), data, 0, 0, 0)) {
+			Event event;
+			if(cl_int err = clEnqueueReadBuffer(queue->get(), data_, blocking ? CL_TRUE : CL_FALSE, 0, size() * sizeof(T), data, 0, 0, queue->get_event(event))) {
 				throw opencl_error_t("clEnqueueReadBuffer() failed with " + get_error_string(err));
 			}
+			queue->record(event, Profiler::READ, size() * sizeof(T));
 		}
 	}
 
@@ -124,25 +180,184 @@ public:
 	
 	void copy_from(std::shared_ptr<CommandQueue> queue, const Buffer3D<T>& other) {
 		if(data_) {
-			if(cl_int err = clEnqueueCopyBuffer(queue->get(), other.data(), data_, 0, 0, size() * sizeof(T), 0, 0, 0)) {
+			Event event;
+			if(cl_int err = clEnqueueCopyBuffer(queue->get(), other.data(), data_, 0, 0, size() * sizeof(T), 0, 0, queue->get_event(event))) {
 				throw opencl_error_t("clEnqueueCopyBuffer() failed with " + get_error_string(err));
 			}
+			queue->record(event, Profiler::COPY, size() * sizeof(T));
 		}
 	}
 	
 	void set_zero(std::shared_ptr<CommandQueue> queue) {
 		const T zero = T();
 		if(data_) {
-			if(cl_int err = clEnqueueFillBuffer(queue->get(), data_, &zero, sizeof(T), 0, size() * sizeof(T), 0, 0, 0)) {
+			Event event;
+			if(cl_int err = clEnqueueFillBuffer(queue->get(), data_, &zero, sizeof(T), 0, size() * sizeof(T), 0, 0, queue->get_event(event))) {
+				throw opencl_error_t("clEnqueueFillBuffer() failed with " + get_error_string(err));
+			}
+			queue->record(event, Profiler::FILL, size() * sizeof(T));
+		}
+	}
+	
+	/*
+	 * Transfer a box of region elements at origin (x, y, z) in the buffer.
+	 * Host pitches are in elements, zero means tightly packed.
+	 */
+	void upload_region(	std::shared_ptr<CommandQueue> queue, const T* data,
+						const std::array<size_t, 3>& origin, const std::array<size_t, 3>& region,
+						size_t host_row_pitch = 0, size_t host_slice_pitch = 0, bool blocking = true)
+	{
+		check_region(origin, region);
+		if(region[0] && region[1] && region[2]) {
+			Event event;
+			const std::array<size_t, 3> host_origin = {{0, 0, 0}};
+			if(cl_int err = clEnqueueWriteBufferRect(queue->get(), data_, blocking ? CL_TRUE : CL_FALSE,
+					get_byte_origin(origin).data(), host_origin.data(), get_byte_region(region).data(),
+					width_ * sizeof(T), width_ * height_ * sizeof(T), host_row_pitch * sizeof(T), host_slice_pitch * sizeof(T),
+					data, 0, 0, queue->get_event(event)))
+			{
+				throw opencl_error_t("clEnqueueWriteBufferRect() failed with " + get_error_string(err));
+			}
+			queue->record(event, Profiler::WRITE, region[0] * region[1] * region[2] * sizeof(T));
+		}
+	}
+	
+	void download_region(	std::shared_ptr<CommandQueue> queue, T* data,
+							const std::array<size_t, 3>& origin, const std::array<size_t, 3>& region,
+							size_t host_row_pitch = 0, size_t host_slice_pitch = 0, bool blocking = true) const
+	{
+		check_region(origin, region);
+		if(region[0] && region[1] && region[2]) {
+			Event event;
+			const std::array<size_t, 3> host_origin = {{0, 0, 0}};
+			if(cl_int err = clEnqueueReadBufferRect(queue->get(), data_, blocking ? CL_TRUE : CL_FALSE,
+					get_byte_origin(origin).data(), host_origin.data(), get_byte_region(region).data(),
+					width_ * sizeof(T), width_ * height_ * sizeof(T), host_row_pitch * sizeof(T), host_slice_pitch * sizeof(T),
+					data, 0, 0, queue->get_event(event)))
+			{
+				throw opencl_error_t("clEnqueueReadBufferRect() failed with " + get_error_string(err));
+			}
+			queue->record(event, Profiler::READ, region[0] * region[1] * region[2] * sizeof(T));
+		}
+	}
+	
+	void copy_region_from(	std::shared_ptr<CommandQueue> queue, const Buffer3D<T>& other,
+							const std::array<size_t, 3>& src_origin, const std::array<size_t, 3>& dst_origin,
+							const std::array<size_t, 3>& region)
+	{
+		other.check_region(src_origin, region);
+		check_region(dst_origin, region);
+		if(region[0] && region[1] && region[2]) {
+			Event event;
+			if(cl_int err = clEnqueueCopyBufferRect(queue->get(), other.data(), data_,
+					get_byte_origin(src_origin).data(), get_byte_origin(dst_origin).data(), get_byte_region(region).data(),
+					other.width() * sizeof(T), other.width() * other.height() * sizeof(T),
+					width_ * sizeof(T), width_ * height_ * sizeof(T), 0, 0, queue->get_event(event)))
+			{
+				throw opencl_error_t("clEnqueueCopyBufferRect() failed with " + get_error_string(err));
+			}
+			queue->record(event, Profiler::COPY, region[0] * region[1] * region[2] * sizeof(T));
+		}
+	}
+	
+	/*
+	 * Non-blocking variants: wait for all events in wait_list, the returned event signals completion.
+	 * Host memory needs to stay valid until then.
+	 */
+	Event upload(std::shared_ptr<CommandQueue> queue, const T* data, const std::vector<Event>& wait_list) {
+		Event event;
+		if(data_) {
+			const EventList list(wait_list);
+			if(cl_int err = clEnqueueWriteBuffer(queue->get(), data_, CL_FALSE, 0, size() * sizeof(T), data, list.size(), list.data(), event.reset())) {
+				throw opencl_error_t("clEnqueueWriteBuffer() failed with " + get_error_string(err));
+			}
+			queue->record(event, Profiler::WRITE, size() * sizeof(T));
+		}
+		return event;
+	}
+	
+	Event download(std::shared_ptr<CommandQueue> queue, T* data, const std::vector<Event>& wait_list) const {
+		Event event;
+		if(data_) {
+			const EventList list(wait_list);
+			if(cl_int err = clEnqueueReadBuffer(queue->get(), data_, CL_FALSE, 0, size() * sizeof(T), data, list.size(), list.data(), event.reset())) {
+				throw opencl_error_t("clEnqueueReadBuffer() failed with " + get_error_string(err));
+			}
+			queue->record(event, Profiler::READ, size() * sizeof(T));
+		}
+		return event;
+	}
+	
+	Event copy_from(std::shared_ptr<CommandQueue> queue, const Buffer3D<T>& other, const std::vector<Event>& wait_list) {
+		Event event;
+		if(data_) {
+			const EventList list(wait_list);
+			if(cl_int err = clEnqueueCopyBuffer(queue->get(), other.data(), data_, 0, 0, size() * sizeof(T), list.size(), list.data(), event.reset())) {
+				throw opencl_error_t("clEnqueueCopyBuffer() failed with " + get_error_string(err));
+			}
+			queue->record(event, Profiler::COPY, size() * sizeof(T));
+		}
+		return event;
+	}
+	
+	Event set_zero(std::shared_ptr<CommandQueue> queue, const std::vector<Event>& wait_list) {
+		Event event;
+		const T zero = T();
+		if(data_) {
+			const EventList list(wait_list);
+			if(cl_int err = clEnqueueFillBuffer(queue->get(), data_, &zero, sizeof(T), 0, size() * sizeof(T), list.size(), list.data(), event.reset())) {
 				throw opencl_error_t("clEnqueueFillBuffer() failed with " + get_error_string(err));
 			}
+			queue->record(event, Profiler::FILL, size() * sizeof(T));
 		}
+		return event;
+	}
+	
+	/*
+	 * Maps the buffer into host memory (blocking), unmapped when the view is destroyed.
+	 */
+	MappedView<const T> map_read(std::shared_ptr<CommandQueue> queue) const {
+		return MappedView<const T>(queue, data_, CL_MAP_READ, 0, size());
+	}
+	
+	/*
+	 * Previous content is undefined, the whole view needs to be written.
+	 */
+	MappedView<T> map_write(std::shared_ptr<CommandQueue> queue) {
+		return MappedView<T>(queue, data_, CL_MAP_WRITE_INVALIDATE_REGION, 0, size());
+	}
+	
+	MappedView<T> map_read_write(std::shared_ptr<CommandQueue> queue) {
+		return MappedView<T>(queue, data_, CL_MAP_READ | CL_MAP_WRITE, 0, size());
+	}
+	
+	cl_mem_flags flags() const {
+		return flags_;
+	}
+	
+private:
+	void check_region(const std::array<size_t, 3>& origin, const std::array<size_t, 3>& region) const {
+		const std::array<size_t, 3> dims = {{width_, height_, depth_}};
+		for(int i = 0; i < 3; ++i) {
+			if(origin[i] > dims[i] || region[i] > dims[i] - origin[i]) {
+				throw std::logic_error("region out of bounds");
+			}
+		}
+	}
+	
+	static std::array<size_t, 3> get_byte_origin(const std::array<size_t, 3>& origin) {
+		return {{origin[0] * sizeof(T), origin[1], origin[2]}};
+	}
+	
+	static std::array<size_t, 3> get_byte_region(const std::array<size_t, 3>& region) {
+		return {{region[0] * sizeof(T), region[1], region[2]}};
 	}
 	
 private:
 	size_t width_ = 0;
 	size_t height_ = 0;
 	size_t depth_ = 0;
+	cl_mem_flags flags_ = 0;
 	
 };
 
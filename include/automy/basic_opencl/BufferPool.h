@@ -0,0 +1,136 @@
+/*
+ * BufferPool.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#ifndef INCLUDE_AUTOMY_BASIC_OPENCL_BUFFERPOOL_H_
+#define INCLUDE_AUTOMY_BASIC_OPENCL_BUFFERPOOL_H_
+
+#include <automy/basic_opencl/Context.h>
+#include <automy/basic_opencl/Event.h>
+
+#include <map>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+
+namespace automy {
+namespace basic_opencl {
+
+/*
+ * Caches device memory of a context in size class buckets, so that buffers
+ * which are resized or destroyed return their storage to the pool instead of the driver.
+ * Small allocations can optionally be carved out of larger slabs via clCreateSubBuffer().
+ *
+ * Storage freed without an event is reused right away, which is only safe if all commands using it
+ * were enqueued to one in-order queue (later commands then run after the old ones). Otherwise pass
+ * an event for the last command using the storage, see Buffer::release_after().
+ */
+class BufferPool {
+public:
+	struct stats_t {
+		size_t bytes_live = 0;			// handed out to buffers
+		size_t bytes_cached = 0;		// free, waiting for reuse
+		size_t bytes_pending = 0;		// freed, waiting for an event before reuse
+		size_t num_hits = 0;
+		size_t num_misses = 0;
+		double hit_rate() const {
+			return num_hits + num_misses ? num_hits / double(num_hits + num_misses) : 0;
+		}
+	};
+
+	BufferPool(cl_context context, cl_mem_flags flags = 0);
+
+	~BufferPool();
+
+	BufferPool(const BufferPool&) = delete;
+	BufferPool& operator=(const BufferPool&) = delete;
+
+	static std::shared_ptr<BufferPool> create(cl_context context, cl_mem_flags flags = 0);
+
+	/*
+	 * Enables slab sub-allocation for requests up to max_chunk_size bytes,
+	 * chunks are rounded up to the base address alignment of all devices in the context.
+	 * Needs to be called before the first alloc().
+	 */
+	void enable_slabs(size_t max_chunk_size = 64 * 1024, size_t slab_size = 4 * 1024 * 1024);
+
+	/*
+	 * Returns a buffer of at least num_bytes, capacity is set to the actual size.
+	 */
+	cl_mem alloc(size_t num_bytes, size_t& capacity);
+
+	void free(cl_mem data, size_t capacity);
+
+	/*
+	 * Same as free(), but the storage is not handed out again before event has completed.
+	 */
+	void free(cl_mem data, size_t capacity, const Event& event);
+
+	/*
+	 * Releases cached storage until at most max_cached_bytes remain.
+	 */
+	void trim(size_t max_cached_bytes = 0);
+
+	size_t get_size_class(size_t num_bytes) const;
+
+	stats_t get_stats() const;
+
+	cl_context get_context() const {
+		return context;
+	}
+
+	cl_mem_flags get_flags() const {
+		return flags;
+	}
+
+private:
+	struct slab_t {
+		size_t chunk_size = 0;
+		size_t num_free = 0;
+		std::vector<cl_mem> chunks;
+	};
+
+	cl_mem create_buffer(size_t num_bytes);
+
+	void create_slab(size_t chunk_size);
+
+	void release_slab(cl_mem parent);
+
+	void trim_locked(size_t max_cached_bytes);
+
+	void collect_pending_locked();
+
+	void free_locked(cl_mem data, size_t capacity);
+
+private:
+	cl_context context;
+	cl_mem_flags flags = 0;
+
+	size_t slab_size = 0;
+	size_t slab_max_chunk = 0;
+	size_t slab_alignment = 0;
+
+	mutable std::mutex mutex;
+	stats_t stats;
+	std::map<size_t, std::vector<cl_mem>> free_list;
+	std::map<cl_mem, cl_mem> chunk_map;				// [chunk => slab]
+	std::map<cl_mem, slab_t> slab_map;
+
+	struct pending_t {
+		cl_mem data = nullptr;
+		size_t capacity = 0;
+		Event event;
+	};
+	std::vector<pending_t> pending;
+
+};
+
+
+} // basic_opencl
+} // automy
+
+#endif /* INCLUDE_AUTOMY_BASIC_OPENCL_BUFFERPOOL_H_ */
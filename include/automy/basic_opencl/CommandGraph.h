@@ -0,0 +1,171 @@
+/*
+ * CommandGraph.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#ifndef INCLUDE_AUTOMY_BASIC_OPENCL_COMMANDGRAPH_H_
+#define INCLUDE_AUTOMY_BASIC_OPENCL_COMMANDGRAPH_H_
+
+#include <automy/basic_opencl/Kernel.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <type_traits>
+
+
+namespace automy {
+namespace basic_opencl {
+
+/*
+ * Records a fixed sequence of kernel launches and buffer operations once, to be replayed every frame.
+ *
+ * Kernel arguments are captured when a launch is added, later changes to the Kernel do not affect the graph,
+ * use set_arg() to patch them instead. Buffers and images are captured by handle and need to outlive the graph.
+ *
+ * On devices with cl_khr_command_buffer the graph is submitted as a single command buffer,
+ * otherwise (and on profiling queues) the commands are enqueued one by one, skipping redundant clSetKernelArg().
+ * Two command buffers are used alternately, so a replay does not have to wait for the previous one,
+ * unless the device supports simultaneous use. Patched arguments are updated in place via
+ * cl_khr_command_buffer_mutable_dispatch if available, otherwise the command buffer is re-recorded.
+ * Commands execute in order, also on out-of-order queues.
+ */
+class CommandGraph {
+public:
+	typedef size_t node_t;
+
+	CommandGraph();
+
+	~CommandGraph();
+
+	CommandGraph(const CommandGraph&) = delete;
+	CommandGraph& operator=(const CommandGraph&) = delete;
+
+	static std::shared_ptr<CommandGraph> create();
+
+	/*
+	 * Records a launch with the current arguments of kernel, global_size is ceiled to local_size.
+	 * A local_size of zero lets the driver choose.
+	 */
+	node_t add_kernel(std::shared_ptr<Kernel> kernel, const size_t& global_size, const size_t& local_size = 0);
+
+	node_t add_kernel_2D(	std::shared_ptr<Kernel> kernel, const std::array<size_t, 2>& global_size,
+							const std::array<size_t, 2>& local_size = std::array<size_t, 2>());
+
+	node_t add_kernel_3D(	std::shared_ptr<Kernel> kernel, const std::array<size_t, 3>& global_size,
+							const std::array<size_t, 3>& local_size = std::array<size_t, 3>());
+
+	node_t add_copy(const Buffer& src, const Buffer& dst, size_t num_bytes, size_t src_offset = 0, size_t dst_offset = 0);
+
+	node_t add_fill(const Buffer& dst, const void* pattern, size_t pattern_size, size_t num_bytes, size_t offset = 0);
+
+	template<typename T>
+	node_t add_fill(const Buffer& dst, const T& value, size_t count, size_t offset = 0) {
+		return add_fill(dst, &value, sizeof(T), count * sizeof(T), offset * sizeof(T));
+	}
+
+	/*
+	 * Patches an argument of a recorded launch.
+	 */
+	void set_arg(node_t node, const cl_uint arg, const Buffer& value) { set_mem(node, arg, value.data()); }
+	void set_arg(node_t node, const cl_uint arg, const Image& value) { set_mem(node, arg, value.data()); }
+
+	template<typename T, typename = typename std::enable_if<std::is_trivially_copyable<T>::value && !std::is_pointer<T>::value>::type>
+	void set_arg(node_t node, const cl_uint arg, const T& value) { set_arg_bytes(node, arg, sizeof(T), &value); }
+
+	void set_arg(node_t node, const std::string& arg, const Buffer& value) { set_arg(node, get_kernel(node)->get_arg(arg).index, value); }
+	void set_arg(node_t node, const std::string& arg, const Image& value) { set_arg(node, get_kernel(node)->get_arg(arg).index, value); }
+
+	template<typename T, typename = typename std::enable_if<std::is_trivially_copyable<T>::value && !std::is_pointer<T>::value>::type>
+	void set_arg(node_t node, const std::string& arg, const T& value) { set_arg(node, get_kernel(node)->get_arg(arg).index, value); }
+
+	std::shared_ptr<Kernel> get_kernel(node_t node) const;
+
+	size_t size() const {
+		return nodes.size();
+	}
+
+	/*
+	 * Removes all commands.
+	 */
+	void clear();
+
+	/*
+	 * Enqueues all commands, the first waits for wait_list. Returns an event for the last command.
+	 */
+	Event replay(std::shared_ptr<CommandQueue> queue, const std::vector<Event>& wait_list = std::vector<Event>());
+
+	/*
+	 * Whether the last replay() used a native command buffer.
+	 */
+	bool is_native() const {
+		return last_native;
+	}
+
+private:
+	enum node_type_e {
+		NODE_KERNEL,
+		NODE_COPY,
+		NODE_FILL,
+	};
+
+	struct node_info_t {
+		node_type_e type = NODE_KERNEL;
+		std::shared_ptr<Kernel> kernel;
+		std::vector<Kernel::arg_value_t> args;
+		cl_uint dims = 0;
+		size_t global_size[3] = {};
+		size_t local_size[3] = {};
+		bool have_local = false;
+		cl_mem src = nullptr;
+		cl_mem dst = nullptr;
+		size_t src_offset = 0;
+		size_t dst_offset = 0;
+		size_t num_bytes = 0;
+		std::vector<char> pattern;
+		uint64_t version = 0;			// args_version of the last set_arg() change
+	};
+
+	struct native_t;
+	struct native_slot_t;
+
+	node_t add_kernel_nd(std::shared_ptr<Kernel> kernel, const cl_uint dims, const size_t* global_size, const size_t* local_size);
+
+	void set_arg_bytes(node_t node, const cl_uint arg, const size_t size, const void* value);
+
+	void set_mem(node_t node, const cl_uint arg, const cl_mem& value) {
+		set_arg_bytes(node, arg, sizeof(cl_mem), &value);
+	}
+
+	void enqueue_node(std::shared_ptr<CommandQueue> queue, node_info_t& node, const EventList* wait_list, cl_event* event);
+
+	Event replay_loop(std::shared_ptr<CommandQueue> queue, const std::vector<Event>& wait_list);
+
+	bool replay_native(std::shared_ptr<CommandQueue> queue, const std::vector<Event>& wait_list, Event& event);
+
+	bool update_native(native_slot_t& slot);
+
+	bool patch_native(native_slot_t& slot);
+
+	bool record_native(native_slot_t& slot);
+
+	void release_native();
+
+private:
+	std::vector<node_info_t> nodes;
+
+	std::shared_ptr<native_t> native;
+	bool native_valid = false;
+	bool last_native = false;
+	uint64_t args_version = 0;
+
+};
+
+
+} // basic_opencl
+} // automy
+
+#endif /* INCLUDE_AUTOMY_BASIC_OPENCL_COMMANDGRAPH_H_ */
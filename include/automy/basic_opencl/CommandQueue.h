@@ -9,8 +9,11 @@
 #define INCLUDE_AUTOMY_BASIC_OPENCL_COMMANDQUEUE_H_
 
 #include <automy/basic_opencl/OpenCL.h>
+#include <automy/basic_opencl/Event.h>
+#include <automy/basic_opencl/Profiler.h>
 
 #include <stdexcept>
+#include <vector>
 #include <memory>
 
 
@@ -19,7 +22,20 @@ namespace basic_opencl {
 
 class CommandQueue {
 public:
-	CommandQueue(cl_command_queue queue_) : queue(queue_) {}
+	CommandQueue(cl_command_queue queue_) : queue(queue_) {
+		if(cl_int err = clGetCommandQueueInfo(queue, CL_QUEUE_PROPERTIES, sizeof(properties), &properties, 0)) {
+			throw opencl_error_t("clGetCommandQueueInfo(CL_QUEUE_PROPERTIES) failed with " + get_error_string(err));
+		}
+		if(cl_int err = clGetCommandQueueInfo(queue, CL_QUEUE_DEVICE, sizeof(device), &device, 0)) {
+			throw opencl_error_t("clGetCommandQueueInfo(CL_QUEUE_DEVICE) failed with " + get_error_string(err));
+		}
+		if(cl_int err = clGetCommandQueueInfo(queue, CL_QUEUE_CONTEXT, sizeof(context), &context, 0)) {
+			throw opencl_error_t("clGetCommandQueueInfo(CL_QUEUE_CONTEXT) failed with " + get_error_string(err));
+		}
+		if(properties & CL_QUEUE_PROFILING_ENABLE) {
+			profiler = Profiler::create();
+		}
+	}
 	
 	~CommandQueue() {
 		clReleaseCommandQueue(queue);
@@ -36,6 +52,92 @@ public:
 		return queue;
 	}
 	
+	cl_device_id get_device() const {
+		return device;
+	}
+	
+	cl_context get_context() const {
+		return context;
+	}
+	
+	cl_command_queue_properties get_properties() const {
+		return properties;
+	}
+	
+	/*
+	 * Commands of an out-of-order queue only depend on their wait list and on barriers,
+	 * use the Event returning enqueue overloads to chain them.
+	 */
+	bool is_out_of_order() const {
+		return properties & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE;
+	}
+	
+	/*
+	 * Returns nullptr unless created with CL_QUEUE_PROFILING_ENABLE.
+	 */
+	std::shared_ptr<Profiler> get_profiler() const {
+		return profiler;
+	}
+	
+	/*
+	 * Returns where to store the event of the next command, nullptr if nobody needs it.
+	 */
+	cl_event* get_event(Event& event) const {
+		return profiler ? event.reset() : nullptr;
+	}
+	
+	void record(const Event& event, const std::string& name, Profiler::command_e type = Profiler::KERNEL, size_t num_bytes = 0) {
+		if(profiler) {
+			profiler->add(name, type, event, num_bytes);
+		}
+	}
+	
+	void record(const Event& event, Profiler::command_e type, size_t num_bytes) {
+		if(profiler) {
+			profiler->add(Profiler::get_type_name(type), type, event, num_bytes);
+		}
+	}
+	
+	/*
+	 * Returns an event which completes once all events in wait_list, or all previous commands if empty, have completed.
+	 * Use it to make commands on other queues depend on this queue.
+	 */
+	Event enqueue_marker(const std::vector<Event>& wait_list = std::vector<Event>()) {
+		const EventList list(wait_list);
+		Event event;
+		if(cl_int err = clEnqueueMarkerWithWaitList(queue, list.size(), list.data(), event.reset())) {
+			throw opencl_error_t("clEnqueueMarkerWithWaitList() failed with " + get_error_string(err));
+		}
+		return event;
+	}
+	
+	/*
+	 * All following commands wait for the events in wait_list, or for all previous commands if empty.
+	 * Events can be from other queues of the same context.
+	 */
+	void enqueue_barrier(const std::vector<Event>& wait_list = std::vector<Event>()) {
+		const EventList list(wait_list);
+		if(cl_int err = clEnqueueBarrierWithWaitList(queue, list.size(), list.data(), nullptr)) {
+			throw opencl_error_t("clEnqueueBarrierWithWaitList() failed with " + get_error_string(err));
+		}
+	}
+	
+	/*
+	 * Moves memory objects to the device of this queue ahead of use, for example sub-buffers to the NUMA node
+	 * of a sub-device. Pass CL_MIGRATE_MEM_OBJECT_CONTENT_UNDEFINED for outputs.
+	 */
+	Event enqueue_migrate(	const std::vector<cl_mem>& objects, cl_mem_migration_flags flags = 0,
+							const std::vector<Event>& wait_list = std::vector<Event>()) {
+		const EventList list(wait_list);
+		Event event;
+		if(!objects.empty()) {
+			if(cl_int err = clEnqueueMigrateMemObjects(queue, objects.size(), objects.data(), flags, list.size(), list.data(), event.reset())) {
+				throw opencl_error_t("clEnqueueMigrateMemObjects() failed with " + get_error_string(err));
+			}
+		}
+		return event;
+	}
+	
 	void flush() {
 		if(clFlush(queue)) {
 			throw opencl_error_t("clFlush() failed");
@@ -50,6 +152,10 @@ public:
 	
 private:
 	cl_command_queue queue;
+	cl_device_id device = nullptr;
+	cl_context context = nullptr;
+	cl_command_queue_properties properties = 0;
+	std::shared_ptr<Profiler> profiler;
 	
 };
 
@@ -0,0 +1,83 @@
+/*
+ * Compaction.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#ifndef INCLUDE_AUTOMY_BASIC_OPENCL_COMPACTION_H_
+#define INCLUDE_AUTOMY_BASIC_OPENCL_COMPACTION_H_
+
+#include <automy/basic_opencl/Scan.h>
+
+
+namespace automy {
+namespace basic_opencl {
+
+/*
+ * Stable copy_if() on the device, using kernel/compact.cl and a Scan of the predicate flags.
+ * The output keeps the input order, no atomics are involved. Not thread-safe.
+ * Scratch memory is allocated per call from Scan::get_scratch_pool(), commands are chained via events.
+ *
+ * Example: Compaction(scan, "float4", "x.z > 0")
+ */
+class Compaction {
+public:
+	/*
+	 * type_name is the OpenCL type of the elements, predicate an OpenCL expression of x.
+	 */
+	Compaction(std::shared_ptr<Scan> scan, const std::string& kernel_path, const std::string& type_name, const std::string& predicate);
+
+	Compaction(const Compaction&) = delete;
+	Compaction& operator=(const Compaction&) = delete;
+
+	static std::shared_ptr<Compaction> create(	std::shared_ptr<Scan> scan, const std::string& kernel_path,
+												const std::string& type_name, const std::string& predicate);
+
+	/*
+	 * Copies all elements for which the predicate is true to out, which is resized if needed.
+	 * The number of elements copied is written to count[0], returns the event of that write.
+	 * The first command waits for wait_list.
+	 * Throws std::logic_error if sizeof(T) differs from the size of type_name on the device.
+	 */
+	template<typename T>
+	Event copy_if(	std::shared_ptr<CommandQueue> queue, const Buffer1D<T>& in, Buffer1D<T>& out, Buffer1D<cl_uint>& count,
+					const std::vector<Event>& wait_list = std::vector<Event>()) {
+		out.alloc_min(scan->get_context(), in.size());
+		count.alloc_min(scan->get_context(), 1);
+		return compact(queue, in, out, count, in.size(), sizeof(T), wait_list);
+	}
+
+	/*
+	 * Same as above, but returns the number of elements copied.
+	 * Waits for the compaction to finish, but not for the rest of the queue.
+	 */
+	template<typename T>
+	size_t copy_if(std::shared_ptr<CommandQueue> queue, const Buffer1D<T>& in, Buffer1D<T>& out) {
+		Buffer1D<cl_uint> count(scan->get_scratch_pool(), 1);
+		const auto event = copy_if(queue, in, out, count);
+		cl_uint res = 0;
+		const std::vector<Event> wait_list = {event};
+		count.download(queue, &res, wait_list).wait();
+		return res;
+	}
+
+private:
+	Event compact(	std::shared_ptr<CommandQueue> queue, const Buffer& in, Buffer& out, Buffer1D<cl_uint>& count,
+					size_t num, size_t type_size, const std::vector<Event>& wait_list);
+
+private:
+	std::shared_ptr<Scan> scan;
+	std::shared_ptr<Program> program;
+	std::shared_ptr<Kernel> flags_kernel;
+	std::shared_ptr<Kernel> scatter_kernel;
+	size_t local_size = 1;
+	size_t type_size = 0;		// of type_name on the device, queried on first use
+
+};
+
+
+} // basic_opencl
+} // automy
+
+#endif /* INCLUDE_AUTOMY_BASIC_OPENCL_COMPACTION_H_ */
@@ -11,19 +11,29 @@
 #include <automy/basic_opencl/OpenCL.h>
 #include <automy/basic_opencl/CommandQueue.h>
 
+#include <map>
 #include <vector>
 #include <string>
 #include <memory>
 #include <mutex>
+#include <future>
 
 
 namespace automy {
 namespace basic_opencl {
 
+class Kernel;
+class Program;
+class BufferPool;
+class BinaryCache;
+class WorkGroupTuner;
+
 std::vector<cl_platform_id> get_platforms();
 
 std::string get_platform_name(cl_platform_id platform);
 
+std::string get_platform_version(cl_platform_id platform);
+
 cl_platform_id find_platform_by_name(const std::string& name);
 
 cl_context create_context(cl_platform_id platform, const std::vector<cl_device_id>& devices);
@@ -34,13 +44,158 @@ std::vector<cl_device_id> get_devices(cl_platform_id platform, cl_device_type de
 
 cl_device_id get_device(cl_platform_id platform, cl_device_type device_type, cl_uint device);
 
+/*
+ * Device queries below are answered from the DeviceInfo cache.
+ */
 std::string get_device_name(cl_device_id device_id);
 
-std::shared_ptr<CommandQueue> create_command_queue(cl_context context, cl_device_id device);
+std::string get_device_version(cl_device_id device_id);
+
+std::string get_driver_version(cl_device_id device_id);
+
+/*
+ * Space separated list of CL_DEVICE_EXTENSIONS.
+ */
+std::string get_device_extensions(cl_device_id device_id);
+
+bool has_device_extension(cl_device_id device_id, const std::string& extension);
+
+cl_platform_id get_device_platform(cl_device_id device_id);
+
+/*
+ * Partitions a device (clCreateSubDevices), mainly for CPU devices spanning several sockets.
+ * Sub-devices are used like devices, ie. create a context, queues and programs for them,
+ * see MultiDevice for splitting work across them. Release them with release_devices().
+ */
+std::vector<cl_device_id> create_sub_devices_equally(cl_device_id device_id, cl_uint compute_units);
+
+std::vector<cl_device_id> create_sub_devices_by_counts(cl_device_id device_id, const std::vector<cl_uint>& compute_units);
+
+/*
+ * Splits along the given domain, for example one sub-device per NUMA node.
+ */
+std::vector<cl_device_id> create_sub_devices_by_affinity(	cl_device_id device_id,
+															cl_device_affinity_domain domain = CL_DEVICE_AFFINITY_DOMAIN_NUMA);
+
+/*
+ * Returns nullptr for root devices.
+ */
+cl_device_id get_parent_device(cl_device_id device_id);
+
+void release_devices(std::vector<cl_device_id>& devices);
+
+/*
+ * CL_DEVICE_QUEUE_PROPERTIES, ie. which queue properties the device supports.
+ */
+cl_command_queue_properties get_device_queue_properties(cl_device_id device_id);
+
+/*
+ * Pass CL_QUEUE_PROFILING_ENABLE to collect timing of all commands, see CommandQueue::get_profiler().
+ * CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE is dropped if the device does not support it, commands then run in submission
+ * order. This honors all wait lists, but a command waiting on a user event also blocks every later command.
+ * Check CommandQueue::is_out_of_order() to see what was created.
+ */
+std::shared_ptr<CommandQueue> create_command_queue(cl_context context, cl_device_id device, cl_command_queue_properties properties = 0);
 
 std::string get_error_string(cl_int error);
 
 
+/*
+ * Owns a cl_context together with resources shared by everything using it:
+ * one default queue per device, a buffer pool and a cache of built programs.
+ *
+ * Teardown happens in a fixed order: queues are finished, then programs, the pool and the queues
+ * are released before the context itself. Resources still referenced elsewhere stay valid,
+ * since OpenCL objects retain their context.
+ */
+class Context {
+public:
+	std::shared_ptr<BinaryCache> binary_cache;		// optional, used by get_program()
+
+	std::shared_ptr<WorkGroupTuner> tuner;			// optional, used by get_program()
+
+	std::vector<std::string> include_paths;			// searched for sources and #include files by get_program()
+
+	Context(cl_platform_id platform, const std::vector<cl_device_id>& devices, cl_command_queue_properties queue_properties = 0);
+
+	~Context();
+
+	Context(const Context&) = delete;
+	Context& operator=(const Context&) = delete;
+
+	static std::shared_ptr<Context> create(	cl_platform_id platform, const std::vector<cl_device_id>& devices,
+											cl_command_queue_properties queue_properties = 0);
+
+	cl_context get() const {
+		return context;
+	}
+
+	cl_platform_id get_platform() const {
+		return platform;
+	}
+
+	const std::vector<cl_device_id>& get_devices() const {
+		return devices;
+	}
+
+	/*
+	 * Default queue of the given device.
+	 */
+	std::shared_ptr<CommandQueue> get_queue(size_t device = 0) const {
+		return queues.at(device);
+	}
+
+	/*
+	 * Shared pool for Buffer1D / Buffer3D, created on first use.
+	 */
+	std::shared_ptr<BufferPool> get_buffer_pool();
+
+	/*
+	 * Returns the program built for all devices from the given source files and options,
+	 * which is built on first use and then shared. Throws std::runtime_error with the build log on failure.
+	 */
+	std::shared_ptr<Program> get_program(const std::vector<std::string>& files, const std::string& options = std::string());
+
+	/*
+	 * Same as get_program(), but builds on a worker thread and returns immediately, so that many programs
+	 * can be built concurrently at startup (see Program::build_shared()). A failed build rethrows on get(), also for later calls.
+	 * See Program::get_build_time() for the time each build took.
+	 */
+	std::shared_future<std::shared_ptr<Program>> get_program_async(	const std::vector<std::string>& files,
+																	const std::string& options = std::string());
+
+	/*
+	 * Waits for all programs started with get_program_async(), without throwing on build failures.
+	 */
+	void wait_programs();
+
+	/*
+	 * Creates a new kernel from the shared program, kernels are not shared since they hold argument state.
+	 */
+	std::shared_ptr<Kernel> create_kernel(	const std::vector<std::string>& files, const std::string& name,
+											const std::string& options = std::string());
+
+	/*
+	 * Finishes all default queues.
+	 */
+	void finish();
+
+private:
+	std::shared_future<std::shared_ptr<Program>> get_program_future(const std::vector<std::string>& files, const std::string& options, bool async);
+
+private:
+	cl_context context = nullptr;
+	cl_platform_id platform = nullptr;
+	std::vector<cl_device_id> devices;
+	std::vector<std::shared_ptr<CommandQueue>> queues;
+
+	std::mutex mutex;
+	std::shared_ptr<BufferPool> buffer_pool;
+	std::map<std::string, std::shared_future<std::shared_ptr<Program>>> programs;
+
+};
+
+
 } // basic_opencl
 } // automy
 
@@ -0,0 +1,106 @@
+/*
+ * DeviceInfo.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#ifndef INCLUDE_AUTOMY_BASIC_OPENCL_DEVICEINFO_H_
+#define INCLUDE_AUTOMY_BASIC_OPENCL_DEVICEINFO_H_
+
+#include <automy/basic_opencl/OpenCL.h>
+
+#include <set>
+#include <array>
+#include <vector>
+#include <string>
+#include <memory>
+
+
+namespace automy {
+namespace basic_opencl {
+
+/*
+ * Device capabilities, queried once per device and cached, see get().
+ */
+struct DeviceInfo {
+	cl_device_id device = nullptr;
+	cl_platform_id platform = nullptr;
+	cl_device_type type = 0;
+
+	std::string name;
+	std::string vendor;
+	std::string version;
+	std::string driver_version;
+	std::string opencl_c_version;
+	std::string platform_version;
+	std::set<std::string> extensions;
+
+	int cl_version = 0;						// 10 * major + minor of version, eg. 21 for "OpenCL 2.1", 0 if unknown
+	int cl_c_version = 0;					// same for opencl_c_version
+	int cl_platform_version = 0;			// same for platform_version
+
+	cl_uint compute_units = 0;
+	cl_uint max_clock_mhz = 0;
+	size_t max_work_group_size = 0;
+	std::array<size_t, 3> max_work_item_sizes = {{0, 0, 0}};
+
+	cl_ulong global_mem_size = 0;
+	cl_ulong max_alloc_size = 0;
+	cl_ulong global_cache_size = 0;
+	cl_uint global_cache_line = 0;			// [bytes]
+	cl_uint mem_base_align = 0;				// [bytes]
+	cl_ulong local_mem_size = 0;
+	bool local_mem_dedicated = false;		// CL_LOCAL, otherwise emulated in global memory
+
+	bool image_support = false;
+	bool unified_memory = false;			// CL_DEVICE_HOST_UNIFIED_MEMORY, or a CPU device
+	cl_command_queue_properties queue_properties = 0;
+	cl_bitfield float_atomic_caps = 0;		// CL_DEVICE_SINGLE_FP_ATOMIC_CAPABILITIES_EXT
+
+	struct vector_width_t {
+		cl_uint char_ = 0;
+		cl_uint short_ = 0;
+		cl_uint int_ = 0;
+		cl_uint long_ = 0;
+		cl_uint half_ = 0;
+		cl_uint float_ = 0;
+		cl_uint double_ = 0;
+	} preferred_vector_width;
+
+	/*
+	 * Supported sub-group (warp / wavefront) sizes, empty if unknown.
+	 */
+	std::vector<size_t> subgroup_sizes;
+
+	bool has_extension(const std::string& extension) const {
+		return extensions.count(extension);
+	}
+
+	bool is_cpu() const {
+		return type & CL_DEVICE_TYPE_CPU;
+	}
+
+	bool is_gpu() const {
+		return type & CL_DEVICE_TYPE_GPU;
+	}
+
+	/*
+	 * Returns the cached info for device, queries it on first use. Thread-safe.
+	 */
+	static std::shared_ptr<const DeviceInfo> get(cl_device_id device);
+
+	/*
+	 * Drops the cached info, for example before a sub-device is released.
+	 */
+	static void remove(cl_device_id device);
+
+	static void clear();
+
+};
+
+
+} // basic_opencl
+} // automy
+
+#endif /* INCLUDE_AUTOMY_BASIC_OPENCL_DEVICEINFO_H_ */
@@ -0,0 +1,199 @@
+/*
+ * Event.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#ifndef INCLUDE_AUTOMY_BASIC_OPENCL_EVENT_H_
+#define INCLUDE_AUTOMY_BASIC_OPENCL_EVENT_H_
+
+#include <automy/basic_opencl/OpenCL.h>
+
+#include <vector>
+#include <string>
+#include <functional>
+
+
+namespace automy {
+namespace basic_opencl {
+
+std::string get_error_string(cl_int error);
+
+/*
+ * Reference counted cl_event handle, copies retain the event.
+ */
+class Event {
+public:
+	Event() {}
+
+	/*
+	 * Takes ownership of event, unless retain == true.
+	 */
+	explicit Event(cl_event event_, bool retain = false)
+		:	event(event_)
+	{
+		if(event && retain) {
+			clRetainEvent(event);
+		}
+	}
+
+	Event(const Event& other)
+		:	event(other.event)
+	{
+		if(event) {
+			clRetainEvent(event);
+		}
+	}
+
+	Event(Event&& other)
+		:	event(other.event)
+	{
+		other.event = nullptr;
+	}
+
+	~Event() {
+		release();
+	}
+
+	Event& operator=(const Event& other) {
+		if(other.event) {
+			clRetainEvent(other.event);
+		}
+		release();
+		event = other.event;
+		return *this;
+	}
+
+	Event& operator=(Event&& other) {
+		if(this != &other) {
+			release();
+			event = other.event;
+			other.event = nullptr;
+		}
+		return *this;
+	}
+
+	cl_event get() const {
+		return event;
+	}
+
+	bool is_valid() const {
+		return event;
+	}
+
+	/*
+	 * Releases the current event and returns a pointer to be filled by an enqueue function.
+	 */
+	cl_event* reset() {
+		release();
+		return &event;
+	}
+
+	void wait() const {
+		if(event) {
+			if(cl_int err = clWaitForEvents(1, &event)) {
+				throw opencl_error_t("clWaitForEvents() failed with " + get_error_string(err));
+			}
+		}
+	}
+
+	/*
+	 * Returns CL_QUEUED, CL_SUBMITTED, CL_RUNNING, CL_COMPLETE or a negative error code.
+	 */
+	cl_int get_status() const {
+		cl_int status = CL_COMPLETE;
+		if(event) {
+			if(cl_int err = clGetEventInfo(event, CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof(status), &status, 0)) {
+				throw opencl_error_t("clGetEventInfo(CL_EVENT_COMMAND_EXECUTION_STATUS) failed with " + get_error_string(err));
+			}
+		}
+		return status;
+	}
+
+	bool is_complete() const {
+		return get_status() <= CL_COMPLETE;
+	}
+
+	/*
+	 * Callback is called from a driver thread with the execution status once the event reaches status.
+	 */
+	void set_callback(const std::function<void(cl_int)>& callback, cl_int status = CL_COMPLETE) {
+		if(!event) {
+			throw std::logic_error("event == nullptr");
+		}
+		auto* func = new std::function<void(cl_int)>(callback);
+		if(cl_int err = clSetEventCallback(event, status, &Event::callback_func, func)) {
+			delete func;
+			throw opencl_error_t("clSetEventCallback() failed with " + get_error_string(err));
+		}
+	}
+
+	static void wait(const std::vector<Event>& events);
+
+private:
+	void release() {
+		if(event) {
+			clReleaseEvent(event);
+			event = nullptr;
+		}
+	}
+
+	static void CL_CALLBACK callback_func(cl_event, cl_int status, void* user_data) {
+		auto* func = (std::function<void(cl_int)>*)user_data;
+		try {
+			(*func)(status);
+		} catch(...) {
+			// nowhere to report to in a driver thread
+		}
+		delete func;
+	}
+
+private:
+	cl_event event = nullptr;
+
+};
+
+
+/*
+ * Converts a list of events into a wait list for clEnqueue*() functions.
+ */
+class EventList {
+public:
+	EventList(const std::vector<Event>& events) {
+		for(const auto& event : events) {
+			if(event.is_valid()) {
+				list.push_back(event.get());
+			}
+		}
+	}
+
+	cl_uint size() const {
+		return list.size();
+	}
+
+	const cl_event* data() const {
+		return list.empty() ? nullptr : list.data();
+	}
+
+private:
+	std::vector<cl_event> list;
+
+};
+
+
+inline void Event::wait(const std::vector<Event>& events)
+{
+	const EventList list(events);
+	if(list.size()) {
+		if(cl_int err = clWaitForEvents(list.size(), list.data())) {
+			throw opencl_error_t("clWaitForEvents() failed with " + get_error_string(err));
+		}
+	}
+}
+
+
+} // basic_opencl
+} // automy
+
+#endif /* INCLUDE_AUTOMY_BASIC_OPENCL_EVENT_H_ */
@@ -0,0 +1,121 @@
+/*
+ * Histogram.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#ifndef INCLUDE_AUTOMY_BASIC_OPENCL_HISTOGRAM_H_
+#define INCLUDE_AUTOMY_BASIC_OPENCL_HISTOGRAM_H_
+
+#include <automy/basic_opencl/Program.h>
+#include <automy/basic_opencl/Buffer1D.h>
+#include <automy/basic_opencl/Buffer3D.h>
+
+#include <map>
+#include <array>
+#include <mutex>
+#include <string>
+#include <memory>
+
+
+namespace automy {
+namespace basic_opencl {
+
+/*
+ * 1D / 2D / 3D histograms and voxel grids, using kernel/histogram.cl.
+ * Points are cl_float4 with xyz as coordinates and w as value, the grid size is given by the output Buffer3D.
+ * Grids which fit into local memory are accumulated per work group first, to avoid global atomic contention.
+ * The first command waits for wait_list, the returned event is that of the last one.
+ */
+class Histogram {
+public:
+	struct grid_t {
+		std::array<float, 3> origin = {{0, 0, 0}};
+		std::array<float, 3> bin_size = {{1, 1, 1}};		// axes with a grid size of 1 are ignored
+	};
+
+	std::shared_ptr<BinaryCache> binary_cache;		// optional
+
+	/*
+	 * kernel_path is the directory containing histogram.cl and atomics.cl
+	 */
+	Histogram(cl_context context, cl_device_id device, const std::string& kernel_path);
+
+	Histogram(const Histogram&) = delete;
+	Histogram& operator=(const Histogram&) = delete;
+
+	static std::shared_ptr<Histogram> create(cl_context context, cl_device_id device, const std::string& kernel_path);
+
+	/*
+	 * Number of points per bin. If clear == false the bins are added to.
+	 */
+	Event count(std::shared_ptr<CommandQueue> queue, const Buffer1D<cl_float4>& points, const grid_t& grid,
+				Buffer3D<cl_uint>& bins, bool clear = true, const std::vector<Event>& wait_list = std::vector<Event>());
+
+	/*
+	 * Sum of point values per bin.
+	 */
+	Event sum(	std::shared_ptr<CommandQueue> queue, const Buffer1D<cl_float4>& points, const grid_t& grid,
+				Buffer3D<cl_float>& bins, bool clear = true, const std::vector<Event>& wait_list = std::vector<Event>());
+
+	/*
+	 * Sum of point values per bin, values are rounded to int.
+	 */
+	Event sum(	std::shared_ptr<CommandQueue> queue, const Buffer1D<cl_float4>& points, const grid_t& grid,
+				Buffer3D<cl_int>& bins, bool clear = true, const std::vector<Event>& wait_list = std::vector<Event>());
+
+	/*
+	 * Mean of point values per bin, zero for empty bins.
+	 * The count grid is allocated per call and released once the kernels have finished.
+	 */
+	Event mean(	std::shared_ptr<CommandQueue> queue, const Buffer1D<cl_float4>& points, const grid_t& grid,
+				Buffer3D<cl_float>& bins, const std::vector<Event>& wait_list = std::vector<Event>());
+
+	/*
+	 * Same as above, count is resized to the size of bins and receives the number of points per bin.
+	 */
+	Event mean(	std::shared_ptr<CommandQueue> queue, const Buffer1D<cl_float4>& points, const grid_t& grid,
+				Buffer3D<cl_float>& bins, Buffer3D<cl_uint>& count, const std::vector<Event>& wait_list = std::vector<Event>());
+
+	/*
+	 * Whether a grid of num_bins bins of 4 bytes is accumulated in local memory.
+	 */
+	bool is_privatized(size_t num_bins) const {
+		return num_bins * 4 <= max_local_bytes;
+	}
+
+private:
+	struct kernels_t {
+		std::shared_ptr<Program> program;
+		std::shared_ptr<Kernel> global;
+		std::shared_ptr<Kernel> local;
+		std::shared_ptr<Kernel> mean_finish;
+		size_t local_size = 1;
+	};
+
+	kernels_t get_kernels(const std::string& mode);
+
+	Event accumulate(	std::shared_ptr<CommandQueue> queue, const std::string& mode, const Buffer1D<cl_float4>& points, const grid_t& grid,
+						Buffer& bins, size_t width, size_t height, size_t depth, const std::vector<Event>& wait_list);
+
+	Event mean_count(	std::shared_ptr<CommandQueue> queue, const Buffer1D<cl_float4>& points, const grid_t& grid,
+						Buffer3D<cl_float>& bins, Buffer3D<cl_uint>& count, const std::vector<Event>& wait_list);
+
+private:
+	cl_context context;
+	cl_device_id device;
+	std::string kernel_path;
+	size_t num_compute_units = 1;
+	size_t max_local_bytes = 0;
+
+	std::mutex mutex;
+	std::map<std::string, kernels_t> kernels;
+
+};
+
+
+} // basic_opencl
+} // automy
+
+#endif /* INCLUDE_AUTOMY_BASIC_OPENCL_HISTOGRAM_H_ */
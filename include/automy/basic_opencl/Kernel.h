@@ -11,21 +11,35 @@
 #include <automy/basic_opencl/Context.h>
 #include <automy/basic_opencl/Buffer.h>
 #include <automy/basic_opencl/Image.h>
+#include <automy/basic_opencl/WorkGroupTuner.h>
 
 #include <map>
 #include <string>
 #include <array>
 #include <vector>
 #include <ostream>
+#include <cstring>
+#include <type_traits>
 
 
 namespace automy {
 namespace basic_opencl {
 
+class CommandGraph;
+
 class Kernel {
 public:
+	std::shared_ptr<WorkGroupTuner> tuner;		// optional, see enqueue_ceiled() without local_size
+	
+	std::string build_options;					// set by Program, tuning results are kept per build options
+	
 	Kernel(cl_kernel kernel_, bool with_arg_map);
 	
+	/*
+	 * Wraps kernel_, which has to be of the same function as other, reusing its name and argument info.
+	 */
+	Kernel(cl_kernel kernel_, const Kernel& other);
+	
 	~Kernel();
 	
 	Kernel(const Kernel&) = delete;
@@ -33,28 +47,134 @@ public:
 	
 	static std::shared_ptr<Kernel> create(cl_kernel kernel, bool with_arg_map);
 	
+	/*
+	 * Returns an independent kernel object with its own argument state, for use in another thread.
+	 * Uses clCloneKernel() which also copies the arguments, if the platform and all devices of the program
+	 * report OpenCL 2.1 or later and the platform returns it from clGetExtensionFunctionAddressForPlatform().
+	 * Otherwise clCreateKernel(), with no arguments set.
+	 */
+	std::shared_ptr<Kernel> clone() const;
+	
+	cl_kernel get() const {
+		return kernel;
+	}
+	
+	const std::string& get_name() const {
+		return name;
+	}
+	
+	/*
+	 * Returns CL_KERNEL_WORK_GROUP_SIZE for the given device.
+	 */
+	size_t get_max_work_group_size(cl_device_id device) const;
+	
+	/*
+	 * Pre-resolved argument, avoids the name lookup on every set().
+	 */
+	struct arg_t {
+		cl_uint index = 0;
+	};
+	
+	/*
+	 * Size of local memory to allocate for a __local argument.
+	 */
+	struct local_t {
+		size_t num_bytes = 0;
+		local_t(size_t num_bytes) : num_bytes(num_bytes) {}
+	};
+	
+	enum arg_kind_e {
+		ARG_VALUE,
+		ARG_MEMORY,
+		ARG_LOCAL,
+	};
+	
+	/*
+	 * Argument as last set, bytes is empty for __local arguments.
+	 */
+	struct arg_value_t {
+		cl_uint index = 0;
+		arg_kind_e kind = ARG_VALUE;
+		size_t size = 0;
+		std::vector<char> bytes;
+	};
+	
+	/*
+	 * Enables vector types (cl_float4, cl_int2, ...) and POD structs as arguments.
+	 */
+	template<typename T>
+	using if_pod_t = typename std::enable_if<std::is_trivially_copyable<T>::value && !std::is_arithmetic<T>::value
+											&& !std::is_pointer<T>::value>::type;
+	
+	arg_t get_arg(const std::string& name) const;
+	
 	void set(const cl_uint arg, const cl_int& value) { set_arg(arg, value); }
 	void set(const cl_uint arg, const cl_long& value) { set_arg(arg, value); }
 	void set(const cl_uint arg, const cl_uint& value) { set_arg(arg, value); }
 	void set(const cl_uint arg, const cl_ulong& value) { set_arg(arg, value); }
 	void set(const cl_uint arg, const cl_float& value) { set_arg(arg, value); }
-	void set(const cl_uint arg, const Buffer& value) { set_arg(arg, value.data()); }
-	void set(const cl_uint arg, const Image& value) { set_arg(arg, value.data()); }
-	void set(const cl_uint arg, std::shared_ptr<const Buffer> value) { set_arg(arg, value->data()); }
-	void set(const cl_uint arg, std::shared_ptr<const Image> value) { set_arg(arg, value->data()); }
+	void set(const cl_uint arg, const Buffer& value) { set_mem(arg, value.data()); }
+	void set(const cl_uint arg, const Image& value) { set_mem(arg, value.data()); }
+	void set(const cl_uint arg, std::shared_ptr<const Buffer> value) { set_mem(arg, value->data()); }
+	void set(const cl_uint arg, std::shared_ptr<const Image> value) { set_mem(arg, value->data()); }
+	void set(const cl_uint arg, const local_t& value) { set_arg_bytes(arg, value.num_bytes, nullptr, ARG_LOCAL); }
+	
+	template<typename T, typename = if_pod_t<T>>
+	void set(const cl_uint arg, const T& value) { set_arg(arg, value); }
 
 	void set(const std::string& arg, const cl_int& value) { set_arg(arg, value); }
 	void set(const std::string& arg, const cl_long& value) { set_arg(arg, value); }
 	void set(const std::string& arg, const cl_uint& value) { set_arg(arg, value); }
 	void set(const std::string& arg, const cl_ulong& value) { set_arg(arg, value); }
 	void set(const std::string& arg, const cl_float& value) { set_arg(arg, value); }
-	void set(const std::string& arg, const Buffer& value) { set_arg(arg, value.data()); }
-	void set(const std::string& arg, const Image& value) { set_arg(arg, value.data()); }
-	void set(const std::string& arg, std::shared_ptr<const Buffer> value) { set_arg(arg, value->data()); }
-	void set(const std::string& arg, std::shared_ptr<const Image> value) { set_arg(arg, value->data()); }
+	void set(const std::string& arg, const Buffer& value) { set_mem(get_arg(arg).index, value.data()); }
+	void set(const std::string& arg, const Image& value) { set_mem(get_arg(arg).index, value.data()); }
+	void set(const std::string& arg, std::shared_ptr<const Buffer> value) { set_mem(get_arg(arg).index, value->data()); }
+	void set(const std::string& arg, std::shared_ptr<const Image> value) { set_mem(get_arg(arg).index, value->data()); }
+	void set(const std::string& arg, const local_t& value) { set_local(arg, value.num_bytes); }
+	
+	template<typename T, typename = if_pod_t<T>>
+	void set(const std::string& arg, const T& value) { set_arg(arg, value); }
+	
+	void set(const arg_t& arg, const cl_int& value) { set_arg(arg.index, value); }
+	void set(const arg_t& arg, const cl_long& value) { set_arg(arg.index, value); }
+	void set(const arg_t& arg, const cl_uint& value) { set_arg(arg.index, value); }
+	void set(const arg_t& arg, const cl_ulong& value) { set_arg(arg.index, value); }
+	void set(const arg_t& arg, const cl_float& value) { set_arg(arg.index, value); }
+	void set(const arg_t& arg, const Buffer& value) { set_mem(arg.index, value.data()); }
+	void set(const arg_t& arg, const Image& value) { set_mem(arg.index, value.data()); }
+	void set(const arg_t& arg, std::shared_ptr<const Buffer> value) { set_mem(arg.index, value->data()); }
+	void set(const arg_t& arg, std::shared_ptr<const Image> value) { set_mem(arg.index, value->data()); }
+	void set(const arg_t& arg, const local_t& value) { set_arg_bytes(arg.index, value.num_bytes, nullptr, ARG_LOCAL); }
+	
+	template<typename T, typename = if_pod_t<T>>
+	void set(const arg_t& arg, const T& value) { set_arg(arg.index, value); }
+	
+	/*
+	 * Sets arguments 0, 1, 2, ... in order.
+	 */
+	template<typename... Args>
+	void set_args(const Args&... args) {
+		set_args_at(0, args...);
+	}
 	
 	void set_local(const std::string& arg, const size_t& num_bytes);
 	
+	/*
+	 * Forgets the cached argument values, the next set() will call clSetKernelArg() again.
+	 */
+	void invalidate_args();
+	
+	/*
+	 * Returns all arguments as currently set, throws if any has not been set yet.
+	 */
+	std::vector<arg_value_t> get_arg_values() const;
+	
+	/*
+	 * Sets arguments as returned by get_arg_values().
+	 */
+	void set_arg_values(const std::vector<arg_value_t>& values);
+	
 	void enqueue(std::shared_ptr<CommandQueue> queue, const size_t& global_size);
 	void enqueue(std::shared_ptr<CommandQueue> queue, const size_t& global_size, const size_t& local_size);
 	void enqueue_ceiled(std::shared_ptr<CommandQueue> queue, const size_t& global_size, const size_t& local_size);
@@ -67,34 +187,140 @@ public:
 	void enqueue_3D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 3>& global_size, const std::array<size_t, 3>& local_size);
 	void enqueue_ceiled_3D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 3>& global_size, const std::array<size_t, 3>& local_size);
 	
+	/*
+	 * Asynchronous variants: wait for all events in wait_list before execution and return an event for the launch.
+	 */
+	Event enqueue(std::shared_ptr<CommandQueue> queue, const size_t& global_size, const std::vector<Event>& wait_list);
+	Event enqueue(std::shared_ptr<CommandQueue> queue, const size_t& global_size, const size_t& local_size, const std::vector<Event>& wait_list);
+	Event enqueue_ceiled(std::shared_ptr<CommandQueue> queue, const size_t& global_size, const size_t& local_size, const std::vector<Event>& wait_list);
+
+	Event enqueue_2D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 2>& global_size, const std::vector<Event>& wait_list);
+	Event enqueue_2D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 2>& global_size, const std::array<size_t, 2>& local_size, const std::vector<Event>& wait_list);
+	Event enqueue_ceiled_2D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 2>& global_size, const std::array<size_t, 2>& local_size, const std::vector<Event>& wait_list);
+
+	Event enqueue_3D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 3>& global_size, const std::vector<Event>& wait_list);
+	Event enqueue_3D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 3>& global_size, const std::array<size_t, 3>& local_size, const std::vector<Event>& wait_list);
+	Event enqueue_ceiled_3D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 3>& global_size, const std::array<size_t, 3>& local_size, const std::vector<Event>& wait_list);
+	
+	/*
+	 * Local size chosen by tuner, or by the driver if no tuner is set.
+	 * While tuning, launches block until the kernel has finished.
+	 */
+	void enqueue_ceiled(std::shared_ptr<CommandQueue> queue, const size_t& global_size);
+	void enqueue_ceiled_2D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 2>& global_size);
+	void enqueue_ceiled_3D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 3>& global_size);
+	
+	Event enqueue_ceiled(std::shared_ptr<CommandQueue> queue, const size_t& global_size, const std::vector<Event>& wait_list);
+	Event enqueue_ceiled_2D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 2>& global_size, const std::vector<Event>& wait_list);
+	Event enqueue_ceiled_3D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 3>& global_size, const std::vector<Event>& wait_list);
+	
+	/*
+	 * Launches the part [offset, offset + global_size) of a larger range, get_global_id() includes offset.
+	 * global_size is ceiled to local_size, a local_size of zero lets the driver choose.
+	 */
+	Event enqueue_range(std::shared_ptr<CommandQueue> queue, const size_t& offset, const size_t& global_size, const size_t& local_size, const std::vector<Event>& wait_list);
+	Event enqueue_range_2D(	std::shared_ptr<CommandQueue> queue, const std::array<size_t, 2>& offset, const std::array<size_t, 2>& global_size,
+							const std::array<size_t, 2>& local_size, const std::vector<Event>& wait_list);
+	
 	void print_info(std::ostream& out);
 	
 protected:
 	template<typename T>
 	void set_arg(const cl_uint arg, const T& value) {
-		if(clSetKernelArg(kernel, arg, sizeof(T), &value)) {
-			throw opencl_error_t("clSetKernelArg() failed for " + name + " : " + std::to_string(arg));
-		}
+		set_arg_bytes(arg, sizeof(T), &value, ARG_VALUE);
 	}
 
 	template<typename T>
 	void set_arg(const std::string& arg, const T& value) {
-		auto it = arg_map.find(arg);
-		if(it != arg_map.end()) {
-			if(clSetKernelArg(kernel, it->second, sizeof(T), &value)) {
-				throw opencl_error_t("clSetKernelArg() failed for " + name + " : " + arg);
+		set_arg_bytes(get_arg(arg).index, sizeof(T), &value, ARG_VALUE);
+	}
+	
+	void set_mem(const cl_uint arg, const cl_mem& value) {
+		set_arg_bytes(arg, sizeof(cl_mem), &value, ARG_MEMORY);
+	}
+	
+	/*
+	 * Skips clSetKernelArg() if the same value has been set before.
+	 * Memory objects are always set, since a released handle can be reused for a new allocation.
+	 */
+	void set_arg_bytes(const cl_uint arg, const size_t size, const void* value, const arg_kind_e kind) {
+		if(arg < arg_cache.size()) {
+			auto& cache = arg_cache[arg];
+			if(kind != ARG_MEMORY && cache.valid && cache.kind == kind && cache.size == size && (!value || ::memcmp(cache.bytes.data(), value, size) == 0)) {
+				return;
 			}
-		} else {
-			throw std::logic_error("no such argument '" + arg + "' in kernel '" + name + "'");
+			cache.valid = false;
+		}
+#ifndef NDEBUG
+		check_arg(arg, size, kind);
+#endif
+		if(cl_int err = clSetKernelArg(kernel, arg, size, value)) {
+			throw opencl_error_t("clSetKernelArg() failed for " + name + " : " + get_arg_name(arg) + " with " + get_error_string(err));
+		}
+		if(arg < arg_cache.size()) {
+			auto& cache = arg_cache[arg];
+			cache.kind = kind;
+			cache.size = size;
+			if(value) {
+				cache.bytes.assign((const char*)value, ((const char*)value) + size);
+			} else {
+				cache.bytes.clear();
+			}
+			cache.valid = true;
 		}
 	}
 	
+	void check_arg(const cl_uint arg, const size_t size, const arg_kind_e kind) const;
+	
+	std::string get_arg_name(const cl_uint arg) const;
+	
+	void set_args_at(const cl_uint) {}
+	
+	template<typename A, typename... Args>
+	void set_args_at(const cl_uint index, const A& first, const Args&... rest) {
+		set(index, first);
+		set_args_at(index + 1, rest...);
+	}
+	
+	void enqueue_tuned(	std::shared_ptr<CommandQueue> queue, const cl_uint dims, const size_t* global_size,
+						const EventList* wait_list, cl_event* event);
+	
+	void enqueue_nd(std::shared_ptr<CommandQueue> queue, const cl_uint dims, const size_t* global_size, const size_t* local_size,
+					const EventList* wait_list, cl_event* event, const size_t* global_offset = nullptr);
+	
+	template<size_t N>
+	static std::array<size_t, N> get_ceiled(const std::array<size_t, N>& global_size, const std::array<size_t, N>& local_size) {
+		std::array<size_t, N> global_size_ = global_size;
+		for(size_t i = 0; i < N; ++i) {
+			global_size_[i] += (local_size[i] - (global_size[i] % local_size[i])) % local_size[i];
+		}
+		return global_size_;
+	}
+	
 private:
+	void query_arg_info();
+	
+	struct arg_info_t {
+		std::string type_name;
+		cl_kernel_arg_address_qualifier address = 0;
+	};
+	
+	struct arg_cache_t {
+		bool valid = false;
+		arg_kind_e kind = ARG_VALUE;
+		size_t size = 0;
+		std::vector<char> bytes;
+	};
+	
 	cl_kernel kernel = nullptr;
 	
 	std::string name;
 	std::vector<std::string> arg_list;
+	std::vector<arg_info_t> arg_info;
 	std::map<std::string, cl_uint> arg_map;
+	std::vector<arg_cache_t> arg_cache;
+	
+	friend class CommandGraph;		// for enqueue_nd()
 	
 };
 
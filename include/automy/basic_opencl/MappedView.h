@@ -0,0 +1,136 @@
+/*
+ * MappedView.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#ifndef INCLUDE_AUTOMY_BASIC_OPENCL_MAPPEDVIEW_H_
+#define INCLUDE_AUTOMY_BASIC_OPENCL_MAPPEDVIEW_H_
+
+#include <automy/basic_opencl/Context.h>
+
+
+namespace automy {
+namespace basic_opencl {
+
+/*
+ * Heuristic whether mapping buffer on device does not involve a copy, based on the device type
+ * and memory flags: CPU devices, or host accessible memory on devices with unified memory.
+ * The driver may still copy, OpenCL offers no way to find out.
+ */
+bool is_likely_zero_copy(cl_mem buffer, cl_device_id device);
+
+/*
+ * Returns true if buffer was created with CL_MEM_USE_HOST_PTR and mapped equals the host memory
+ * given at creation plus offset bytes. This says nothing about zero-copy: the driver may still
+ * copy between device memory and host_ptr on every map and unmap.
+ */
+bool is_host_ptr_alias(cl_mem buffer, const void* mapped, size_t offset);
+
+/*
+ * Host view of a mapped buffer region, unmapped on destruction.
+ * Use MappedView<const T> for read-only mappings.
+ */
+template<typename T>
+class MappedView {
+public:
+	MappedView(std::shared_ptr<CommandQueue> queue, cl_mem buffer, cl_map_flags flags, size_t offset, size_t count)
+		:	queue_(queue), buffer_(buffer), size_(count)
+	{
+		if(count) {
+			cl_int err = 0;
+			data_ = (T*)clEnqueueMapBuffer(queue->get(), buffer, CL_TRUE, flags, offset * sizeof(T), count * sizeof(T), 0, 0, 0, &err);
+			if(err) {
+				throw opencl_error_t("clEnqueueMapBuffer() failed with " + get_error_string(err));
+			}
+			try {
+				host_ptr_alias_ = basic_opencl::is_host_ptr_alias(buffer, data_, offset * sizeof(T));
+				zero_copy_ = basic_opencl::is_likely_zero_copy(buffer, queue->get_device());
+			} catch(...) {
+				clEnqueueUnmapMemObject(queue->get(), buffer, (void*)data_, 0, 0, 0);
+				throw;
+			}
+		}
+	}
+
+	MappedView(MappedView&& other)
+		:	queue_(other.queue_), buffer_(other.buffer_), data_(other.data_), size_(other.size_),
+			zero_copy_(other.zero_copy_), host_ptr_alias_(other.host_ptr_alias_)
+	{
+		other.data_ = nullptr;
+	}
+
+	~MappedView() {
+		if(data_) {
+			clEnqueueUnmapMemObject(queue_->get(), buffer_, (void*)data_, 0, 0, 0);
+		}
+	}
+
+	MappedView(const MappedView&) = delete;
+	MappedView& operator=(const MappedView&) = delete;
+
+	/*
+	 * Unmaps the region, the view is empty afterwards.
+	 */
+	Event unmap() {
+		Event event;
+		if(data_) {
+			if(cl_int err = clEnqueueUnmapMemObject(queue_->get(), buffer_, (void*)data_, 0, 0, event.reset())) {
+				throw opencl_error_t("clEnqueueUnmapMemObject() failed with " + get_error_string(err));
+			}
+			data_ = nullptr;
+			size_ = 0;
+		}
+		return event;
+	}
+
+	T* data() const {
+		return data_;
+	}
+
+	size_t size() const {
+		return size_;
+	}
+
+	T& operator[](size_t i) const {
+		return data_[i];
+	}
+
+	T* begin() const {
+		return data_;
+	}
+
+	T* end() const {
+		return data_ + size_;
+	}
+
+	/*
+	 * Whether the mapping likely accesses the buffer memory directly, without a copy, see is_likely_zero_copy().
+	 */
+	bool is_likely_zero_copy() const {
+		return zero_copy_;
+	}
+
+	/*
+	 * Whether the mapping points into the CL_MEM_USE_HOST_PTR memory, see is_host_ptr_alias().
+	 */
+	bool is_host_ptr_alias() const {
+		return host_ptr_alias_;
+	}
+
+private:
+	std::shared_ptr<CommandQueue> queue_;
+	cl_mem buffer_ = nullptr;
+	T* data_ = nullptr;
+	size_t size_ = 0;
+	bool zero_copy_ = false;
+	bool host_ptr_alias_ = false;
+
+};
+
+
+} // basic_opencl
+} // automy
+
+#endif /* INCLUDE_AUTOMY_BASIC_OPENCL_MAPPEDVIEW_H_ */
@@ -25,10 +25,16 @@ public:
 
 	Matrix(cl_context context, size_t depth) : Buffer3D<T>(context, Rows, Cols, depth) {}
 
+	Matrix(std::shared_ptr<BufferPool> pool, size_t depth) : Buffer3D<T>(pool, Rows, Cols, depth) {}
+
 	void resize(cl_context context, size_t depth) {
 		Buffer3D<T>::resize(context, Rows, Cols, depth);
 	}
 
+	void resize(std::shared_ptr<BufferPool> pool, size_t depth) {
+		Buffer3D<T>::resize(pool, Rows, Cols, depth);
+	}
+
 	size_t rows() const {
 		return Buffer3D<T>::width();
 	}
@@ -0,0 +1,147 @@
+/*
+ * MultiDevice.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#ifndef INCLUDE_AUTOMY_BASIC_OPENCL_MULTIDEVICE_H_
+#define INCLUDE_AUTOMY_BASIC_OPENCL_MULTIDEVICE_H_
+
+#include <automy/basic_opencl/Context.h>
+#include <automy/basic_opencl/Buffer1D.h>
+#include <automy/basic_opencl/Buffer3D.h>
+
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <functional>
+
+
+namespace automy {
+namespace basic_opencl {
+
+/*
+ * Splits a range of work items (or rows of a 2D range) across all devices of a context, with one queue per device.
+ *
+ * The work is enqueued by a user function for each part, typically with Kernel::enqueue_range() on a kernel
+ * created per device (Program::create_kernel()), writing results through sub-buffers (Buffer1D::alloc_sub())
+ * of a shared output buffer. Once run() returns, all parts have completed and the parent buffer holds the result.
+ *
+ * Relative device throughput is measured on every run and used for the next static split.
+ */
+class MultiDevice {
+public:
+	struct range_t {
+		size_t device = 0;		// index into get_devices()
+		size_t offset = 0;
+		size_t count = 0;
+	};
+
+	/*
+	 * Enqueues the work for range on queue, returns an event for its completion.
+	 * An invalid event means all commands enqueued to queue so far.
+	 */
+	typedef std::function<Event(std::shared_ptr<CommandQueue> queue, const range_t& range)> func_t;
+
+	MultiDevice(cl_context context, const std::vector<cl_device_id>& devices, cl_command_queue_properties properties = 0);
+
+	MultiDevice(const MultiDevice&) = delete;
+	MultiDevice& operator=(const MultiDevice&) = delete;
+
+	static std::shared_ptr<MultiDevice> create(	cl_context context, const std::vector<cl_device_id>& devices,
+												cl_command_queue_properties properties = 0);
+
+	cl_context get_context() const {
+		return context;
+	}
+
+	const std::vector<cl_device_id>& get_devices() const {
+		return devices;
+	}
+
+	std::shared_ptr<CommandQueue> get_queue(size_t device) const {
+		return queues.at(device);
+	}
+
+	/*
+	 * Smallest number of items, of item_size bytes each, such that any multiple is a valid sub-buffer offset on all devices.
+	 */
+	size_t get_granularity(size_t item_size) const;
+
+	/*
+	 * Relative throughput per device, initialized from compute units and clock frequency.
+	 */
+	std::vector<double> get_weights() const;
+
+	void set_weights(const std::vector<double>& weights);
+
+	/*
+	 * Splits [0, num) into one range per device proportional to the weights, offsets are multiples of granularity.
+	 * Devices with a zero count are omitted.
+	 */
+	std::vector<range_t> split(size_t num, size_t granularity = 1) const;
+
+	/*
+	 * Static split: calls func once per device with the ranges from split() and waits for all of them.
+	 */
+	void run(size_t num, const func_t& func, size_t granularity = 1);
+
+	/*
+	 * Dynamic split: hands out chunks of chunk_size items to whichever device becomes idle first, keeping
+	 * two chunks in flight per device. chunk_size needs to be a multiple of the granularity.
+	 */
+	void run_dynamic(size_t num, size_t chunk_size, const func_t& func);
+
+	/*
+	 * Creates sub-buffers of parent for the given ranges, see Buffer1D::alloc_sub().
+	 */
+	template<typename T>
+	static std::vector<std::shared_ptr<Buffer1D<T>>> get_sub_buffers(const Buffer1D<T>& parent, const std::vector<range_t>& ranges) {
+		std::vector<std::shared_ptr<Buffer1D<T>>> out;
+		for(const auto& range : ranges) {
+			auto buffer = Buffer1D<T>::create();
+			buffer->alloc_sub(parent, range.offset, range.count);
+			out.push_back(buffer);
+		}
+		return out;
+	}
+
+	/*
+	 * Creates sub-buffers of a 2D parent for the given ranges of rows, see Buffer3D::alloc_sub_rows().
+	 */
+	template<typename T>
+	static std::vector<std::shared_ptr<Buffer3D<T>>> get_sub_buffers(const Buffer3D<T>& parent, const std::vector<range_t>& ranges) {
+		std::vector<std::shared_ptr<Buffer3D<T>>> out;
+		for(const auto& range : ranges) {
+			auto buffer = Buffer3D<T>::create();
+			buffer->alloc_sub_rows(parent, range.offset, range.count);
+			out.push_back(buffer);
+		}
+		return out;
+	}
+
+private:
+	struct state_t;
+
+	static void submit(std::shared_ptr<state_t> state, std::shared_ptr<CommandQueue> queue, const range_t& range, const func_t& func);
+
+	void update_weights(const std::vector<double>& items, const std::vector<double>& time_ms);
+
+private:
+	cl_context context;
+	std::vector<cl_device_id> devices;
+	std::vector<std::shared_ptr<CommandQueue>> queues;
+	std::vector<size_t> base_align;		// CL_DEVICE_MEM_BASE_ADDR_ALIGN in bytes
+
+	mutable std::mutex mutex;
+	std::vector<double> weights;
+	std::vector<bool> measured;
+
+};
+
+
+} // basic_opencl
+} // automy
+
+#endif /* INCLUDE_AUTOMY_BASIC_OPENCL_MULTIDEVICE_H_ */
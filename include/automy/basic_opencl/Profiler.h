@@ -0,0 +1,129 @@
+/*
+ * Profiler.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#ifndef INCLUDE_AUTOMY_BASIC_OPENCL_PROFILER_H_
+#define INCLUDE_AUTOMY_BASIC_OPENCL_PROFILER_H_
+
+#include <automy/basic_opencl/Event.h>
+
+#include <deque>
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <ostream>
+
+
+namespace automy {
+namespace basic_opencl {
+
+/*
+ * Collects device timestamps of all commands enqueued on a profiling enabled CommandQueue.
+ *
+ * At most max_records are kept, older ones are dropped (see get_num_dropped()), so long running
+ * pipelines should call clear() periodically, for example after each print().
+ */
+class Profiler {
+public:
+	enum command_e {
+		KERNEL,
+		WRITE,
+		READ,
+		COPY,
+		FILL,
+	};
+
+	struct record_t {
+		std::string name;
+		command_e type = KERNEL;
+		size_t num_bytes = 0;
+		cl_ulong queued = 0;		// [ns]
+		cl_ulong submit = 0;		// [ns]
+		cl_ulong start = 0;			// [ns]
+		cl_ulong end = 0;			// [ns]
+	};
+
+	struct stats_t {
+		std::string name;
+		size_t count = 0;
+		size_t num_bytes = 0;
+		double total = 0;			// [ms]
+		double min = 0;				// [ms]
+		double max = 0;				// [ms]
+		double p50 = 0;				// [ms]
+		double p99 = 0;				// [ms]
+		double get_bandwidth() const {
+			return total > 0 ? num_bytes / (total * 1e6) : 0;		// [GB/s]
+		}
+	};
+
+	size_t max_records = 1000000;
+
+	size_t max_pending = 4096;		// add() waits for the oldest command beyond this
+
+	static std::shared_ptr<Profiler> create();
+
+	void add(const std::string& name, command_e type, const Event& event, size_t num_bytes = 0);
+
+	/*
+	 * Waits for all pending commands and reads their timestamps.
+	 */
+	void collect();
+
+	void clear();
+
+	std::vector<record_t> get_records();
+
+	/*
+	 * Number of records dropped due to max_records since the last clear().
+	 */
+	size_t get_num_dropped();
+
+	/*
+	 * Statistics per kernel name, sorted by total time.
+	 */
+	std::vector<stats_t> get_kernel_stats();
+
+	/*
+	 * Statistics per transfer direction (write, read, copy, fill).
+	 */
+	std::vector<stats_t> get_transfer_stats();
+
+	void print(std::ostream& out);
+
+	/*
+	 * Writes a JSON trace viewable in chrome://tracing or Perfetto.
+	 */
+	void write_chrome_trace(std::ostream& out);
+
+	static const char* get_type_name(command_e type);
+
+private:
+	struct pending_t {
+		record_t record;
+		Event event;
+	};
+
+	void collect_pending(bool blocking);
+
+	void add_record(pending_t& entry);
+
+	static std::vector<stats_t> get_stats(const std::vector<record_t>& records, bool by_type);
+
+private:
+	std::mutex mutex;
+	std::deque<pending_t> pending;
+	std::deque<record_t> records;
+	size_t num_dropped = 0;
+
+};
+
+
+} // basic_opencl
+} // automy
+
+#endif /* INCLUDE_AUTOMY_BASIC_OPENCL_PROFILER_H_ */
@@ -10,8 +10,13 @@
 
 #include <automy/basic_opencl/Context.h>
 #include <automy/basic_opencl/Kernel.h>
+#include <automy/basic_opencl/BinaryCache.h>
 
+#include <map>
 #include <set>
+#include <mutex>
+#include <future>
+#include <thread>
 #include <vector>
 #include <string>
 
@@ -25,6 +30,12 @@ public:
 	
 	std::vector<std::string> build_log;
 	
+	std::shared_ptr<BinaryCache> binary_cache;		// optional
+	
+	std::shared_ptr<WorkGroupTuner> tuner;			// optional, passed on to created kernels
+	
+	bool feature_defines = true;		// add -DHAVE_* (and -cl-std if needed) for device capabilities, see kernel/atomics.cl
+	
 	Program(cl_context context);
 	
 	Program(const Program&) = delete;
@@ -34,6 +45,16 @@ public:
 	
 	static std::shared_ptr<Program> create(cl_context context);
 	
+	/*
+	 * Creates a program from source_code (optional) followed by files, which are searched in include_paths.
+	 * Sources are read right away, so missing files throw here, call build_or_throw() next.
+	 */
+	static std::shared_ptr<Program> create(	cl_context context, const std::vector<std::string>& files, const std::string& options,
+											const std::vector<std::string>& include_paths,
+											std::shared_ptr<BinaryCache> binary_cache = nullptr,
+											std::shared_ptr<WorkGroupTuner> tuner = nullptr,
+											const std::string& source_code = std::string());
+	
 	void add_source(const std::string& file_name);
 	
 	void add_source_code(const std::string& source);
@@ -44,19 +65,81 @@ public:
 	
 	bool build(const std::vector<cl_device_id>& devices, bool with_arg_names = true);
 	
+	/*
+	 * Same as build(), but throws std::runtime_error with the build log on failure.
+	 */
+	void build_or_throw(const std::vector<cl_device_id>& devices, bool with_arg_names = true);
+	
+	/*
+	 * Runs build() on a shared pool of at most std::thread::hardware_concurrency() threads,
+	 * the program must stay alive until the future is ready. The driver may still serialize builds internally.
+	 */
+	std::future<bool> build_async(const std::vector<cl_device_id>& devices, bool with_arg_names = true);
+	
+	/*
+	 * Runs build_or_throw() on the same pool as build_async(), the future holds program or the build error.
+	 * With async == false the build runs inline instead, on the first thread to wait for the future.
+	 * Used by Context::get_program() and ProgramTemplate::get(), and their async versions.
+	 */
+	static std::shared_future<std::shared_ptr<Program>> build_shared(	std::shared_ptr<Program> program,
+																		const std::vector<cl_device_id>& devices, bool async = true);
+	
 	void print_sources(std::ostream& out) const;
 	
 	void print_build_log(std::ostream& out) const;
 	
 	std::shared_ptr<Kernel> create_kernel(const std::string& name) const;
 	
+	/*
+	 * Returns the kernel of the calling thread, created on first use by cloning a shared prototype.
+	 * See Kernel::clone(), set all arguments before the first enqueue since they are not always copied.
+	 * Each thread gets its own argument state, so threads can set arguments and enqueue concurrently.
+	 * The returned kernel must not be passed to other threads.
+	 */
+	std::shared_ptr<Kernel> get_kernel(const std::string& name);
+	
+	/*
+	 * Drops all kernels handed out by get_kernel(), for example after worker threads have exited.
+	 */
+	void clear_kernels();
+	
+	bool is_from_cache() const {
+		return from_cache;
+	}
+	
+	/*
+	 * Duration of the last build() in milliseconds, including loading from the binary cache.
+	 */
+	double get_build_time() const {
+		return build_time;
+	}
+	
+private:
+	bool build_from_cache(const std::vector<cl_device_id>& devices, const std::vector<std::string>& key_sources, const std::string& options_);
+	
+	void store_to_cache(const std::vector<cl_device_id>& devices, const std::vector<std::string>& key_sources, const std::string& options_);
+	
+	bool get_build_info(const std::vector<cl_device_id>& devices);
+	
+	static bool has_arg_info(cl_program program_);
+	
+	static std::string get_feature_defines(const std::vector<cl_device_id>& devices, const std::string& options_);
+	
 private:
 	cl_context context;
 	cl_program program = nullptr;
 	bool have_arg_info = false;
+	bool from_cache = false;
+	double build_time = 0;
+	std::string build_options;
 	
 	std::set<std::string> includes;
 	std::vector<std::string> sources;
+	std::vector<std::string> file_names;
+	
+	std::mutex kernel_mutex;
+	std::map<std::string, std::shared_ptr<Kernel>> kernel_prototypes;
+	std::map<std::pair<std::thread::id, std::string>, std::shared_ptr<Kernel>> thread_kernels;
 
 };
 
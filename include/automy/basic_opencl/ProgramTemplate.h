@@ -0,0 +1,178 @@
+/*
+ * ProgramTemplate.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#ifndef INCLUDE_AUTOMY_BASIC_OPENCL_PROGRAMTEMPLATE_H_
+#define INCLUDE_AUTOMY_BASIC_OPENCL_PROGRAMTEMPLATE_H_
+
+#include <automy/basic_opencl/Program.h>
+#include <automy/basic_opencl/Buffer1D.h>
+
+#include <map>
+#include <mutex>
+#include <future>
+#include <string>
+#include <vector>
+#include <memory>
+#include <type_traits>
+
+
+namespace automy {
+namespace basic_opencl {
+
+/*
+ * Storage type for OpenCL half, since cl_half is the same type as cl_ushort.
+ */
+struct half_t {
+	cl_half bits = 0;
+};
+
+/*
+ * OpenCL C type name of a host type, eg. type_name_t<cl_float4>::get() == "float4".
+ */
+template<typename T>
+struct type_name_t {
+	static_assert(sizeof(T) == 0, "no OpenCL type for T");
+};
+
+#define AUTOMY_BASIC_OPENCL_TYPE_NAME(host_type, name) \
+	template<> struct type_name_t<host_type> { static const char* get() { return name; } };
+
+AUTOMY_BASIC_OPENCL_TYPE_NAME(cl_char, "char")
+AUTOMY_BASIC_OPENCL_TYPE_NAME(cl_uchar, "uchar")
+AUTOMY_BASIC_OPENCL_TYPE_NAME(cl_short, "short")
+AUTOMY_BASIC_OPENCL_TYPE_NAME(cl_ushort, "ushort")
+AUTOMY_BASIC_OPENCL_TYPE_NAME(cl_int, "int")
+AUTOMY_BASIC_OPENCL_TYPE_NAME(cl_uint, "uint")
+AUTOMY_BASIC_OPENCL_TYPE_NAME(cl_long, "long")
+AUTOMY_BASIC_OPENCL_TYPE_NAME(cl_ulong, "ulong")
+AUTOMY_BASIC_OPENCL_TYPE_NAME(cl_float, "float")
+AUTOMY_BASIC_OPENCL_TYPE_NAME(cl_double, "double")
+AUTOMY_BASIC_OPENCL_TYPE_NAME(half_t, "half")
+AUTOMY_BASIC_OPENCL_TYPE_NAME(cl_float2, "float2")
+AUTOMY_BASIC_OPENCL_TYPE_NAME(cl_float4, "float4")		// also cl_float3
+AUTOMY_BASIC_OPENCL_TYPE_NAME(cl_int2, "int2")
+AUTOMY_BASIC_OPENCL_TYPE_NAME(cl_int4, "int4")
+AUTOMY_BASIC_OPENCL_TYPE_NAME(cl_uint2, "uint2")
+AUTOMY_BASIC_OPENCL_TYPE_NAME(cl_uint4, "uint4")
+AUTOMY_BASIC_OPENCL_TYPE_NAME(cl_double2, "double2")
+AUTOMY_BASIC_OPENCL_TYPE_NAME(cl_double4, "double4")
+
+#undef AUTOMY_BASIC_OPENCL_TYPE_NAME
+
+
+/*
+ * Kernel source which is compiled once per unique set of constants, lazily on first use.
+ * Constants are passed as -D<name>=<value>, for example:
+ *
+ *   ProgramTemplate::params_t params;
+ *   params.set_type("T", buffer).set("CHANNELS", 3).set("USE_LUT", true);
+ *   auto kernel = program->get_kernel(params, "convert");
+ *
+ * Booleans are defined as 1 or 0, use #if instead of #ifdef.
+ * Kernels using half need to enable cl_khr_fp16, which is signaled by HAVE_FP16.
+ */
+class ProgramTemplate {
+public:
+	class params_t {
+	public:
+		params_t& set(const std::string& name, bool value) {
+			values[name] = value ? "1" : "0";
+			return *this;
+		}
+
+		template<typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+		params_t& set(const std::string& name, T value) {
+			values[name] = std::to_string(value);
+			return *this;
+		}
+
+		params_t& set_type(const std::string& name, const std::string& type_name) {
+			values[name] = type_name;
+			return *this;
+		}
+
+		template<typename T>
+		params_t& set_type(const std::string& name) {
+			return set_type(name, type_name_t<T>::get());
+		}
+
+		/*
+		 * Uses the element type of buffer.
+		 */
+		template<typename T>
+		params_t& set_type(const std::string& name, const Buffer1D<T>& buffer) {
+			return set_type<T>(name);
+		}
+
+		/*
+		 * Returns the build options, in a fixed order.
+		 */
+		std::string get_options() const;
+
+	private:
+		std::map<std::string, std::string> values;
+
+	};
+
+	std::string options;		// common to all specializations
+
+	std::shared_ptr<BinaryCache> binary_cache;		// optional
+
+	std::shared_ptr<WorkGroupTuner> tuner;			// optional
+
+	/*
+	 * files are searched in the include paths, see Program::add_source()
+	 */
+	ProgramTemplate(cl_context context, const std::vector<cl_device_id>& devices, const std::vector<std::string>& files);
+
+	~ProgramTemplate();
+
+	ProgramTemplate(const ProgramTemplate&) = delete;
+	ProgramTemplate& operator=(const ProgramTemplate&) = delete;
+
+	static std::shared_ptr<ProgramTemplate> create(	cl_context context, const std::vector<cl_device_id>& devices,
+													const std::vector<std::string>& files);
+
+	void add_include_path(const std::string& path);
+
+	/*
+	 * Returns the program for params, builds it on first use.
+	 * Throws std::runtime_error with the build log on failure.
+	 */
+	std::shared_ptr<Program> get(const params_t& params);
+
+	/*
+	 * Same as get(), but builds on a worker thread, for example to prepare known specializations at startup.
+	 */
+	std::shared_future<std::shared_ptr<Program>> get_async(const params_t& params);
+
+	/*
+	 * Returns the kernel of the calling thread, see Program::get_kernel().
+	 */
+	std::shared_ptr<Kernel> get_kernel(const params_t& params, const std::string& name);
+
+	size_t get_num_programs() const;
+
+private:
+	std::shared_future<std::shared_ptr<Program>> get_future(const params_t& params, bool async);
+
+private:
+	cl_context context;
+	std::vector<cl_device_id> devices;
+	std::vector<std::string> files;
+	std::vector<std::string> include_paths;
+
+	mutable std::mutex mutex;
+	std::map<std::string, std::shared_future<std::shared_ptr<Program>>> programs;
+
+};
+
+
+} // basic_opencl
+} // automy
+
+#endif /* INCLUDE_AUTOMY_BASIC_OPENCL_PROGRAMTEMPLATE_H_ */
@@ -0,0 +1,93 @@
+/*
+ * QueueSet.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#ifndef INCLUDE_AUTOMY_BASIC_OPENCL_QUEUESET_H_
+#define INCLUDE_AUTOMY_BASIC_OPENCL_QUEUESET_H_
+
+#include <automy/basic_opencl/CommandQueue.h>
+
+#include <vector>
+#include <memory>
+
+
+namespace automy {
+namespace basic_opencl {
+
+/*
+ * One compute queue plus dedicated transfer queues for a device, so that transfers can overlap kernels.
+ * Dependencies between the queues are expressed with events, for example:
+ *
+ *   const auto uploaded = input.upload(set->next_transfer(), data, std::vector<Event>());
+ *   set->wait(set->compute(), {uploaded});
+ *   kernel->enqueue(set->compute(), ...);
+ *   const auto done = set->signal(set->compute());
+ *
+ * Since transfer queues are separate, the upload for frame N+1 can run while frame N is computed.
+ */
+class QueueSet {
+public:
+	/*
+	 * properties apply to all queues, ie. CL_QUEUE_PROFILING_ENABLE and / or CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE.
+	 */
+	QueueSet(cl_context context, cl_device_id device, size_t num_transfer = 1, cl_command_queue_properties properties = 0);
+
+	QueueSet(const QueueSet&) = delete;
+	QueueSet& operator=(const QueueSet&) = delete;
+
+	static std::shared_ptr<QueueSet> create(	cl_context context, cl_device_id device, size_t num_transfer = 1,
+											cl_command_queue_properties properties = 0);
+
+	std::shared_ptr<CommandQueue> compute() const {
+		return compute_queue;
+	}
+
+	std::shared_ptr<CommandQueue> transfer(size_t index) const {
+		return transfer_queues.at(index);
+	}
+
+	/*
+	 * Returns the transfer queues in round robin order.
+	 */
+	std::shared_ptr<CommandQueue> next_transfer();
+
+	size_t get_num_transfer() const {
+		return transfer_queues.size();
+	}
+
+	cl_device_id get_device() const {
+		return device;
+	}
+
+	/*
+	 * Returns an event which completes once all commands enqueued so far to queue have completed.
+	 */
+	Event signal(std::shared_ptr<CommandQueue> queue) const {
+		return queue->enqueue_marker();
+	}
+
+	/*
+	 * All following commands on queue wait for events, which can come from any queue of the set.
+	 */
+	void wait(std::shared_ptr<CommandQueue> queue, const std::vector<Event>& events) const;
+
+	void flush();
+
+	void finish();
+
+private:
+	cl_device_id device;
+	std::shared_ptr<CommandQueue> compute_queue;
+	std::vector<std::shared_ptr<CommandQueue>> transfer_queues;
+	size_t next_index = 0;
+
+};
+
+
+} // basic_opencl
+} // automy
+
+#endif /* INCLUDE_AUTOMY_BASIC_OPENCL_QUEUESET_H_ */
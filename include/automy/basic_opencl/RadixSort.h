@@ -0,0 +1,133 @@
+/*
+ * RadixSort.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#ifndef INCLUDE_AUTOMY_BASIC_OPENCL_RADIXSORT_H_
+#define INCLUDE_AUTOMY_BASIC_OPENCL_RADIXSORT_H_
+
+#include <automy/basic_opencl/Scan.h>
+
+
+namespace automy {
+namespace basic_opencl {
+
+/*
+ * Stable LSD radix sort on the device, 4 bits per pass, using kernel/radix_sort.cl.
+ * Each pass counts digits per tile of keys, scans the counts and scatters each tile sorted in local memory.
+ * Keys: cl_uint, cl_int, cl_float, cl_ulong, cl_long and cl_double (-0 sorts before +0, NaNs at the ends).
+ * Values: any type of 1, 2, 4, 8 or 16 bytes. Not thread-safe.
+ *
+ * Scratch memory is allocated per call from Scan::get_scratch_pool() and released once the returned event
+ * has completed. The first command waits for wait_list, all commands are chained via events.
+ */
+class RadixSort {
+public:
+	RadixSort(std::shared_ptr<Scan> scan, const std::string& kernel_path);
+
+	RadixSort(const RadixSort&) = delete;
+	RadixSort& operator=(const RadixSort&) = delete;
+
+	static std::shared_ptr<RadixSort> create(std::shared_ptr<Scan> scan, const std::string& kernel_path);
+
+	template<typename K>
+	Event sort(	std::shared_ptr<CommandQueue> queue, Buffer1D<K>& keys,
+				const std::vector<Event>& wait_list = std::vector<Event>()) {
+		return sort_keys(queue, key_traits_t<K>::bits, key_traits_t<K>::mode, keys, nullptr, 0, keys.size(), wait_list);
+	}
+
+	/*
+	 * Sorts keys and moves values along, values.size() must be >= keys.size().
+	 */
+	template<typename K, typename V>
+	Event sort(	std::shared_ptr<CommandQueue> queue, Buffer1D<K>& keys, Buffer1D<V>& values,
+				const std::vector<Event>& wait_list = std::vector<Event>()) {
+		check_values(keys.size(), values.size());
+		return sort_keys(queue, key_traits_t<K>::bits, key_traits_t<K>::mode, keys, &values, sizeof(V), keys.size(), wait_list);
+	}
+
+	/*
+	 * Sorts by (segments[i], keys[i]), ie. each segment separately if segments are contiguous.
+	 * Only 32-bit keys, all segment ids must be < num_segments.
+	 */
+	template<typename K>
+	Event sort_segmented(	std::shared_ptr<CommandQueue> queue, Buffer1D<K>& keys, const Buffer1D<cl_uint>& segments, cl_uint num_segments,
+							const std::vector<Event>& wait_list = std::vector<Event>()) {
+		static_assert(key_traits_t<K>::bits == 32, "sort_segmented() requires 32-bit keys");
+		check_values(keys.size(), segments.size());
+		return sort_segments(queue, key_traits_t<K>::mode, keys, segments, num_segments, nullptr, 0, keys.size(), wait_list);
+	}
+
+	template<typename K, typename V>
+	Event sort_segmented(	std::shared_ptr<CommandQueue> queue, Buffer1D<K>& keys, const Buffer1D<cl_uint>& segments, cl_uint num_segments,
+							Buffer1D<V>& values, const std::vector<Event>& wait_list = std::vector<Event>())
+	{
+		static_assert(key_traits_t<K>::bits == 32, "sort_segmented() requires 32-bit keys");
+		check_values(keys.size(), segments.size());
+		check_values(keys.size(), values.size());
+		return sort_segments(queue, key_traits_t<K>::mode, keys, segments, num_segments, &values, sizeof(V), keys.size(), wait_list);
+	}
+
+private:
+	enum key_mode_e {
+		MODE_UNSIGNED = 0,
+		MODE_SIGNED = 1,
+		MODE_FLOAT = 2,
+	};
+
+	template<typename K>
+	struct key_traits_t;
+
+	struct kernels_t {
+		std::shared_ptr<Program> program;
+		std::shared_ptr<Kernel> encode;
+		std::shared_ptr<Kernel> decode;
+		std::shared_ptr<Kernel> count;
+		std::shared_ptr<Kernel> scatter;
+		std::shared_ptr<Kernel> gather;				// with values only
+		std::shared_ptr<Kernel> make_segmented;		// 64-bit keys only
+		std::shared_ptr<Kernel> split_segmented;	// 64-bit keys only
+		size_t local_size = 1;
+	};
+
+	static void check_values(size_t num_keys, size_t num_values);
+
+	kernels_t& get_kernels(int key_bits, size_t value_size);
+
+	Event sort_keys(	std::shared_ptr<CommandQueue> queue, int key_bits, key_mode_e mode, Buffer& keys,
+						Buffer* values, size_t value_size, size_t num, const std::vector<Event>& wait_list);
+
+	/*
+	 * Sorts already encoded keys by bits [0, end_bit), scratch buffers are appended to scratch.
+	 */
+	Event sort_passes(	std::shared_ptr<CommandQueue> queue, int key_bits, Buffer& keys, Buffer* values, size_t value_size,
+						size_t num, int end_bit, const std::vector<Event>& wait_list, std::vector<std::shared_ptr<Buffer>>& scratch);
+
+	Event sort_segments(std::shared_ptr<CommandQueue> queue, key_mode_e mode, Buffer& keys, const Buffer& segments,
+						cl_uint num_segments, Buffer* values, size_t value_size, size_t num, const std::vector<Event>& wait_list);
+
+	Event copy(std::shared_ptr<CommandQueue> queue, const Buffer& src, Buffer& dst, size_t num_bytes, const std::vector<Event>& wait_list);
+
+private:
+	std::shared_ptr<Scan> scan;
+	std::string kernel_path;
+	size_t tile_local_size = 1;		// work group size of radix_count() / radix_scatter()
+
+	std::map<std::string, kernels_t> kernels;
+
+};
+
+template<> struct RadixSort::key_traits_t<cl_uint> { static const int bits = 32; static const key_mode_e mode = MODE_UNSIGNED; };
+template<> struct RadixSort::key_traits_t<cl_int> { static const int bits = 32; static const key_mode_e mode = MODE_SIGNED; };
+template<> struct RadixSort::key_traits_t<cl_float> { static const int bits = 32; static const key_mode_e mode = MODE_FLOAT; };
+template<> struct RadixSort::key_traits_t<cl_ulong> { static const int bits = 64; static const key_mode_e mode = MODE_UNSIGNED; };
+template<> struct RadixSort::key_traits_t<cl_long> { static const int bits = 64; static const key_mode_e mode = MODE_SIGNED; };
+template<> struct RadixSort::key_traits_t<cl_double> { static const int bits = 64; static const key_mode_e mode = MODE_FLOAT; };
+
+
+} // basic_opencl
+} // automy
+
+#endif /* INCLUDE_AUTOMY_BASIC_OPENCL_RADIXSORT_H_ */
@@ -0,0 +1,181 @@
+/*
+ * Reduction.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#ifndef INCLUDE_AUTOMY_BASIC_OPENCL_REDUCTION_H_
+#define INCLUDE_AUTOMY_BASIC_OPENCL_REDUCTION_H_
+
+#include <automy/basic_opencl/Program.h>
+#include <automy/basic_opencl/Buffer1D.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <memory>
+
+
+namespace automy {
+namespace basic_opencl {
+
+/*
+ * Device-wide reductions over Buffer1D<T> for T = cl_float, cl_double, cl_int and cl_uint,
+ * using kernel/reduce.cl. Programs are built on first use per type and operation.
+ * Integer sums wrap around on overflow.
+ * Scratch memory is taken per call and returned once the reduction has finished,
+ * so concurrent reductions on different (or out-of-order) queues are safe.
+ */
+class Reduction {
+public:
+	enum op_e {
+		SUM,
+		MIN,
+		MAX,
+		ARGMIN,
+		ARGMAX,
+		MEAN_VAR,
+	};
+
+	template<typename T>
+	struct arg_t {
+		T value;
+		cl_uint index;			// lowest index in case of ties
+	};
+
+	struct moments_t {
+		double mean = 0;
+		double variance = 0;	// population variance
+		size_t count = 0;
+	};
+
+	std::shared_ptr<BinaryCache> binary_cache;		// optional
+
+	std::shared_ptr<BufferPool> pool;				// optional, for scratch memory, eg. Context::get_buffer_pool()
+
+	/*
+	 * kernel_path is the directory containing reduce.cl
+	 */
+	Reduction(cl_context context, cl_device_id device, const std::string& kernel_path);
+
+	Reduction(const Reduction&) = delete;
+	Reduction& operator=(const Reduction&) = delete;
+
+	static std::shared_ptr<Reduction> create(cl_context context, cl_device_id device, const std::string& kernel_path);
+
+	template<typename T>
+	T sum(std::shared_ptr<CommandQueue> queue, const Buffer1D<T>& in) {
+		T res = 0;
+		reduce(queue, SUM, get_type<T>(), in, in.size(), nullptr, 0, &res, sizeof(T));
+		return res;
+	}
+
+	template<typename T>
+	T min(std::shared_ptr<CommandQueue> queue, const Buffer1D<T>& in) {
+		T res = 0;
+		reduce(queue, MIN, get_type<T>(), in, in.size(), nullptr, 0, &res, sizeof(T));
+		return res;
+	}
+
+	template<typename T>
+	T max(std::shared_ptr<CommandQueue> queue, const Buffer1D<T>& in) {
+		T res = 0;
+		reduce(queue, MAX, get_type<T>(), in, in.size(), nullptr, 0, &res, sizeof(T));
+		return res;
+	}
+
+	/*
+	 * Device scalar variants, result is written to result[0] without waiting.
+	 */
+	template<typename T>
+	void sum(std::shared_ptr<CommandQueue> queue, const Buffer1D<T>& in, Buffer1D<T>& result) {
+		reduce(queue, SUM, get_type<T>(), in, in.size(), &result, result.size() * sizeof(T), nullptr, sizeof(T));
+	}
+
+	template<typename T>
+	void min(std::shared_ptr<CommandQueue> queue, const Buffer1D<T>& in, Buffer1D<T>& result) {
+		reduce(queue, MIN, get_type<T>(), in, in.size(), &result, result.size() * sizeof(T), nullptr, sizeof(T));
+	}
+
+	template<typename T>
+	void max(std::shared_ptr<CommandQueue> queue, const Buffer1D<T>& in, Buffer1D<T>& result) {
+		reduce(queue, MAX, get_type<T>(), in, in.size(), &result, result.size() * sizeof(T), nullptr, sizeof(T));
+	}
+
+	template<typename T>
+	arg_t<T> argmin(std::shared_ptr<CommandQueue> queue, const Buffer1D<T>& in) {
+		arg_t<T> res = {};
+		reduce(queue, ARGMIN, get_type<T>(), in, in.size(), nullptr, 0, &res, sizeof(res));
+		return res;
+	}
+
+	template<typename T>
+	arg_t<T> argmax(std::shared_ptr<CommandQueue> queue, const Buffer1D<T>& in) {
+		arg_t<T> res = {};
+		reduce(queue, ARGMAX, get_type<T>(), in, in.size(), nullptr, 0, &res, sizeof(res));
+		return res;
+	}
+
+	/*
+	 * Mean and variance in single precision, unless T = cl_double.
+	 */
+	template<typename T>
+	moments_t mean_var(std::shared_ptr<CommandQueue> queue, const Buffer1D<T>& in) {
+		typedef typename std::conditional<std::is_same<T, cl_double>::value, cl_double, cl_float>::type M;
+		struct {
+			M mean;
+			M m2;
+			cl_uint count;
+		} res = {};
+		reduce(queue, MEAN_VAR, get_type<T>(), in, in.size(), nullptr, 0, &res, sizeof(res));
+		moments_t out;
+		out.mean = res.mean;
+		out.variance = res.count ? res.m2 / res.count : 0;
+		out.count = res.count;
+		return out;
+	}
+
+	static const char* get_op_name(op_e op);
+
+private:
+	struct kernels_t {
+		std::shared_ptr<Program> program;
+		std::shared_ptr<Kernel> first;
+		std::shared_ptr<Kernel> final;
+	};
+
+	template<typename T>
+	static std::string get_type();
+
+	/*
+	 * Writes the result either to device buffer result (of result_size bytes) or to host memory at host_result.
+	 */
+	void reduce(std::shared_ptr<CommandQueue> queue, op_e op, const std::string& type, const Buffer& in, size_t num,
+				Buffer* result, size_t result_size, void* host_result, size_t acc_size);
+
+	kernels_t get_kernels(op_e op, const std::string& type);
+
+private:
+	cl_context context;
+	cl_device_id device;
+	std::string kernel_path;
+	size_t num_compute_units = 1;
+	bool have_subgroups = false;
+
+	std::mutex mutex;
+	std::map<std::string, kernels_t> kernels;
+	std::shared_ptr<BufferPool> default_pool;
+
+};
+
+template<> inline std::string Reduction::get_type<cl_float>() { return "FLOAT"; }
+template<> inline std::string Reduction::get_type<cl_double>() { return "DOUBLE"; }
+template<> inline std::string Reduction::get_type<cl_int>() { return "INT"; }
+template<> inline std::string Reduction::get_type<cl_uint>() { return "UINT"; }
+
+
+} // basic_opencl
+} // automy
+
+#endif /* INCLUDE_AUTOMY_BASIC_OPENCL_REDUCTION_H_ */
@@ -0,0 +1,127 @@
+/*
+ * Scan.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#ifndef INCLUDE_AUTOMY_BASIC_OPENCL_SCAN_H_
+#define INCLUDE_AUTOMY_BASIC_OPENCL_SCAN_H_
+
+#include <automy/basic_opencl/Program.h>
+#include <automy/basic_opencl/Buffer1D.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <memory>
+
+
+namespace automy {
+namespace basic_opencl {
+
+/*
+ * Device-wide prefix sum over Buffer1D<T> for T = cl_uint, cl_int and cl_float, using kernel/scan.cl.
+ * Blocks are scanned independently, then the block sums are scanned recursively and added back.
+ *
+ * Block sums are allocated per call and released once the returned event has completed,
+ * so calls on different queues do not interfere. Commands are chained via events.
+ */
+class Scan {
+public:
+	std::shared_ptr<BinaryCache> binary_cache;		// optional
+
+	std::shared_ptr<BufferPool> pool;				// optional, for scratch memory, eg. Context::get_buffer_pool()
+
+	/*
+	 * kernel_path is the directory containing scan.cl
+	 */
+	Scan(cl_context context, cl_device_id device, const std::string& kernel_path);
+
+	Scan(const Scan&) = delete;
+	Scan& operator=(const Scan&) = delete;
+
+	static std::shared_ptr<Scan> create(cl_context context, cl_device_id device, const std::string& kernel_path);
+
+	/*
+	 * out[i] = in[0] + ... + in[i-1], out is resized if needed and may be the same as in.
+	 */
+	template<typename T>
+	Event exclusive_scan(	std::shared_ptr<CommandQueue> queue, const Buffer1D<T>& in, Buffer1D<T>& out,
+							const std::vector<Event>& wait_list = std::vector<Event>()) {
+		if(&out != &in) {
+			out.alloc_min(context, in.size());
+		}
+		return scan(queue, get_type<T>(), sizeof(T), in, out, in.size(), false, wait_list);
+	}
+
+	/*
+	 * out[i] = in[0] + ... + in[i], out is resized if needed and may be the same as in.
+	 */
+	template<typename T>
+	Event inclusive_scan(	std::shared_ptr<CommandQueue> queue, const Buffer1D<T>& in, Buffer1D<T>& out,
+							const std::vector<Event>& wait_list = std::vector<Event>()) {
+		if(&out != &in) {
+			out.alloc_min(context, in.size());
+		}
+		return scan(queue, get_type<T>(), sizeof(T), in, out, in.size(), true, wait_list);
+	}
+
+	/*
+	 * Scans the first num elements of in into out, which need to be large enough.
+	 * The first command waits for wait_list, returns an event for the last one.
+	 */
+	Event scan(	std::shared_ptr<CommandQueue> queue, const std::string& type, size_t type_size,
+				const Buffer& in, Buffer& out, size_t num, bool inclusive,
+				const std::vector<Event>& wait_list = std::vector<Event>());
+
+	/*
+	 * Returns pool, or an internal pool if not set. Also used by Compaction and RadixSort.
+	 */
+	std::shared_ptr<BufferPool> get_scratch_pool();
+
+	cl_context get_context() const {
+		return context;
+	}
+
+	cl_device_id get_device() const {
+		return device;
+	}
+
+private:
+	struct kernels_t {
+		std::shared_ptr<Program> program;
+		std::shared_ptr<Kernel> scan_blocks;
+		std::shared_ptr<Kernel> add_block_offsets;
+		size_t local_size = 0;
+	};
+
+	template<typename T>
+	static std::string get_type();
+
+	kernels_t get_kernels(const std::string& type);
+
+	Event scan_level(	std::shared_ptr<CommandQueue> queue, const kernels_t& kernels, size_t type_size,
+						const Buffer& in, Buffer& out, size_t num, bool inclusive, const std::vector<Event>& wait_list,
+						std::vector<std::shared_ptr<Buffer1D<cl_uchar>>>& scratch);
+
+private:
+	cl_context context;
+	cl_device_id device;
+	std::string kernel_path;
+
+	std::mutex mutex;
+	std::map<std::string, kernels_t> kernels;
+	std::shared_ptr<BufferPool> default_pool;
+
+};
+
+template<> inline std::string Scan::get_type<cl_uint>() { return "UINT"; }
+template<> inline std::string Scan::get_type<cl_int>() { return "INT"; }
+template<> inline std::string Scan::get_type<cl_float>() { return "FLOAT"; }
+
+
+} // basic_opencl
+} // automy
+
+#endif /* INCLUDE_AUTOMY_BASIC_OPENCL_SCAN_H_ */
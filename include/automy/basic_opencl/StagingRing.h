@@ -0,0 +1,120 @@
+/*
+ * StagingRing.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#ifndef INCLUDE_AUTOMY_BASIC_OPENCL_STAGINGRING_H_
+#define INCLUDE_AUTOMY_BASIC_OPENCL_STAGINGRING_H_
+
+#include <automy/basic_opencl/Buffer1D.h>
+#include <automy/basic_opencl/Buffer3D.h>
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+
+
+namespace automy {
+namespace basic_opencl {
+
+/*
+ * Ring of pinned (CL_MEM_ALLOC_HOST_PTR) host buffers to stream large transfers in chunks,
+ * such that host memcpy, transfer and kernels consuming earlier chunks overlap.
+ * Not thread-safe, use one ring per thread.
+ */
+class StagingRing {
+public:
+	struct stats_t {
+		size_t num_bytes = 0;
+		double time = 0;			// [s]
+		double get_bandwidth() const {
+			return time > 0 ? num_bytes / (time * 1e9) : 0;		// [GB/s]
+		}
+	};
+
+	/*
+	 * Called after each chunk has been enqueued, with offset and size in bytes.
+	 */
+	typedef std::function<void(size_t offset, size_t num_bytes, const Event& event)> callback_t;
+
+	StagingRing(cl_context context, size_t chunk_size = 4 * 1024 * 1024, size_t num_slots = 3);
+
+	~StagingRing();
+
+	StagingRing(const StagingRing&) = delete;
+	StagingRing& operator=(const StagingRing&) = delete;
+
+	static std::shared_ptr<StagingRing> create(cl_context context, size_t chunk_size = 4 * 1024 * 1024, size_t num_slots = 3);
+
+	/*
+	 * Returns as soon as all data has been copied to staging memory, src can be reused immediately.
+	 * The returned event signals completion of the transfer.
+	 */
+	Event upload(std::shared_ptr<CommandQueue> queue, cl_mem dst, size_t dst_offset, const void* src, size_t num_bytes,
+				const callback_t& on_chunk = nullptr);
+
+	/*
+	 * Blocks until all data has been copied to dst.
+	 */
+	void download(std::shared_ptr<CommandQueue> queue, cl_mem src, size_t src_offset, void* dst, size_t num_bytes);
+
+	template<typename T>
+	Event upload(std::shared_ptr<CommandQueue> queue, Buffer1D<T>& dst, const T* src, const callback_t& on_chunk = nullptr) {
+		return upload(queue, dst.data(), 0, src, dst.num_bytes(), on_chunk);
+	}
+
+	template<typename T>
+	Event upload(std::shared_ptr<CommandQueue> queue, Buffer3D<T>& dst, const T* src, const callback_t& on_chunk = nullptr) {
+		return upload(queue, dst.data(), 0, src, dst.size() * sizeof(T), on_chunk);
+	}
+
+	template<typename T>
+	void download(std::shared_ptr<CommandQueue> queue, const Buffer1D<T>& src, T* dst) {
+		download(queue, src.data(), 0, dst, src.num_bytes());
+	}
+
+	template<typename T>
+	void download(std::shared_ptr<CommandQueue> queue, const Buffer3D<T>& src, T* dst) {
+		download(queue, src.data(), 0, dst, src.size() * sizeof(T));
+	}
+
+	/*
+	 * Throughput of the last completed transfer, measured from the first memcpy until the last chunk completed.
+	 */
+	stats_t get_last_stats() const;
+
+	size_t get_chunk_size() const {
+		return chunk_size;
+	}
+
+private:
+	struct slot_t {
+		cl_mem buffer = nullptr;
+		void* host = nullptr;
+		Event event;
+	};
+
+	void map_slots(std::shared_ptr<CommandQueue> queue);
+
+private:
+	cl_context context;
+	size_t chunk_size = 0;
+	std::vector<slot_t> slots;
+	std::shared_ptr<CommandQueue> map_queue;
+
+	struct shared_stats_t {
+		std::mutex mutex;
+		stats_t stats;
+	};
+	std::shared_ptr<shared_stats_t> last_stats;
+
+};
+
+
+} // basic_opencl
+} // automy
+
+#endif /* INCLUDE_AUTOMY_BASIC_OPENCL_STAGINGRING_H_ */
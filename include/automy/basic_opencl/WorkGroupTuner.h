@@ -0,0 +1,113 @@
+/*
+ * WorkGroupTuner.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#ifndef INCLUDE_AUTOMY_BASIC_OPENCL_WORKGROUPTUNER_H_
+#define INCLUDE_AUTOMY_BASIC_OPENCL_WORKGROUPTUNER_H_
+
+#include <automy/basic_opencl/Context.h>
+
+#include <map>
+#include <array>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <memory>
+
+
+namespace automy {
+namespace basic_opencl {
+
+/*
+ * Finds the fastest local size per device, kernel, build options and global size bucket (next power of two),
+ * by timing the first launches with different candidates. Results are persisted in a text file.
+ * Only use for kernels which produce the same result for any local size.
+ */
+class WorkGroupTuner {
+public:
+	typedef std::array<size_t, 3> size3_t;
+
+	struct launch_t {
+		std::string key;
+		size3_t local_size = {{1, 1, 1}};
+		size_t candidate = -1;			// -1 if already tuned
+		bool is_trial() const {
+			return candidate != size_t(-1);
+		}
+	};
+
+	/*
+	 * file_name can be empty to not persist results.
+	 * Each candidate is timed num_runs times, the fastest run counts.
+	 */
+	WorkGroupTuner(const std::string& file_name, size_t num_runs = 3);
+
+	WorkGroupTuner(const WorkGroupTuner&) = delete;
+	WorkGroupTuner& operator=(const WorkGroupTuner&) = delete;
+
+	static std::shared_ptr<WorkGroupTuner> create(const std::string& file_name, size_t num_runs = 3);
+
+	/*
+	 * Returns the local size to use for the next launch.
+	 * options are the program build options, since specializations of a kernel can differ in their best local size.
+	 */
+	launch_t begin(	cl_kernel kernel, const std::string& name, const std::string& options,
+					cl_device_id device, cl_uint dims, const size_t* global_size);
+
+	/*
+	 * Reports the execution time of a trial launch [ms].
+	 */
+	void end(const launch_t& launch, double time);
+
+	/*
+	 * Returns true and the tuned local size if known.
+	 */
+	bool find(const std::string& key, size3_t& local_size) const;
+
+	/*
+	 * Valid local sizes for the given kernel and device, limited to the global size bucket.
+	 */
+	static std::vector<size3_t> get_candidates(cl_kernel kernel, cl_device_id device, cl_uint dims, const size3_t& bucket);
+
+	void clear();
+
+	void save() const;
+
+	const std::string& get_file_name() const {
+		return file_name;
+	}
+
+private:
+	struct entry_t {
+		bool done = false;
+		size3_t best = {{1, 1, 1}};
+		size_t num_started = 0;
+		size_t num_finished = 0;
+		std::vector<size3_t> candidates;
+		std::vector<double> times;
+	};
+
+	std::string get_device_key(cl_device_id device);
+
+	void load();
+
+	void save_locked() const;
+
+private:
+	std::string file_name;
+	size_t num_runs = 0;
+
+	mutable std::mutex mutex;
+	std::map<std::string, entry_t> table;
+	std::map<cl_device_id, std::string> device_keys;
+
+};
+
+
+} // basic_opencl
+} // automy
+
+#endif /* INCLUDE_AUTOMY_BASIC_OPENCL_WORKGROUPTUNER_H_ */
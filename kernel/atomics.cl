@@ -1,6 +1,38 @@
+/*
+ * Atomic helpers, using native atomics where available.
+ *
+ * Program::build() defines HAVE_INT64_ATOMICS, HAVE_SUBGROUPS, HAVE_FP64, HAVE_FP16, HAVE_FLOAT_ATOMIC_ADD_GLOBAL
+ * and HAVE_FLOAT_ATOMIC_ADD_LOCAL according to the device capabilities.
+ * Native float atomics (cl_ext_float_atomics) require OpenCL C 2.0 or later, Program::build() adds
+ * -cl-std=CL2.0 / CL3.0 for them when all devices support it and the options do not set -cl-std already.
+ */
+
+#if defined(HAVE_INT64_ATOMICS) && defined(cl_khr_int64_base_atomics)
+#pragma OPENCL EXTENSION cl_khr_int64_base_atomics : enable
+#define USE_INT64_ATOMICS
+#endif
+
+#if defined(HAVE_SUBGROUPS)
+#ifdef cl_khr_subgroups
+#pragma OPENCL EXTENSION cl_khr_subgroups : enable
+#endif
+#define USE_SUBGROUPS
+#endif
+
+#if defined(HAVE_FLOAT_ATOMIC_ADD_GLOBAL) && __OPENCL_C_VERSION__ >= 200
+#define USE_FLOAT_ATOMIC_ADD_GLOBAL
+#endif
+
+#if defined(HAVE_FLOAT_ATOMIC_ADD_LOCAL) && __OPENCL_C_VERSION__ >= 200
+#define USE_FLOAT_ATOMIC_ADD_LOCAL
+#endif
+
 
 void atomic_add_g_f(volatile __global float* addr, float val)
 {
+#ifdef USE_FLOAT_ATOMIC_ADD_GLOBAL
+	atomic_fetch_add_explicit((volatile __global atomic_float*)addr, val, memory_order_relaxed, memory_scope_device);
+#else
 	union {
 		unsigned int u32;
 		float f32;
@@ -11,5 +43,132 @@ void atomic_add_g_f(volatile __global float* addr, float val)
 		next.f32 = expected.f32 + val;
 		current.u32 = atomic_cmpxchg((volatile __global unsigned int*)addr, expected.u32, next.u32);
 	} while(current.u32 != expected.u32);
+#endif
+}
+
+
+void atomic_add_l_f(volatile __local float* addr, float val)
+{
+#ifdef USE_FLOAT_ATOMIC_ADD_LOCAL
+	atomic_fetch_add_explicit((volatile __local atomic_float*)addr, val, memory_order_relaxed, memory_scope_work_group);
+#else
+	union {
+		unsigned int u32;
+		float f32;
+	} next, expected, current;
+	current.f32 = *addr;
+	do {
+		expected.f32 = current.f32;
+		next.f32 = expected.f32 + val;
+		current.u32 = atomic_cmpxchg((volatile __local unsigned int*)addr, expected.u32, next.u32);
+	} while(current.u32 != expected.u32);
+#endif
+}
+
+
+#ifdef USE_INT64_ATOMICS
+
+void atomic_add_g_l(volatile __global long* addr, long val)
+{
+	atom_add(addr, val);
+}
+
+#if defined(HAVE_FP64)
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+
+void atomic_add_g_d(volatile __global double* addr, double val)
+{
+	union {
+		ulong u64;
+		double f64;
+	} next, expected, current;
+	current.f64 = *addr;
+	do {
+		expected.f64 = current.f64;
+		next.f64 = expected.f64 + val;
+		current.u64 = atom_cmpxchg((volatile __global ulong*)addr, expected.u64, next.u64);
+	} while(current.u64 != expected.u64);
+}
+
+#endif
+#endif // USE_INT64_ATOMICS
+
+
+/*
+ * Adds val of all work items in the sub-group with a single atomic.
+ * All work items of a sub-group need to call it, with the same addr.
+ */
+void atomic_add_g_f_uniform(volatile __global float* addr, float val)
+{
+#ifdef USE_SUBGROUPS
+	const float sum = sub_group_reduce_add(val);
+	if(get_sub_group_local_id() == 0) {
+		atomic_add_g_f(addr, sum);
+	}
+#else
+	atomic_add_g_f(addr, val);
+#endif
+}
+
+/*
+ * Returns a unique index for each work item with active == true, using a single atomic per sub-group.
+ * All work items of a sub-group need to call it, with the same counter.
+ */
+uint atomic_inc_g_aggregated(volatile __global uint* counter, const bool active)
+{
+#ifdef USE_SUBGROUPS
+	const uint flag = active ? 1 : 0;
+	const uint offset = sub_group_scan_exclusive_add(flag);
+	const uint total = sub_group_reduce_add(flag);
+	uint base = 0;
+	if(get_sub_group_local_id() == 0 && total > 0) {
+		base = atomic_add(counter, total);
+	}
+	return sub_group_broadcast(base, 0) + offset;
+#else
+	return active ? atomic_inc(counter) : 0;
+#endif
 }
 
+
+/*
+ * Privatized accumulation: clear bins in local memory, accumulate with atomic_add_l_f() / atomic_add(),
+ * then flush once per work group to global memory. All work items need to call clear and flush.
+ */
+void local_bins_clear_f(__local float* bins, const uint num)
+{
+	for(uint i = get_local_id(0); i < num; i += get_local_size(0)) {
+		bins[i] = 0;
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+}
+
+void local_bins_flush_f(__local const float* bins, volatile __global float* out, const uint num)
+{
+	barrier(CLK_LOCAL_MEM_FENCE);
+	for(uint i = get_local_id(0); i < num; i += get_local_size(0)) {
+		const float value = bins[i];
+		if(value != 0) {
+			atomic_add_g_f(out + i, value);
+		}
+	}
+}
+
+void local_bins_clear_i(__local uint* bins, const uint num)
+{
+	for(uint i = get_local_id(0); i < num; i += get_local_size(0)) {
+		bins[i] = 0;
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+}
+
+void local_bins_flush_i(__local const uint* bins, volatile __global uint* out, const uint num)
+{
+	barrier(CLK_LOCAL_MEM_FENCE);
+	for(uint i = get_local_id(0); i < num; i += get_local_size(0)) {
+		const uint value = bins[i];
+		if(value != 0) {
+			atomic_add(out + i, value);
+		}
+	}
+}
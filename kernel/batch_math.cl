@@ -0,0 +1,373 @@
+/*
+ * Batched small matrix math, see BatchMath.h
+ *
+ * Matrices are column major like Matrix<float, Rows, Cols>, batch index b, element i.
+ * Default layout is AoS (matrix after matrix), with BATCH_SOA element i of all matrices
+ * is stored contiguously instead, for coalesced access.
+ */
+
+#include "math.cl"
+
+#ifdef BATCH_SOA
+#define BATCH_AT(ptr, size, num, b, i) ptr[(i) * (num) + (b)]
+#else
+#define BATCH_AT(ptr, size, num, b, i) ptr[(b) * (size) + (i)]
+#endif
+
+
+void batch_load(__global const float* ptr, const uint size, const uint num, const uint b, float* out)
+{
+#ifdef BATCH_SOA
+	for(uint i = 0; i < size; ++i) {
+		out[i] = BATCH_AT(ptr, size, num, b, i);
+	}
+#else
+	// size is constant at every call site, so only the matching vector loads remain
+	__global const float* src = ptr + b * size;
+	uint i = 0;
+	for(; i + 16 <= size; i += 16) {
+		vstore16(vload16(0, src + i), 0, out + i);
+	}
+	if(i + 8 <= size) {
+		vstore8(vload8(0, src + i), 0, out + i);
+		i += 8;
+	}
+	if(i + 4 <= size) {
+		vstore4(vload4(0, src + i), 0, out + i);
+		i += 4;
+	}
+	for(; i < size; ++i) {
+		out[i] = src[i];
+	}
+#endif
+}
+
+void batch_store(__global float* ptr, const uint size, const uint num, const uint b, const float* in)
+{
+#ifdef BATCH_SOA
+	for(uint i = 0; i < size; ++i) {
+		BATCH_AT(ptr, size, num, b, i) = in[i];
+	}
+#else
+	__global float* dst = ptr + b * size;
+	uint i = 0;
+	for(; i + 16 <= size; i += 16) {
+		vstore16(vload16(0, in + i), 0, dst + i);
+	}
+	if(i + 8 <= size) {
+		vstore8(vload8(0, in + i), 0, dst + i);
+		i += 8;
+	}
+	if(i + 4 <= size) {
+		vstore4(vload4(0, in + i), 0, dst + i);
+		i += 4;
+	}
+	for(; i < size; ++i) {
+		dst[i] = in[i];
+	}
+#endif
+}
+
+float3 batch_load_3(__global const float* ptr, const uint num, const uint b)
+{
+#ifdef BATCH_SOA
+	return (float3)(ptr[b], ptr[num + b], ptr[2 * num + b]);
+#else
+	return vload3(b, ptr);
+#endif
+}
+
+void batch_store_3(__global float* ptr, const uint num, const uint b, const float3 value)
+{
+#ifdef BATCH_SOA
+	ptr[b] = value.x;
+	ptr[num + b] = value.y;
+	ptr[2 * num + b] = value.z;
+#else
+	vstore3(value, b, ptr);
+#endif
+}
+
+
+void inverse_44(float* Y, const float* A)
+{
+	float inv[16];
+	inv[0] = A[5] * A[10] * A[15] - A[5] * A[11] * A[14] - A[9] * A[6] * A[15] + A[9] * A[7] * A[14] + A[13] * A[6] * A[11] - A[13] * A[7] * A[10];
+	inv[4] = -A[4] * A[10] * A[15] + A[4] * A[11] * A[14] + A[8] * A[6] * A[15] - A[8] * A[7] * A[14] - A[12] * A[6] * A[11] + A[12] * A[7] * A[10];
+	inv[8] = A[4] * A[9] * A[15] - A[4] * A[11] * A[13] - A[8] * A[5] * A[15] + A[8] * A[7] * A[13] + A[12] * A[5] * A[11] - A[12] * A[7] * A[9];
+	inv[12] = -A[4] * A[9] * A[14] + A[4] * A[10] * A[13] + A[8] * A[5] * A[14] - A[8] * A[6] * A[13] - A[12] * A[5] * A[10] + A[12] * A[6] * A[9];
+	inv[1] = -A[1] * A[10] * A[15] + A[1] * A[11] * A[14] + A[9] * A[2] * A[15] - A[9] * A[3] * A[14] - A[13] * A[2] * A[11] + A[13] * A[3] * A[10];
+	inv[5] = A[0] * A[10] * A[15] - A[0] * A[11] * A[14] - A[8] * A[2] * A[15] + A[8] * A[3] * A[14] + A[12] * A[2] * A[11] - A[12] * A[3] * A[10];
+	inv[9] = -A[0] * A[9] * A[15] + A[0] * A[11] * A[13] + A[8] * A[1] * A[15] - A[8] * A[3] * A[13] - A[12] * A[1] * A[11] + A[12] * A[3] * A[9];
+	inv[13] = A[0] * A[9] * A[14] - A[0] * A[10] * A[13] - A[8] * A[1] * A[14] + A[8] * A[2] * A[13] + A[12] * A[1] * A[10] - A[12] * A[2] * A[9];
+	inv[2] = A[1] * A[6] * A[15] - A[1] * A[7] * A[14] - A[5] * A[2] * A[15] + A[5] * A[3] * A[14] + A[13] * A[2] * A[7] - A[13] * A[3] * A[6];
+	inv[6] = -A[0] * A[6] * A[15] + A[0] * A[7] * A[14] + A[4] * A[2] * A[15] - A[4] * A[3] * A[14] - A[12] * A[2] * A[7] + A[12] * A[3] * A[6];
+	inv[10] = A[0] * A[5] * A[15] - A[0] * A[7] * A[13] - A[4] * A[1] * A[15] + A[4] * A[3] * A[13] + A[12] * A[1] * A[7] - A[12] * A[3] * A[5];
+	inv[14] = -A[0] * A[5] * A[14] + A[0] * A[6] * A[13] + A[4] * A[1] * A[14] - A[4] * A[2] * A[13] - A[12] * A[1] * A[6] + A[12] * A[2] * A[5];
+	inv[3] = -A[1] * A[6] * A[11] + A[1] * A[7] * A[10] + A[5] * A[2] * A[11] - A[5] * A[3] * A[10] - A[9] * A[2] * A[7] + A[9] * A[3] * A[6];
+	inv[7] = A[0] * A[6] * A[11] - A[0] * A[7] * A[10] - A[4] * A[2] * A[11] + A[4] * A[3] * A[10] + A[8] * A[2] * A[7] - A[8] * A[3] * A[6];
+	inv[11] = -A[0] * A[5] * A[11] + A[0] * A[7] * A[9] + A[4] * A[1] * A[11] - A[4] * A[3] * A[9] - A[8] * A[1] * A[7] + A[8] * A[3] * A[5];
+	inv[15] = A[0] * A[5] * A[10] - A[0] * A[6] * A[9] - A[4] * A[1] * A[10] + A[4] * A[2] * A[9] + A[8] * A[1] * A[6] - A[8] * A[2] * A[5];
+
+	const float inv_det = 1.f / (A[0] * inv[0] + A[1] * inv[4] + A[2] * inv[8] + A[3] * inv[12]);
+	for(int i = 0; i < 16; ++i) {
+		Y[i] = inv[i] * inv_det;
+	}
+}
+
+/*
+ * Eigen decomposition of symmetric A (cyclic Jacobi), values in descending order,
+ * eigen vectors as columns of V.
+ */
+void eigen_sym_33(float* values, float* V, const float* A)
+{
+	float a[3][3];
+	float v[3][3];
+	for(int r = 0; r < 3; ++r) {
+		for(int c = 0; c < 3; ++c) {
+			a[r][c] = A[c * 3 + r];
+			v[r][c] = r == c ? 1 : 0;
+		}
+	}
+	for(int sweep = 0; sweep < 8; ++sweep) {
+		for(int pair = 0; pair < 3; ++pair) {
+			const int p = pair == 2 ? 1 : 0;
+			const int q = pair == 0 ? 1 : 2;
+			const float apq = a[p][q];
+			if(fabs(apq) < 1e-30f) {
+				continue;
+			}
+			const float theta = (a[q][q] - a[p][p]) / (2 * apq);
+			const float t = (theta >= 0 ? 1 : -1) / (fabs(theta) + sqrt(theta * theta + 1));
+			const float c = rsqrt(t * t + 1);
+			const float s = t * c;
+			for(int k = 0; k < 3; ++k) {
+				const float akp = a[k][p];
+				const float akq = a[k][q];
+				a[k][p] = c * akp - s * akq;
+				a[k][q] = s * akp + c * akq;
+			}
+			for(int k = 0; k < 3; ++k) {
+				const float apk = a[p][k];
+				const float aqk = a[q][k];
+				a[p][k] = c * apk - s * aqk;
+				a[q][k] = s * apk + c * aqk;
+			}
+			for(int k = 0; k < 3; ++k) {
+				const float vkp = v[k][p];
+				const float vkq = v[k][q];
+				v[k][p] = c * vkp - s * vkq;
+				v[k][q] = s * vkp + c * vkq;
+			}
+		}
+	}
+	int order[3] = {0, 1, 2};
+	for(int i = 0; i < 2; ++i) {
+		for(int j = i + 1; j < 3; ++j) {
+			if(a[order[j]][order[j]] > a[order[i]][order[i]]) {
+				const int tmp = order[i];
+				order[i] = order[j];
+				order[j] = tmp;
+			}
+		}
+	}
+	for(int i = 0; i < 3; ++i) {
+		values[i] = a[order[i]][order[i]];
+		for(int r = 0; r < 3; ++r) {
+			V[i * 3 + r] = v[r][order[i]];
+		}
+	}
+}
+
+float3 any_orthogonal(const float3 u)
+{
+	return normalize(cross(u, fabs(u.x) < 0.9f ? (float3)(1, 0, 0) : (float3)(0, 1, 0)));
+}
+
+/*
+ * A = U * diag(S) * V^T, with S in descending order, via eigen decomposition of A^T * A.
+ */
+void svd_33(float* U, float* S, float* V, const float* A)
+{
+	float AtA[9];
+	mul_NM_T_K(3, 3, 3, AtA, A, A);
+
+	float values[3];
+	eigen_sym_33(values, V, AtA);
+
+	float3 u[3];
+	for(int i = 0; i < 3; ++i) {
+		S[i] = sqrt(fmax(values[i], 0.f));
+		u[i] = mul_33_3(A, vload3(i, V));
+	}
+	const float eps = 1e-6f * S[0];
+	u[0] = S[0] > 0 ? u[0] / S[0] : (float3)(1, 0, 0);
+	u[1] = S[1] > eps ? u[1] / S[1] : any_orthogonal(u[0]);
+	u[2] = S[2] > eps ? u[2] / S[2] : cross(u[0], u[1]);
+	for(int i = 0; i < 3; ++i) {
+		vstore3(u[i], i, U);
+	}
+}
+
+/*
+ * Solves A * x = b for symmetric positive definite A (6x6), x is NaN otherwise.
+ */
+void cholesky_solve_66(float* x, const float* A, const float* b)
+{
+	float L[6][6];
+	for(int j = 0; j < 6; ++j) {
+		float sum = A[j * 6 + j];
+		for(int k = 0; k < j; ++k) {
+			sum -= L[j][k] * L[j][k];
+		}
+		L[j][j] = sqrt(sum);
+		const float inv = 1.f / L[j][j];
+		for(int i = j + 1; i < 6; ++i) {
+			float tmp = A[j * 6 + i];
+			for(int k = 0; k < j; ++k) {
+				tmp -= L[i][k] * L[j][k];
+			}
+			L[i][j] = tmp * inv;
+		}
+	}
+	float y[6];
+	for(int i = 0; i < 6; ++i) {
+		float sum = b[i];
+		for(int k = 0; k < i; ++k) {
+			sum -= L[i][k] * y[k];
+		}
+		y[i] = sum / L[i][i];
+	}
+	for(int i = 5; i >= 0; --i) {
+		float sum = y[i];
+		for(int k = i + 1; k < 6; ++k) {
+			sum -= L[k][i] * x[k];
+		}
+		x[i] = sum / L[i][i];
+	}
+}
+
+
+__kernel
+void batch_inverse_33(__global const float* A, __global float* Y, const uint num)
+{
+	const uint b = get_global_id(0);
+	if(b < num) {
+		float a[9];
+		float y[9];
+		batch_load(A, 9, num, b, a);
+		inverse_33(y, a);
+		batch_store(Y, 9, num, b, y);
+	}
+}
+
+__kernel
+void batch_inverse_44(__global const float* A, __global float* Y, const uint num)
+{
+	const uint b = get_global_id(0);
+	if(b < num) {
+		float a[16];
+		float y[16];
+		batch_load(A, 16, num, b, a);
+		inverse_44(y, a);
+		batch_store(Y, 16, num, b, y);
+	}
+}
+
+/*
+ * Converts 2D poses (x, y, theta) to 3x3 homogeneous transforms.
+ */
+__kernel
+void batch_pose2_to_matrix(__global const float* poses, __global float* Y, const uint num)
+{
+	const uint b = get_global_id(0);
+	if(b < num) {
+		float y[9];
+		transform2(y, batch_load_3(poses, num, b));
+		batch_store(Y, 9, num, b, y);
+	}
+}
+
+/*
+ * out = T * (p, 1) with T being 3x4, num_T is 1 to apply the same T to all points.
+ */
+__kernel
+void batch_transform_34(__global const float* T, const uint num_T, __global const float* points, __global float* out, const uint num)
+{
+	const uint b = get_global_id(0);
+	if(b < num) {
+		float t[12];
+		batch_load(T, 12, num_T, num_T > 1 ? b : 0, t);
+		batch_store_3(out, num, b, mul_34_3(t, batch_load_3(points, num, b)));
+	}
+}
+
+__kernel
+void batch_eigen_sym_33(__global const float* A, __global float* values, __global float* vectors, const uint num)
+{
+	const uint b = get_global_id(0);
+	if(b < num) {
+		float a[9];
+		float v[9];
+		float e[3];
+		batch_load(A, 9, num, b, a);
+		eigen_sym_33(e, v, a);
+		batch_store(values, 3, num, b, e);
+		batch_store(vectors, 9, num, b, v);
+	}
+}
+
+__kernel
+void batch_svd_33(__global const float* A, __global float* U, __global float* S, __global float* V, const uint num)
+{
+	const uint b = get_global_id(0);
+	if(b < num) {
+		float a[9];
+		float u[9];
+		float s[3];
+		float v[9];
+		batch_load(A, 9, num, b, a);
+		svd_33(u, s, v, a);
+		batch_store(U, 9, num, b, u);
+		batch_store(S, 3, num, b, s);
+		batch_store(V, 9, num, b, v);
+	}
+}
+
+__kernel
+void batch_cholesky_solve_66(__global const float* A, __global const float* B, __global float* X, const uint num)
+{
+	const uint b = get_global_id(0);
+	if(b < num) {
+		float a[36];
+		float y[6];
+		float x[6];
+		batch_load(A, 36, num, b, a);
+		batch_load(B, 6, num, b, y);
+		cholesky_solve_66(x, a, y);
+		batch_store(X, 6, num, b, x);
+	}
+}
+
+/*
+ * Converts between AoS and SoA layout, size is the number of elements per matrix.
+ */
+__kernel
+void batch_aos_to_soa(__global const float* in, __global float* out, const uint size, const uint num)
+{
+	const uint b = get_global_id(0);
+	const uint i = get_global_id(1);
+	if(b < num && i < size) {
+		out[i * num + b] = in[b * size + i];
+	}
+}
+
+__kernel
+void batch_soa_to_aos(__global const float* in, __global float* out, const uint size, const uint num)
+{
+	const uint b = get_global_id(0);
+	const uint i = get_global_id(1);
+	if(b < num && i < size) {
+		out[b * size + i] = in[i * num + b];
+	}
+}
@@ -0,0 +1,46 @@
+/*
+ * Stable stream compaction, see Compaction.h
+ *
+ * Requires COMPACT_T and bool compact_predicate(const COMPACT_T x) to be defined before.
+ */
+
+
+__kernel
+void compact_flags(__global const COMPACT_T* in, __global uint* flags, const uint num)
+{
+	const uint i = get_global_id(0);
+	if(i < num) {
+		flags[i] = compact_predicate(in[i]) ? 1 : 0;
+	}
+}
+
+
+/*
+ * offsets is the exclusive scan of flags, count[0] receives the number of elements kept.
+ */
+__kernel
+void compact_scatter(	__global const COMPACT_T* in, __global const uint* offsets, __global COMPACT_T* out,
+						__global uint* count, const uint num)
+{
+	const uint i = get_global_id(0);
+	if(i < num) {
+		const COMPACT_T value = in[i];
+		const bool keep = compact_predicate(value);
+		if(keep) {
+			out[offsets[i]] = value;
+		}
+		if(i == num - 1) {
+			count[0] = offsets[i] + (keep ? 1 : 0);
+		}
+	}
+}
+
+
+/*
+ * Size of COMPACT_T on the device, to validate the host type.
+ */
+__kernel
+void compact_type_size(__global uint* out)
+{
+	out[0] = sizeof(COMPACT_T);
+}
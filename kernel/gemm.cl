@@ -0,0 +1,122 @@
+/*
+ * Batched matrix multiplication Y = op(A) * op(B), see BatchedGemm.h
+ *
+ * Matrices are stored column major like Matrix<T, Rows, Cols>, op(A) is N x M, op(B) is M x K.
+ * Required: GEMM_N, GEMM_M, GEMM_K
+ * Optional: GEMM_DOUBLE, GEMM_TRANS_A, GEMM_TRANS_B
+ */
+
+#ifdef GEMM_DOUBLE
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+typedef double T;
+#else
+typedef float T;
+#endif
+
+#ifdef GEMM_TRANS_A
+#define A_AT(r, c) A[(r) * GEMM_M + (c)]
+#else
+#define A_AT(r, c) A[(c) * GEMM_N + (r)]
+#endif
+
+#ifdef GEMM_TRANS_B
+#define B_AT(r, c) B[(r) * GEMM_K + (c)]
+#else
+#define B_AT(r, c) B[(c) * GEMM_M + (r)]
+#endif
+
+#define GEMM_TS 16				// tile size
+#define GEMM_WPT 4				// outputs per work item
+#define GEMM_RTS (GEMM_TS / GEMM_WPT)
+
+
+/*
+ * Tiled version for larger matrices.
+ * Local size is (GEMM_TS, GEMM_RTS, 1), each work item computes GEMM_WPT outputs of one row.
+ * A stride of zero broadcasts the same matrix to all batch elements.
+ */
+__kernel
+__attribute__((reqd_work_group_size(GEMM_TS, GEMM_RTS, 1)))
+void gemm_tiled(__global const T* A, __global const T* B, __global T* Y, const uint a_stride, const uint b_stride)
+{
+	const uint batch = get_global_id(2);
+	A += batch * a_stride;
+	B += batch * b_stride;
+	Y += batch * (GEMM_N * GEMM_K);
+
+	const uint local_x = get_local_id(0);
+	const uint local_y = get_local_id(1);
+	const uint row = get_group_id(0) * GEMM_TS + local_x;
+	const uint col = get_group_id(1) * GEMM_TS + local_y;
+
+	__local T tile_a[GEMM_TS][GEMM_TS];		// [k][row]
+	__local T tile_b[GEMM_TS][GEMM_TS];		// [col][k]
+
+	T acc[GEMM_WPT];
+	for(uint w = 0; w < GEMM_WPT; ++w) {
+		acc[w] = 0;
+	}
+
+	for(uint t = 0; t < GEMM_M; t += GEMM_TS) {
+		for(uint w = 0; w < GEMM_WPT; ++w) {
+			const uint k = t + local_y + w * GEMM_RTS;
+			tile_a[local_y + w * GEMM_RTS][local_x] = (row < GEMM_N && k < GEMM_M) ? A_AT(row, k) : 0;
+
+			const uint c = col + w * GEMM_RTS;
+			const uint kb = t + local_x;
+			tile_b[local_y + w * GEMM_RTS][local_x] = (kb < GEMM_M && c < GEMM_K) ? B_AT(kb, c) : 0;
+		}
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		for(uint k = 0; k < GEMM_TS; ++k) {
+			const T a = tile_a[k][local_x];
+			for(uint w = 0; w < GEMM_WPT; ++w) {
+				acc[w] += a * tile_b[local_y + w * GEMM_RTS][k];
+			}
+		}
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	for(uint w = 0; w < GEMM_WPT; ++w) {
+		const uint c = col + w * GEMM_RTS;
+		if(row < GEMM_N && c < GEMM_K) {
+			Y[c * GEMM_N + row] = acc[w];
+		}
+	}
+}
+
+
+/*
+ * Version for small matrices, one work item per batch element, all in registers.
+ */
+__kernel
+void gemm_small(__global const T* A, __global const T* B, __global T* Y, const uint a_stride, const uint b_stride, const uint num)
+{
+	const uint batch = get_global_id(0);
+	if(batch >= num) {
+		return;
+	}
+	A += batch * a_stride;
+	B += batch * b_stride;
+	Y += batch * (GEMM_N * GEMM_K);
+
+	T a[GEMM_N * GEMM_M];
+	for(uint c = 0; c < GEMM_M; ++c) {
+		for(uint r = 0; r < GEMM_N; ++r) {
+			a[c * GEMM_N + r] = A_AT(r, c);
+		}
+	}
+	for(uint c = 0; c < GEMM_K; ++c) {
+		T b[GEMM_M];
+		for(uint k = 0; k < GEMM_M; ++k) {
+			b[k] = B_AT(k, c);
+		}
+		for(uint r = 0; r < GEMM_N; ++r) {
+			T sum = 0;
+			for(uint k = 0; k < GEMM_M; ++k) {
+				sum += a[k * GEMM_N + r] * b[k];
+			}
+			Y[c * GEMM_N + r] = sum;
+		}
+	}
+}
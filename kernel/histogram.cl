@@ -0,0 +1,98 @@
+/*
+ * Histogram / voxel grid accumulation, see Histogram.h
+ *
+ * Mode: HIST_COUNT (uint), HIST_SUM_F (float) or HIST_SUM_I (int)
+ * Points are float4 with xyz as coordinates and w as value.
+ */
+
+#include "atomics.cl"
+
+#if defined(HIST_SUM_F)
+typedef float T;
+#define HIST_VALUE(p) ((p).w)
+#define HIST_ADD_GLOBAL(addr, value) atomic_add_g_f(addr, value)
+#define HIST_ADD_LOCAL(addr, value) atomic_add_l_f(addr, value)
+#define HIST_CLEAR_LOCAL(bins, num) local_bins_clear_f(bins, num)
+#define HIST_FLUSH_LOCAL(bins, out, num) local_bins_flush_f(bins, out, num)
+#elif defined(HIST_SUM_I)
+typedef int T;
+#define HIST_VALUE(p) convert_int_rte((p).w)
+#define HIST_ADD_GLOBAL(addr, value) atomic_add(addr, value)
+#define HIST_ADD_LOCAL(addr, value) atomic_add(addr, value)
+#define HIST_CLEAR_LOCAL(bins, num) local_bins_clear_i((__local uint*)(bins), num)
+#define HIST_FLUSH_LOCAL(bins, out, num) local_bins_flush_i((__local const uint*)(bins), (volatile __global uint*)(out), num)
+#else
+typedef uint T;
+#define HIST_VALUE(p) 1u
+#define HIST_ADD_GLOBAL(addr, value) atomic_inc(addr)
+#define HIST_ADD_LOCAL(addr, value) atomic_inc(addr)
+#define HIST_CLEAR_LOCAL(bins, num) local_bins_clear_i(bins, num)
+#define HIST_FLUSH_LOCAL(bins, out, num) local_bins_flush_i(bins, out, num)
+#endif
+
+
+/*
+ * Returns the bin index (x fastest), or -1 if outside of the grid.
+ */
+int hist_get_bin(const float4 point, const float4 origin, const float4 scale, const uint4 size)
+{
+	const float4 f = floor((point - origin) * scale);
+	if(!(f.x >= 0 && f.y >= 0 && f.z >= 0 && f.x < size.x && f.y < size.y && f.z < size.z)) {
+		return -1;		// also for NaN
+	}
+	return (int)f.x + ((int)f.y + (int)f.z * size.y) * size.x;
+}
+
+
+/*
+ * Accumulates directly into global memory, for grids too large for local memory.
+ */
+__kernel
+void hist_global(	__global const float4* points, const uint num, const float4 origin, const float4 scale, const uint4 size,
+					__global T* bins)
+{
+	const uint i = get_global_id(0);
+	if(i < num) {
+		const float4 point = points[i];
+		const int bin = hist_get_bin(point, origin, scale, size);
+		if(bin >= 0) {
+			HIST_ADD_GLOBAL(bins + bin, HIST_VALUE(point));
+		}
+	}
+}
+
+
+/*
+ * Each work group accumulates a strided part of the points into a private copy of the grid
+ * in local memory, which is then added to global memory once.
+ */
+__kernel
+void hist_local(	__global const float4* points, const uint num, const float4 origin, const float4 scale, const uint4 size,
+					__global T* bins, __local T* local_bins)
+{
+	const uint num_bins = size.x * size.y * size.z;
+	HIST_CLEAR_LOCAL(local_bins, num_bins);
+
+	for(uint i = get_global_id(0); i < num; i += get_global_size(0)) {
+		const float4 point = points[i];
+		const int bin = hist_get_bin(point, origin, scale, size);
+		if(bin >= 0) {
+			HIST_ADD_LOCAL(local_bins + bin, HIST_VALUE(point));
+		}
+	}
+	HIST_FLUSH_LOCAL(local_bins, bins, num_bins);
+}
+
+
+/*
+ * bins[i] = bins[i] / count[i]
+ */
+__kernel
+void hist_mean_finish(__global float* bins, __global const uint* count, const uint num)
+{
+	const uint i = get_global_id(0);
+	if(i < num) {
+		const uint n = count[i];
+		bins[i] = n ? bins[i] / n : 0;
+	}
+}
@@ -0,0 +1,265 @@
+/*
+ * Stable LSD radix sort, see RadixSort.h
+ *
+ * Key type: RADIX_KEY_32 (uint) or RADIX_KEY_64 (ulong)
+ * Optional: RADIX_VALUE_T to move a payload along with the keys
+ *
+ * Each pass works on tiles of RADIX_TILE keys, one tile per work group of RADIX_LOCAL_SIZE work items:
+ * radix_count() writes the digit counts per tile, digit major, such that their exclusive scan
+ * yields the output offset of each (digit, tile). radix_scatter() then sorts each tile by digit
+ * in local memory and writes it out. Global memory is accessed in consecutive order by consecutive
+ * work items in both kernels, while order within a tile is kept, ie. the sort is stable.
+ */
+
+#if defined(RADIX_KEY_64)
+typedef ulong K;
+#define KEY_SIGN_BIT 0x8000000000000000ul
+#else
+typedef uint K;
+#define KEY_SIGN_BIT 0x80000000u
+#endif
+
+#define RADIX_BITS 4
+#define RADIX_SIZE 16
+#define RADIX_MASK 15
+
+#ifndef RADIX_LOCAL_SIZE
+#define RADIX_LOCAL_SIZE 128		// power of two, set by RadixSort
+#endif
+#define RADIX_ITEMS 4				// keys per work item and tile
+#define RADIX_TILE (RADIX_LOCAL_SIZE * RADIX_ITEMS)
+
+#define MODE_UNSIGNED 0
+#define MODE_SIGNED 1
+#define MODE_FLOAT 2
+
+
+/*
+ * Maps signed and floating point keys to unsigned keys of the same order.
+ */
+__kernel
+void radix_encode(__global K* keys, const uint num, const uint mode)
+{
+	const uint i = get_global_id(0);
+	if(i < num) {
+		const K key = keys[i];
+		if(mode == MODE_FLOAT) {
+			keys[i] = key ^ ((key & KEY_SIGN_BIT) ? ~(K)0 : KEY_SIGN_BIT);
+		} else if(mode == MODE_SIGNED) {
+			keys[i] = key ^ KEY_SIGN_BIT;
+		}
+	}
+}
+
+
+__kernel
+void radix_decode(__global K* keys, const uint num, const uint mode)
+{
+	const uint i = get_global_id(0);
+	if(i < num) {
+		const K key = keys[i];
+		if(mode == MODE_FLOAT) {
+			keys[i] = key ^ ((key & KEY_SIGN_BIT) ? KEY_SIGN_BIT : ~(K)0);
+		} else if(mode == MODE_SIGNED) {
+			keys[i] = key ^ KEY_SIGN_BIT;
+		}
+	}
+}
+
+
+/*
+ * Exclusive scan of data[RADIX_SIZE * RADIX_LOCAL_SIZE] in place, sums[RADIX_LOCAL_SIZE] is scratch.
+ */
+void radix_local_scan(__local uint* data, __local uint* sums)
+{
+	const uint local_id = get_local_id(0);
+	__local uint* chunk = data + local_id * RADIX_SIZE;
+
+	uint sum = 0;
+	for(uint k = 0; k < RADIX_SIZE; ++k) {
+		const uint value = chunk[k];
+		chunk[k] = sum;
+		sum += value;
+	}
+	sums[local_id] = sum;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for(uint offset = 1; offset < RADIX_LOCAL_SIZE; offset <<= 1) {
+		const uint value = local_id >= offset ? sums[local_id - offset] : 0;
+		barrier(CLK_LOCAL_MEM_FENCE);
+		sums[local_id] += value;
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+	const uint prefix = sums[local_id] - sum;
+	for(uint k = 0; k < RADIX_SIZE; ++k) {
+		chunk[k] += prefix;
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+}
+
+
+/*
+ * hist[digit * num_tiles + tile] = number of keys with digit in tile
+ */
+__kernel
+__attribute__((reqd_work_group_size(RADIX_LOCAL_SIZE, 1, 1)))
+void radix_count(__global const K* keys, const uint num, const uint shift, __global uint* hist)
+{
+	__local uint counts[RADIX_SIZE * RADIX_LOCAL_SIZE];
+
+	const uint local_id = get_local_id(0);
+	const uint tile = get_group_id(0);
+	const uint tile_begin = tile * RADIX_TILE;
+
+	uint count[RADIX_SIZE];
+	for(uint d = 0; d < RADIX_SIZE; ++d) {
+		count[d] = 0;
+	}
+	for(uint k = 0; k < RADIX_ITEMS; ++k) {
+		const uint i = tile_begin + k * RADIX_LOCAL_SIZE + local_id;
+		if(i < num) {
+			count[(keys[i] >> shift) & RADIX_MASK]++;
+		}
+	}
+	for(uint d = 0; d < RADIX_SIZE; ++d) {
+		counts[d * RADIX_LOCAL_SIZE + local_id] = count[d];
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	if(local_id < RADIX_SIZE) {
+		uint sum = 0;
+		for(uint k = 0; k < RADIX_LOCAL_SIZE; ++k) {
+			sum += counts[local_id * RADIX_LOCAL_SIZE + k];
+		}
+		hist[local_id * get_num_groups(0) + tile] = sum;
+	}
+}
+
+
+/*
+ * offsets is the exclusive scan of hist from radix_count()
+ */
+__kernel
+__attribute__((reqd_work_group_size(RADIX_LOCAL_SIZE, 1, 1)))
+void radix_scatter(	__global const K* keys_in, __global K* keys_out,
+#ifdef RADIX_VALUE_T
+					__global const RADIX_VALUE_T* values_in, __global RADIX_VALUE_T* values_out,
+#endif
+					const uint num, const uint shift, __global const uint* offsets)
+{
+	__local K tile_keys[RADIX_TILE];
+	__local ushort tile_index[RADIX_TILE];
+	__local uint counts[RADIX_SIZE * RADIX_LOCAL_SIZE];
+	__local uint sums[RADIX_LOCAL_SIZE];
+	__local uint digit_begin[RADIX_SIZE];		// within the sorted tile
+	__local uint digit_offset[RADIX_SIZE];		// in the output
+
+	const uint local_id = get_local_id(0);
+	const uint tile = get_group_id(0);
+	const uint tile_begin = tile * RADIX_TILE;
+	const uint tile_size = min((uint)RADIX_TILE, num - tile_begin);
+
+	for(uint k = 0; k < RADIX_ITEMS; ++k) {
+		const uint i = k * RADIX_LOCAL_SIZE + local_id;
+		if(i < tile_size) {
+			tile_keys[i] = keys_in[tile_begin + i];
+		}
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// each work item takes RADIX_ITEMS consecutive keys of the tile, to keep their order
+	K key[RADIX_ITEMS];
+	uint count[RADIX_SIZE];
+	for(uint d = 0; d < RADIX_SIZE; ++d) {
+		count[d] = 0;
+	}
+	for(uint k = 0; k < RADIX_ITEMS; ++k) {
+		const uint i = local_id * RADIX_ITEMS + k;
+		if(i < tile_size) {
+			key[k] = tile_keys[i];
+			count[(key[k] >> shift) & RADIX_MASK]++;
+		}
+	}
+	for(uint d = 0; d < RADIX_SIZE; ++d) {
+		counts[d * RADIX_LOCAL_SIZE + local_id] = count[d];
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	radix_local_scan(counts, sums);
+
+	if(local_id < RADIX_SIZE) {
+		digit_begin[local_id] = counts[local_id * RADIX_LOCAL_SIZE];
+		digit_offset[local_id] = offsets[local_id * get_num_groups(0) + tile];
+	}
+	for(uint d = 0; d < RADIX_SIZE; ++d) {
+		count[d] = counts[d * RADIX_LOCAL_SIZE + local_id];
+	}
+	for(uint k = 0; k < RADIX_ITEMS; ++k) {
+		const uint i = local_id * RADIX_ITEMS + k;
+		if(i < tile_size) {
+			const uint pos = count[(key[k] >> shift) & RADIX_MASK]++;
+			tile_keys[pos] = key[k];
+			tile_index[pos] = i;
+		}
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for(uint k = 0; k < RADIX_ITEMS; ++k) {
+		const uint i = k * RADIX_LOCAL_SIZE + local_id;
+		if(i < tile_size) {
+			const K value = tile_keys[i];
+			const uint digit = (value >> shift) & RADIX_MASK;
+			const uint dst = digit_offset[digit] + i - digit_begin[digit];
+			keys_out[dst] = value;
+#ifdef RADIX_VALUE_T
+			values_out[dst] = values_in[tile_begin + tile_index[i]];
+#endif
+		}
+	}
+}
+
+
+#ifdef RADIX_VALUE_T
+
+/*
+ * out[i] = in[index[i]]
+ */
+__kernel
+void radix_gather(__global const uint* index, __global const RADIX_VALUE_T* in, __global RADIX_VALUE_T* out, const uint num)
+{
+	const uint i = get_global_id(0);
+	if(i < num) {
+		out[i] = in[index[i]];
+	}
+}
+
+#endif
+
+
+#ifdef RADIX_KEY_64
+
+/*
+ * Builds 64-bit keys (segment << 32 | key) for segmented sort of encoded 32-bit keys.
+ */
+__kernel
+void radix_make_segmented(	__global const uint* keys, __global const uint* segments,
+							__global ulong* out, __global uint* index, const uint num)
+{
+	const uint i = get_global_id(0);
+	if(i < num) {
+		out[i] = (((ulong)segments[i]) << 32) | keys[i];
+		index[i] = i;
+	}
+}
+
+
+__kernel
+void radix_split_segmented(__global const ulong* in, __global uint* keys, const uint num)
+{
+	const uint i = get_global_id(0);
+	if(i < num) {
+		keys[i] = (uint)in[i];
+	}
+}
+
+#endif
@@ -0,0 +1,226 @@
+/*
+ * Device-wide reduction, see Reduction.h
+ *
+ * Type: REDUCE_FLOAT, REDUCE_DOUBLE, REDUCE_INT or REDUCE_UINT
+ * Operation: REDUCE_SUM, REDUCE_MIN, REDUCE_MAX, REDUCE_ARGMIN, REDUCE_ARGMAX or REDUCE_MEAN_VAR
+ * Optional: REDUCE_SUBGROUPS to use cl_khr_subgroups (SUM, MIN, MAX only)
+ *
+ * Local size must be a power of two.
+ */
+
+#if defined(REDUCE_DOUBLE)
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+typedef double T;
+typedef double4 T4;
+typedef double M;
+#define T_MAX DBL_MAX
+#define T_MIN (-DBL_MAX)
+#elif defined(REDUCE_INT)
+typedef int T;
+typedef int4 T4;
+typedef float M;
+#define T_MAX INT_MAX
+#define T_MIN INT_MIN
+#elif defined(REDUCE_UINT)
+typedef uint T;
+typedef uint4 T4;
+typedef float M;
+#define T_MAX UINT_MAX
+#define T_MIN 0
+#else
+typedef float T;
+typedef float4 T4;
+typedef float M;
+#define T_MAX FLT_MAX
+#define T_MIN (-FLT_MAX)
+#endif
+
+#if defined(REDUCE_SUBGROUPS) && (defined(REDUCE_SUM) || defined(REDUCE_MIN) || defined(REDUCE_MAX))
+#pragma OPENCL EXTENSION cl_khr_subgroups : enable
+#define USE_SUBGROUPS
+#endif
+
+
+#if defined(REDUCE_SUM)
+
+typedef T acc_t;
+
+acc_t acc_init() { return 0; }
+acc_t acc_load(const T x, const uint i) { return x; }
+acc_t acc_combine(const acc_t a, const acc_t b) { return a + b; }
+#define sub_group_reduce_acc sub_group_reduce_add
+
+#elif defined(REDUCE_MIN)
+
+typedef T acc_t;
+
+acc_t acc_init() { return T_MAX; }
+acc_t acc_load(const T x, const uint i) { return x; }
+acc_t acc_combine(const acc_t a, const acc_t b) { return min(a, b); }
+#define sub_group_reduce_acc sub_group_reduce_min
+
+#elif defined(REDUCE_MAX)
+
+typedef T acc_t;
+
+acc_t acc_init() { return T_MIN; }
+acc_t acc_load(const T x, const uint i) { return x; }
+acc_t acc_combine(const acc_t a, const acc_t b) { return max(a, b); }
+#define sub_group_reduce_acc sub_group_reduce_max
+
+#elif defined(REDUCE_ARGMIN) || defined(REDUCE_ARGMAX)
+
+typedef struct {
+	T value;
+	uint index;
+} acc_t;
+
+acc_t acc_init() {
+	acc_t res;
+#ifdef REDUCE_ARGMIN
+	res.value = T_MAX;
+#else
+	res.value = T_MIN;
+#endif
+	res.index = UINT_MAX;
+	return res;
+}
+
+acc_t acc_load(const T x, const uint i) {
+	acc_t res;
+	res.value = x;
+	res.index = i;
+	return res;
+}
+
+// lowest index wins on ties, so the result is deterministic
+acc_t acc_combine(const acc_t a, const acc_t b) {
+#ifdef REDUCE_ARGMIN
+	const bool take_b = b.value < a.value || (b.value == a.value && b.index < a.index);
+#else
+	const bool take_b = b.value > a.value || (b.value == a.value && b.index < a.index);
+#endif
+	return take_b ? b : a;
+}
+
+#elif defined(REDUCE_MEAN_VAR)
+
+typedef struct {
+	M mean;
+	M m2;			// sum of squared differences from mean
+	uint count;
+} acc_t;
+
+acc_t acc_init() {
+	acc_t res;
+	res.mean = 0;
+	res.m2 = 0;
+	res.count = 0;
+	return res;
+}
+
+acc_t acc_load(const T x, const uint i) {
+	acc_t res;
+	res.mean = x;
+	res.m2 = 0;
+	res.count = 1;
+	return res;
+}
+
+// parallel variant of Welford's algorithm (Chan et al.)
+acc_t acc_combine(const acc_t a, const acc_t b) {
+	if(a.count == 0) {
+		return b;
+	}
+	if(b.count == 0) {
+		return a;
+	}
+	acc_t res;
+	res.count = a.count + b.count;
+	const M delta = b.mean - a.mean;
+	const M weight = (M)b.count / res.count;
+	res.mean = a.mean + delta * weight;
+	res.m2 = a.m2 + b.m2 + delta * delta * a.count * weight;
+	return res;
+}
+
+#endif
+
+
+acc_t work_group_reduce(__local acc_t* data, acc_t acc)
+{
+	const uint local_x = get_local_id(0);
+#ifdef USE_SUBGROUPS
+	acc = sub_group_reduce_acc(acc);
+	if(get_sub_group_local_id() == 0) {
+		data[get_sub_group_id()] = acc;
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	if(local_x == 0) {
+		for(uint i = 1; i < get_num_sub_groups(); ++i) {
+			acc = acc_combine(acc, data[i]);
+		}
+	}
+	return acc;
+#else
+	data[local_x] = acc;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for(uint offset = get_local_size(0) / 2; offset > 0; offset /= 2) {
+		if(local_x < offset) {
+			data[local_x] = acc_combine(data[local_x], data[local_x + offset]);
+		}
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+	return data[0];
+#endif
+}
+
+
+/*
+ * First pass: each work group reduces a strided part of the input into out[group].
+ */
+__kernel
+void reduce_first(__global const T* in, const uint num, __global acc_t* out, __local acc_t* data)
+{
+	const uint stride = get_global_size(0) * 4;
+
+	acc_t acc = acc_init();
+	uint i = get_global_id(0) * 4;
+	while(i < num && num - i > 3) {
+		const T4 value = vload4(0, in + i);
+		acc = acc_combine(acc, acc_load(value.s0, i));
+		acc = acc_combine(acc, acc_load(value.s1, i + 1));
+		acc = acc_combine(acc, acc_load(value.s2, i + 2));
+		acc = acc_combine(acc, acc_load(value.s3, i + 3));
+		// i + stride would wrap around for num close to 2^32
+		i = num - i > stride ? i + stride : num;
+	}
+	for(; i < num; ++i) {
+		acc = acc_combine(acc, acc_load(in[i], i));
+	}
+
+	acc = work_group_reduce(data, acc);
+	if(get_local_id(0) == 0) {
+		out[get_group_id(0)] = acc;
+	}
+}
+
+
+/*
+ * Final pass, to be launched with a single work group.
+ */
+__kernel
+void reduce_final(__global const acc_t* in, const uint num, __global acc_t* out, __local acc_t* data)
+{
+	acc_t acc = acc_init();
+	for(uint i = get_local_id(0); i < num; i += get_local_size(0)) {
+		acc = acc_combine(acc, in[i]);
+	}
+
+	acc = work_group_reduce(data, acc);
+	if(get_local_id(0) == 0) {
+		out[0] = acc;
+	}
+}
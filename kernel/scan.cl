@@ -0,0 +1,102 @@
+/*
+ * Device-wide prefix sum, see Scan.h
+ *
+ * Type: SCAN_UINT, SCAN_INT or SCAN_FLOAT
+ *
+ * Each work item handles SCAN_ITEMS consecutive elements, a work group handles one block
+ * of get_local_size(0) * SCAN_ITEMS elements. Local size must be a power of two.
+ */
+
+#if defined(SCAN_INT)
+typedef int T;
+typedef int4 T4;
+#elif defined(SCAN_FLOAT)
+typedef float T;
+typedef float4 T4;
+#else
+typedef uint T;
+typedef uint4 T4;
+#endif
+
+#define SCAN_ITEMS 4
+
+
+/*
+ * Returns the exclusive prefix sum of value within the work group, total is the sum of all.
+ */
+T work_group_scan_exclusive(__local T* data, const T value, T* total)
+{
+	const uint local_x = get_local_id(0);
+	const uint local_width = get_local_size(0);
+
+	data[local_x] = value;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for(uint offset = 1; offset < local_width; offset *= 2) {
+		const T add = local_x >= offset ? data[local_x - offset] : 0;
+		barrier(CLK_LOCAL_MEM_FENCE);
+		data[local_x] += add;
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+	*total = data[local_width - 1];
+	const T res = local_x > 0 ? data[local_x - 1] : 0;
+	barrier(CLK_LOCAL_MEM_FENCE);		// data may be reused after return
+	return res;
+}
+
+
+/*
+ * Scans each block independently and stores the block totals in block_sums.
+ * in and out may be the same buffer.
+ */
+__kernel
+void scan_blocks(	__global const T* in, __global T* out, __global T* block_sums,
+					const uint num, const uint inclusive, __local T* data)
+{
+	const uint base = get_global_id(0) * SCAN_ITEMS;
+
+	T values[SCAN_ITEMS];
+	if(base + SCAN_ITEMS <= num) {
+		const T4 tmp = vload4(0, in + base);
+		values[0] = tmp.s0;
+		values[1] = tmp.s1;
+		values[2] = tmp.s2;
+		values[3] = tmp.s3;
+	} else {
+		for(uint k = 0; k < SCAN_ITEMS; ++k) {
+			values[k] = base + k < num ? in[base + k] : 0;
+		}
+	}
+
+	T sum = 0;
+	for(uint k = 0; k < SCAN_ITEMS; ++k) {
+		sum += values[k];
+	}
+
+	T total;
+	T prefix = work_group_scan_exclusive(data, sum, &total);
+
+	for(uint k = 0; k < SCAN_ITEMS && base + k < num; ++k) {
+		const T next = prefix + values[k];
+		out[base + k] = inclusive ? next : prefix;
+		prefix = next;
+	}
+	if(get_local_id(0) == 0) {
+		block_sums[get_group_id(0)] = total;
+	}
+}
+
+
+/*
+ * Adds the (exclusive scanned) block sums to the elements of each block.
+ */
+__kernel
+void add_block_offsets(__global T* out, __global const T* block_offsets, const uint num)
+{
+	const uint base = get_global_id(0) * SCAN_ITEMS;
+	const T offset = block_offsets[get_group_id(0)];
+
+	for(uint k = 0; k < SCAN_ITEMS && base + k < num; ++k) {
+		out[base + k] += offset;
+	}
+}
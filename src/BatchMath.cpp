@@ -0,0 +1,147 @@
+/*
+ * BatchMath.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#include <automy/basic_opencl/BatchMath.h>
+
+
+
+namespace automy {
+namespace basic_opencl {
+
+BatchMath::BatchMath(cl_context context, cl_device_id device, const std::string& kernel_path_, layout_e layout)
+	:	context(context), device(device), kernel_path(kernel_path_), layout(layout)
+{
+}
+
+std::shared_ptr<BatchMath> BatchMath::create(cl_context context, cl_device_id device, const std::string& kernel_path, layout_e layout)
+{
+	return std::make_shared<BatchMath>(context, device, kernel_path, layout);
+}
+
+std::shared_ptr<Kernel> BatchMath::get_kernel(const std::string& name)
+{
+	if(!program) {
+		auto program_ = Program::create(context, {"batch_math.cl"}, layout == SOA ? "-DBATCH_SOA" : "", {kernel_path}, binary_cache);
+		program_->build_or_throw({device});
+		program = program_;
+	}
+	auto& kernel = kernels[name];
+	if(!kernel) {
+		kernel = program->create_kernel(name);
+	}
+	return kernel;
+}
+
+void BatchMath::launch(std::shared_ptr<CommandQueue> queue, std::shared_ptr<Kernel> kernel, size_t num)
+{
+	if(num) {
+		kernel->enqueue_ceiled(queue, num, 64);
+	}
+}
+
+void BatchMath::inverse(std::shared_ptr<CommandQueue> queue, const Matrix<float, 3, 3>& A, Matrix<float, 3, 3>& Y)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Y.resize(context, A.depth());
+	auto kernel = get_kernel("batch_inverse_33");
+	kernel->set_args(A, Y, cl_uint(A.depth()));
+	launch(queue, kernel, A.depth());
+}
+
+void BatchMath::inverse(std::shared_ptr<CommandQueue> queue, const Matrix<float, 4, 4>& A, Matrix<float, 4, 4>& Y)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Y.resize(context, A.depth());
+	auto kernel = get_kernel("batch_inverse_44");
+	kernel->set_args(A, Y, cl_uint(A.depth()));
+	launch(queue, kernel, A.depth());
+}
+
+void BatchMath::pose2_to_matrix(std::shared_ptr<CommandQueue> queue, const Matrix<float, 3, 1>& poses, Matrix<float, 3, 3>& Y)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Y.resize(context, poses.depth());
+	auto kernel = get_kernel("batch_pose2_to_matrix");
+	kernel->set_args(poses, Y, cl_uint(poses.depth()));
+	launch(queue, kernel, poses.depth());
+}
+
+void BatchMath::transform(std::shared_ptr<CommandQueue> queue, const Matrix<float, 3, 4>& T, const Matrix<float, 3, 1>& points, Matrix<float, 3, 1>& out)
+{
+	if(T.depth() != 1 && T.depth() != points.depth()) {
+		throw std::logic_error("BatchMath::transform(): batch size mismatch");
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	out.resize(context, points.depth());
+	auto kernel = get_kernel("batch_transform_34");
+	kernel->set_args(T, cl_uint(T.depth()), points, out, cl_uint(points.depth()));
+	launch(queue, kernel, points.depth());
+}
+
+void BatchMath::eigen_sym(std::shared_ptr<CommandQueue> queue, const Matrix<float, 3, 3>& A, Matrix<float, 3, 1>& values, Matrix<float, 3, 3>& vectors)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	values.resize(context, A.depth());
+	vectors.resize(context, A.depth());
+	auto kernel = get_kernel("batch_eigen_sym_33");
+	kernel->set_args(A, values, vectors, cl_uint(A.depth()));
+	launch(queue, kernel, A.depth());
+}
+
+void BatchMath::svd(std::shared_ptr<CommandQueue> queue, const Matrix<float, 3, 3>& A,
+					Matrix<float, 3, 3>& U, Matrix<float, 3, 1>& S, Matrix<float, 3, 3>& V)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	U.resize(context, A.depth());
+	S.resize(context, A.depth());
+	V.resize(context, A.depth());
+	auto kernel = get_kernel("batch_svd_33");
+	kernel->set_args(A, U, S, V, cl_uint(A.depth()));
+	launch(queue, kernel, A.depth());
+}
+
+void BatchMath::cholesky_solve(std::shared_ptr<CommandQueue> queue, const Matrix<float, 6, 6>& A, const Matrix<float, 6, 1>& b, Matrix<float, 6, 1>& x)
+{
+	if(A.depth() != b.depth()) {
+		throw std::logic_error("BatchMath::cholesky_solve(): batch size mismatch");
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	x.resize(context, A.depth());
+	auto kernel = get_kernel("batch_cholesky_solve_66");
+	kernel->set_args(A, b, x, cl_uint(A.depth()));
+	launch(queue, kernel, A.depth());
+}
+
+void BatchMath::to_soa(std::shared_ptr<CommandQueue> queue, const Buffer3D<float>& in, Buffer3D<float>& out)
+{
+	convert(queue, "batch_aos_to_soa", in, out);
+}
+
+void BatchMath::to_aos(std::shared_ptr<CommandQueue> queue, const Buffer3D<float>& in, Buffer3D<float>& out)
+{
+	convert(queue, "batch_soa_to_aos", in, out);
+}
+
+void BatchMath::convert(std::shared_ptr<CommandQueue> queue, const std::string& name, const Buffer3D<float>& in, Buffer3D<float>& out)
+{
+	if(&in == &out) {
+		throw std::logic_error("BatchMath: in-place layout conversion not supported");
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	out.resize(context, in.width(), in.height(), in.depth());
+	const size_t size = in.width() * in.height();
+	if(!size || !in.depth()) {
+		return;
+	}
+	auto kernel = get_kernel(name);
+	kernel->set_args(in, out, cl_uint(size), cl_uint(in.depth()));
+	kernel->enqueue_ceiled_2D(queue, {{in.depth(), size}}, {{64, 1}});
+}
+
+
+} // basic_opencl
+} // automy
@@ -0,0 +1,85 @@
+/*
+ * BatchedGemm.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#include <automy/basic_opencl/BatchedGemm.h>
+
+#include <algorithm>
+
+
+namespace automy {
+namespace basic_opencl {
+
+static const size_t GEMM_TS = 16;		// see gemm.cl
+static const size_t GEMM_RTS = 4;
+static const size_t GEMM_SMALL = 8;
+
+BatchedGemm::BatchedGemm(cl_context context, cl_device_id device, const std::string& kernel_path_)
+	:	context(context), device(device), kernel_path(kernel_path_)
+{
+}
+
+std::shared_ptr<BatchedGemm> BatchedGemm::create(cl_context context, cl_device_id device, const std::string& kernel_path)
+{
+	return std::make_shared<BatchedGemm>(context, device, kernel_path);
+}
+
+size_t BatchedGemm::get_batch_size(size_t depth_a, size_t depth_b)
+{
+	if(depth_a != depth_b && depth_a != 1 && depth_b != 1) {
+		throw std::logic_error("BatchedGemm: batch size mismatch");
+	}
+	return std::max(depth_a, depth_b);
+}
+
+BatchedGemm::kernels_t BatchedGemm::get_kernels(const std::string& type, size_t N, size_t M, size_t K, bool trans_a, bool trans_b)
+{
+	std::string options = "-DGEMM_N=" + std::to_string(N) + " -DGEMM_M=" + std::to_string(M) + " -DGEMM_K=" + std::to_string(K);
+	if(type == "DOUBLE") {
+		options += " -DGEMM_DOUBLE";
+	}
+	if(trans_a) {
+		options += " -DGEMM_TRANS_A";
+	}
+	if(trans_b) {
+		options += " -DGEMM_TRANS_B";
+	}
+	auto& entry = kernels[options];
+	if(!entry.program) {
+		auto program = Program::create(context, {"gemm.cl"}, options, {kernel_path}, binary_cache);
+		program->build_or_throw({device});
+		entry.is_small = N <= GEMM_SMALL && M <= GEMM_SMALL && K <= GEMM_SMALL;
+		entry.kernel = program->create_kernel(entry.is_small ? "gemm_small" : "gemm_tiled");
+		entry.program = program;
+	}
+	return entry;
+}
+
+void BatchedGemm::gemm(	std::shared_ptr<CommandQueue> queue, const std::string& type, size_t N, size_t M, size_t K,
+						bool trans_a, bool trans_b, const Buffer& A, const Buffer& B, Buffer& Y, size_t depth_a, size_t depth_b)
+{
+	const size_t batch_size = get_batch_size(depth_a, depth_b);
+	if(!batch_size || !N || !K) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+
+	const auto kernels = get_kernels(type, N, M, K, trans_a, trans_b);
+	const cl_uint a_stride = depth_a > 1 ? N * M : 0;
+	const cl_uint b_stride = depth_b > 1 ? M * K : 0;
+
+	if(kernels.is_small) {
+		kernels.kernel->set_args(A, B, Y, a_stride, b_stride, cl_uint(batch_size));
+		kernels.kernel->enqueue_ceiled(queue, batch_size, 64);
+	} else {
+		kernels.kernel->set_args(A, B, Y, a_stride, b_stride);
+		kernels.kernel->enqueue_ceiled_3D(queue, {{N, (K + GEMM_RTS - 1) / GEMM_RTS, batch_size}}, {{GEMM_TS, GEMM_RTS, 1}});
+	}
+}
+
+
+} // basic_opencl
+} // automy
@@ -0,0 +1,295 @@
+/*
+ * BinaryCache.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#include <automy/basic_opencl/BinaryCache.h>
+
+#include <map>
+#include <cstdio>
+#include <ctime>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <direct.h>
+#include <process.h>
+#include <sys/utime.h>
+#else
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+
+namespace automy {
+namespace basic_opencl {
+
+static void hash_fnv1a(uint64_t& hash, const std::string& data)
+{
+	for(const char c : data) {
+		hash ^= uint8_t(c);
+		hash *= 0x100000001b3ull;
+	}
+	hash ^= 0xFF;			// separator, so that {"ab", "c"} != {"a", "bc"}
+	hash *= 0x100000001b3ull;
+}
+
+static std::vector<std::string> list_directory(const std::string& path)
+{
+	std::vector<std::string> files;
+#ifdef _WIN32
+	_finddata_t info;
+	const auto handle = _findfirst((path + "*").c_str(), &info);
+	if(handle != -1) {
+		do {
+			files.push_back(info.name);
+		} while(_findnext(handle, &info) == 0);
+		_findclose(handle);
+	}
+#else
+	if(DIR* dir = opendir(path.c_str())) {
+		while(dirent* entry = readdir(dir)) {
+			files.push_back(entry->d_name);
+		}
+		closedir(dir);
+	}
+#endif
+	return files;
+}
+
+static bool ends_with(const std::string& str, const std::string& suffix)
+{
+	return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/*
+ * Returns the file name of a line like '#include "file.cl"' or '#include <file.cl>', empty otherwise.
+ */
+static std::string parse_include(const std::string& line)
+{
+	size_t pos = line.find_first_not_of(" \t");
+	if(pos == std::string::npos || line[pos] != '#') {
+		return std::string();
+	}
+	pos = line.find_first_not_of(" \t", pos + 1);
+	if(pos == std::string::npos || line.compare(pos, 7, "include") != 0) {
+		return std::string();
+	}
+	pos = line.find_first_not_of(" \t", pos + 7);
+	if(pos == std::string::npos || (line[pos] != '"' && line[pos] != '<')) {
+		return std::string();
+	}
+	const auto end = line.find(line[pos] == '"' ? '"' : '>', pos + 1);
+	if(end == std::string::npos) {
+		return std::string();
+	}
+	return line.substr(pos + 1, end - pos - 1);
+}
+
+BinaryCache::BinaryCache(const std::string& path_, size_t max_size)
+	:	path(path_), max_size(max_size)
+{
+	if(!path.empty() && path.back() != '/' && path.back() != '\\') {
+		path += '/';
+	}
+#ifdef _WIN32
+	_mkdir(path.c_str());
+#else
+	mkdir(path.c_str(), 0755);
+#endif
+	remove_stale_tmp_files();
+}
+
+std::shared_ptr<BinaryCache> BinaryCache::create(const std::string& path, size_t max_size)
+{
+	return std::make_shared<BinaryCache>(path, max_size);
+}
+
+std::string BinaryCache::get_key(const std::vector<std::string>& sources, const std::string& options, cl_device_id device)
+{
+	const auto platform = get_device_platform(device);
+
+	auto data = sources;
+	data.push_back(options);
+	data.push_back(get_platform_name(platform));
+	data.push_back(get_platform_version(platform));
+	data.push_back(get_device_name(device));
+	data.push_back(get_device_version(device));
+	data.push_back(get_driver_version(device));
+	return get_hash(data);
+}
+
+std::string BinaryCache::get_hash(const std::vector<std::string>& data)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for(const auto& item : data) {
+		hash_fnv1a(hash, item);
+	}
+	std::ostringstream ss;
+	ss << std::hex << std::setw(16) << std::setfill('0') << hash;
+	return ss.str();
+}
+
+std::string BinaryCache::get_tmp_file_name(const std::string& file_name)
+{
+	static std::atomic<size_t> counter {0};
+#ifdef _WIN32
+	const auto pid = _getpid();
+#else
+	const auto pid = getpid();
+#endif
+	return file_name + ".tmp." + std::to_string(pid) + "." + std::to_string(counter++);
+}
+
+std::vector<std::string> BinaryCache::get_includes(const std::vector<std::string>& sources, const std::set<std::string>& include_paths)
+{
+	std::vector<std::string> search_dirs {""};
+	search_dirs.insert(search_dirs.end(), include_paths.begin(), include_paths.end());
+
+	std::vector<std::string> out;
+	std::set<std::string> visited;
+	std::vector<std::string> pending(sources.begin(), sources.end());
+	while(!pending.empty()) {
+		const auto source = std::move(pending.back());
+		pending.pop_back();
+
+		std::istringstream lines(source);
+		for(std::string line; std::getline(lines, line);) {
+			const auto name = parse_include(line);
+			if(name.empty()) {
+				continue;
+			}
+			for(const auto& dir : search_dirs) {
+				std::ifstream in(dir + name);
+				if(in.good()) {
+					if(visited.insert(dir + name).second) {
+						out.push_back(name);
+						out.push_back(std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()));
+						pending.push_back(out.back());
+					}
+					break;
+				}
+			}
+		}
+	}
+	return out;
+}
+
+std::string BinaryCache::get_file_name(const std::string& key) const
+{
+	return path + key + ".bin";
+}
+
+bool BinaryCache::load(const std::string& key, std::vector<unsigned char>& binary)
+{
+	const auto file_name = get_file_name(key);
+	std::ifstream in(file_name, std::ios::binary);
+	if(in.good()) {
+		binary.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+		if(!binary.empty()) {
+			utime(file_name.c_str(), nullptr);		// mark as recently used
+			return true;
+		}
+	}
+	return false;
+}
+
+void BinaryCache::store(const std::string& key, const std::vector<unsigned char>& binary)
+{
+	if(binary.empty() || binary.size() > max_size) {
+		return;
+	}
+	const auto file_name = get_file_name(key);
+	const auto tmp_name = get_tmp_file_name(file_name);
+	{
+		std::ofstream out(tmp_name, std::ios::binary | std::ios::trunc);
+		out.write((const char*)binary.data(), binary.size());
+		out.close();
+		if(!out.good()) {
+			std::remove(tmp_name.c_str());
+			return;
+		}
+	}
+	if(std::rename(tmp_name.c_str(), file_name.c_str())) {
+		std::remove(tmp_name.c_str());		// another writer was faster (Windows does not replace)
+	}
+	evict();
+}
+
+void BinaryCache::evict()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	size_t total_size = 0;
+	std::multimap<time_t, std::pair<std::string, size_t>> entries;
+	for(const auto& name : list_directory(path)) {
+		if(ends_with(name, ".bin")) {
+			struct stat info;
+			const auto file_name = path + name;
+			if(stat(file_name.c_str(), &info) == 0) {
+				entries.emplace(info.st_mtime, std::make_pair(file_name, size_t(info.st_size)));
+				total_size += info.st_size;
+			}
+		}
+	}
+	for(auto iter = entries.begin(); iter != entries.end() && total_size > max_size; ++iter) {
+		if(std::remove(iter->second.first.c_str()) == 0) {
+			total_size -= iter->second.second;
+		}
+	}
+}
+
+void BinaryCache::invalidate(const std::string& key)
+{
+	std::remove(get_file_name(key).c_str());
+}
+
+void BinaryCache::add_result(bool is_hit)
+{
+	if(is_hit) {
+		num_hits++;
+	} else {
+		num_misses++;
+	}
+}
+
+void BinaryCache::remove_stale_tmp_files()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	const time_t max_age = 3600;		// a writer in another process may still be active
+	const time_t now = std::time(nullptr);
+	for(const auto& name : list_directory(path)) {
+		if(name.find(".bin.tmp.") != std::string::npos) {
+			struct stat info;
+			const auto file_name = path + name;
+			if(stat(file_name.c_str(), &info) == 0 && info.st_mtime + max_age < now) {
+				std::remove(file_name.c_str());
+			}
+		}
+	}
+}
+
+void BinaryCache::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for(const auto& name : list_directory(path)) {
+		if(ends_with(name, ".bin") || name.find(".bin.tmp.") != std::string::npos) {
+			std::remove((path + name).c_str());
+		}
+	}
+}
+
+
+} // basic_opencl
+} // automy
@@ -0,0 +1,273 @@
+/*
+ * BufferPool.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#include <automy/basic_opencl/BufferPool.h>
+#include <automy/basic_opencl/DeviceInfo.h>
+
+#include <algorithm>
+
+
+namespace automy {
+namespace basic_opencl {
+
+BufferPool::BufferPool(cl_context context, cl_mem_flags flags)
+	:	context(context), flags(flags)
+{
+	if(cl_int err = clRetainContext(context)) {
+		throw opencl_error_t("clRetainContext() failed with " + get_error_string(err));
+	}
+}
+
+BufferPool::~BufferPool()
+{
+	// all buffers hold a reference to the pool, so everything is free by now
+	for(const auto& entry : pending) {
+		entry.event.wait();
+	}
+	collect_pending_locked();
+	trim(0);
+	clReleaseContext(context);
+}
+
+std::shared_ptr<BufferPool> BufferPool::create(cl_context context, cl_mem_flags flags)
+{
+	return std::make_shared<BufferPool>(context, flags);
+}
+
+void BufferPool::enable_slabs(size_t max_chunk_size, size_t slab_size_)
+{
+	size_t length = 0;
+	if(cl_int err = clGetContextInfo(context, CL_CONTEXT_DEVICES, 0, 0, &length)) {
+		throw opencl_error_t("clGetContextInfo(CL_CONTEXT_DEVICES) failed with " + get_error_string(err));
+	}
+	std::vector<cl_device_id> devices(length / sizeof(cl_device_id));
+	if(cl_int err = clGetContextInfo(context, CL_CONTEXT_DEVICES, devices.size() * sizeof(cl_device_id), devices.data(), &length)) {
+		throw opencl_error_t("clGetContextInfo(CL_CONTEXT_DEVICES) failed with " + get_error_string(err));
+	}
+	devices.resize(length / sizeof(cl_device_id));
+
+	size_t alignment = 1;
+	for(auto device : devices) {
+		alignment = std::max<size_t>(alignment, DeviceInfo::get(device)->mem_base_align);
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	slab_alignment = alignment;
+	slab_max_chunk = max_chunk_size;
+	slab_size = std::max(slab_size_, max_chunk_size);
+}
+
+size_t BufferPool::get_size_class(size_t num_bytes) const
+{
+	if(slab_max_chunk && num_bytes <= slab_max_chunk) {
+		size_t size = slab_alignment;
+		while(size < num_bytes) {
+			size *= 2;
+		}
+		return size;
+	}
+	const size_t min_size = 256;
+	if(num_bytes <= min_size) {
+		return min_size;
+	}
+	// four classes per power of two, wasting at most 25%
+	size_t msb = 1;
+	while(msb <= (num_bytes - 1) / 2) {
+		msb *= 2;
+	}
+	const size_t step = msb / 4;
+	return ((num_bytes + step - 1) / step) * step;
+}
+
+cl_mem BufferPool::create_buffer(size_t num_bytes)
+{
+	cl_int err = 0;
+	cl_mem data = clCreateBuffer(context, flags, num_bytes, nullptr, &err);
+	if(err == CL_MEM_OBJECT_ALLOCATION_FAILURE || err == CL_OUT_OF_RESOURCES) {
+		trim_locked(0);
+		data = clCreateBuffer(context, flags, num_bytes, nullptr, &err);
+	}
+	if(err) {
+		throw opencl_error_t("clCreateBuffer() failed with " + get_error_string(err));
+	}
+	return data;
+}
+
+void BufferPool::create_slab(size_t chunk_size)
+{
+	const size_t num_chunks = std::max<size_t>(slab_size / chunk_size, 1);
+	cl_mem parent = create_buffer(num_chunks * chunk_size);
+
+	slab_t& slab = slab_map[parent];
+	slab.chunk_size = chunk_size;
+	slab.num_free = num_chunks;
+	for(size_t i = 0; i < num_chunks; ++i) {
+		cl_buffer_region region;
+		region.origin = i * chunk_size;
+		region.size = chunk_size;
+		cl_int err = 0;
+		cl_mem chunk = clCreateSubBuffer(parent, 0, CL_BUFFER_CREATE_TYPE_REGION, &region, &err);
+		if(err) {
+			release_slab(parent);
+			throw opencl_error_t("clCreateSubBuffer() failed with " + get_error_string(err));
+		}
+		slab.chunks.push_back(chunk);
+		chunk_map[chunk] = parent;
+	}
+	auto& list = free_list[chunk_size];
+	list.insert(list.end(), slab.chunks.rbegin(), slab.chunks.rend());
+	stats.bytes_cached += num_chunks * chunk_size;
+}
+
+void BufferPool::release_slab(cl_mem parent)
+{
+	auto iter = slab_map.find(parent);
+	if(iter != slab_map.end()) {
+		for(auto chunk : iter->second.chunks) {
+			chunk_map.erase(chunk);
+			clReleaseMemObject(chunk);
+		}
+		slab_map.erase(iter);
+	}
+	clReleaseMemObject(parent);
+}
+
+cl_mem BufferPool::alloc(size_t num_bytes, size_t& capacity)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	collect_pending_locked();
+
+	capacity = get_size_class(num_bytes);
+	auto& list = free_list[capacity];
+	if(list.empty()) {
+		stats.num_misses++;
+		if(slab_max_chunk && capacity <= slab_max_chunk) {
+			create_slab(capacity);
+		} else {
+			cl_mem data = create_buffer(capacity);
+			stats.bytes_live += capacity;
+			return data;
+		}
+	} else {
+		stats.num_hits++;
+	}
+	cl_mem data = list.back();
+	list.pop_back();
+
+	auto iter = chunk_map.find(data);
+	if(iter != chunk_map.end()) {
+		slab_map[iter->second].num_free--;
+	}
+	stats.bytes_cached -= capacity;
+	stats.bytes_live += capacity;
+	return data;
+}
+
+void BufferPool::free(cl_mem data, size_t capacity)
+{
+	if(!data) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	free_locked(data, capacity);
+}
+
+void BufferPool::free(cl_mem data, size_t capacity, const Event& event)
+{
+	if(!data) {
+		return;
+	}
+	if(!event.is_valid() || event.is_complete()) {
+		free(data, capacity);
+		return;
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	pending_t entry;
+	entry.data = data;
+	entry.capacity = capacity;
+	entry.event = event;
+	pending.push_back(entry);
+	stats.bytes_live -= capacity;
+	stats.bytes_pending += capacity;
+}
+
+void BufferPool::free_locked(cl_mem data, size_t capacity)
+{
+	auto iter = chunk_map.find(data);
+	if(iter != chunk_map.end()) {
+		slab_map[iter->second].num_free++;
+	}
+	free_list[capacity].push_back(data);
+	stats.bytes_live -= capacity;
+	stats.bytes_cached += capacity;
+}
+
+void BufferPool::collect_pending_locked()
+{
+	for(auto iter = pending.begin(); iter != pending.end();) {
+		if(iter->event.is_complete()) {
+			stats.bytes_pending -= iter->capacity;
+			stats.bytes_live += iter->capacity;		// undone by free_locked()
+			free_locked(iter->data, iter->capacity);
+			iter = pending.erase(iter);
+		} else {
+			iter++;
+		}
+	}
+}
+
+void BufferPool::trim(size_t max_cached_bytes)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	collect_pending_locked();
+	trim_locked(max_cached_bytes);
+}
+
+void BufferPool::trim_locked(size_t max_cached_bytes)
+{
+	// release stand-alone buffers first, largest first
+	for(auto iter = free_list.rbegin(); iter != free_list.rend() && stats.bytes_cached > max_cached_bytes; ++iter) {
+		auto& list = iter->second;
+		for(auto entry = list.begin(); entry != list.end() && stats.bytes_cached > max_cached_bytes;) {
+			if(chunk_map.count(*entry)) {
+				entry++;
+			} else {
+				clReleaseMemObject(*entry);
+				stats.bytes_cached -= iter->first;
+				entry = list.erase(entry);
+			}
+		}
+	}
+	// then slabs which are completely unused
+	std::vector<cl_mem> unused;
+	for(const auto& entry : slab_map) {
+		if(entry.second.num_free == entry.second.chunks.size()) {
+			unused.push_back(entry.first);
+		}
+	}
+	for(auto parent : unused) {
+		if(stats.bytes_cached <= max_cached_bytes) {
+			break;
+		}
+		const auto& slab = slab_map[parent];
+		auto& list = free_list[slab.chunk_size];
+		for(auto chunk : slab.chunks) {
+			list.erase(std::find(list.begin(), list.end(), chunk));
+		}
+		stats.bytes_cached -= slab.chunks.size() * slab.chunk_size;
+		release_slab(parent);
+	}
+}
+
+BufferPool::stats_t BufferPool::get_stats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+
+} // basic_opencl
+} // automy
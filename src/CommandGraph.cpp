@@ -0,0 +1,540 @@
+/*
+ * CommandGraph.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#include <automy/basic_opencl/CommandGraph.h>
+
+#include <cstring>
+
+
+namespace automy {
+namespace basic_opencl {
+
+/*
+ * cl_khr_command_buffer entry points, loaded at runtime since the extension is provisional
+ * and not declared by all headers. Only commands whose signature is stable across revisions are used.
+ */
+typedef void* command_buffer_khr_t;
+
+typedef command_buffer_khr_t (CL_API_CALL *clCreateCommandBufferKHR_t)(
+		cl_uint num_queues, const cl_command_queue* queues, const cl_ulong* properties, cl_int* errcode_ret);
+
+typedef cl_int (CL_API_CALL *clFinalizeCommandBufferKHR_t)(command_buffer_khr_t command_buffer);
+
+typedef cl_int (CL_API_CALL *clReleaseCommandBufferKHR_t)(command_buffer_khr_t command_buffer);
+
+typedef cl_int (CL_API_CALL *clEnqueueCommandBufferKHR_t)(
+		cl_uint num_queues, cl_command_queue* queues, command_buffer_khr_t command_buffer,
+		cl_uint num_events_in_wait_list, const cl_event* event_wait_list, cl_event* event);
+
+typedef cl_int (CL_API_CALL *clCommandNDRangeKernelKHR_t)(
+		command_buffer_khr_t command_buffer, cl_command_queue command_queue, const cl_ulong* properties,
+		cl_kernel kernel, cl_uint work_dim, const size_t* global_work_offset, const size_t* global_work_size,
+		const size_t* local_work_size, cl_uint num_sync_points_in_wait_list, const cl_uint* sync_point_wait_list,
+		cl_uint* sync_point, void** mutable_handle);
+
+/*
+ * cl_khr_command_buffer_mutable_dispatch, array based clUpdateMutableCommandsKHR() since revision 0.9.3
+ */
+typedef cl_int (CL_API_CALL *clUpdateMutableCommandsKHR_t)(
+		command_buffer_khr_t command_buffer, cl_uint num_configs, const cl_uint* config_types, const void** configs);
+
+struct mutable_dispatch_arg_t {
+	cl_uint arg_index = 0;
+	size_t arg_size = 0;
+	const void* arg_value = nullptr;
+};
+
+struct mutable_dispatch_config_t {
+	void* command = nullptr;
+	cl_uint num_args = 0;
+	cl_uint num_svm_args = 0;
+	cl_uint num_exec_infos = 0;
+	cl_uint work_dim = 0;
+	const mutable_dispatch_arg_t* arg_list = nullptr;
+	const mutable_dispatch_arg_t* arg_svm_list = nullptr;
+	const void* exec_info_list = nullptr;
+	const size_t* global_work_offset = nullptr;
+	const size_t* global_work_size = nullptr;
+	const size_t* local_work_size = nullptr;
+};
+
+#ifndef CL_DEVICE_EXTENSIONS_WITH_VERSION
+#define CL_DEVICE_EXTENSIONS_WITH_VERSION 0x1060
+#endif
+
+// cl_khr_command_buffer
+#ifndef CL_DEVICE_COMMAND_BUFFER_CAPABILITIES_KHR
+#define CL_DEVICE_COMMAND_BUFFER_CAPABILITIES_KHR 0x12A9
+#endif
+#ifndef CL_COMMAND_BUFFER_CAPABILITY_SIMULTANEOUS_USE_KHR
+#define CL_COMMAND_BUFFER_CAPABILITY_SIMULTANEOUS_USE_KHR (1 << 2)
+#endif
+#ifndef CL_COMMAND_BUFFER_FLAGS_KHR
+#define CL_COMMAND_BUFFER_FLAGS_KHR 0x1293
+#endif
+#ifndef CL_COMMAND_BUFFER_SIMULTANEOUS_USE_KHR
+#define CL_COMMAND_BUFFER_SIMULTANEOUS_USE_KHR (1 << 0)
+#endif
+
+// cl_khr_command_buffer_mutable_dispatch
+#ifndef CL_COMMAND_BUFFER_MUTABLE_KHR
+#define CL_COMMAND_BUFFER_MUTABLE_KHR (1 << 1)
+#endif
+#ifndef CL_DEVICE_MUTABLE_DISPATCH_CAPABILITIES_KHR
+#define CL_DEVICE_MUTABLE_DISPATCH_CAPABILITIES_KHR 0x12B0
+#endif
+#ifndef CL_MUTABLE_DISPATCH_UPDATABLE_FIELDS_KHR
+#define CL_MUTABLE_DISPATCH_UPDATABLE_FIELDS_KHR 0x12B1
+#endif
+#ifndef CL_MUTABLE_DISPATCH_ARGUMENTS_KHR
+#define CL_MUTABLE_DISPATCH_ARGUMENTS_KHR (1 << 2)
+#endif
+#ifndef CL_STRUCTURE_TYPE_MUTABLE_DISPATCH_CONFIG_KHR
+#define CL_STRUCTURE_TYPE_MUTABLE_DISPATCH_CONFIG_KHR 0
+#endif
+
+static const cl_uint mutable_dispatch_min_version = (0 << 22) | (9 << 12) | 3;		// 0.9.3
+
+static const size_t num_native_slots = 2;
+
+/*
+ * Returns the version of extension as reported by CL_DEVICE_EXTENSIONS_WITH_VERSION, 0 if not available.
+ */
+static cl_uint get_extension_version(cl_device_id device, const std::string& extension)
+{
+	struct name_version_t {
+		cl_uint version;
+		char name[64];
+	};
+	size_t size = 0;
+	if(clGetDeviceInfo(device, CL_DEVICE_EXTENSIONS_WITH_VERSION, 0, nullptr, &size) || !size) {
+		return 0;		// OpenCL < 3.0
+	}
+	std::vector<name_version_t> list(size / sizeof(name_version_t));
+	if(clGetDeviceInfo(device, CL_DEVICE_EXTENSIONS_WITH_VERSION, list.size() * sizeof(name_version_t), list.data(), nullptr)) {
+		return 0;
+	}
+	for(const auto& entry : list) {
+		if(extension == std::string(entry.name, ::strnlen(entry.name, sizeof(entry.name)))) {
+			return entry.version;
+		}
+	}
+	return 0;
+}
+
+struct CommandGraph::native_slot_t {
+	command_buffer_khr_t command_buffer = nullptr;
+	std::vector<void*> commands;			// mutable handle per node
+	uint64_t version = 0;					// args_version when recorded or last patched
+	Event event;							// last submit
+};
+
+struct CommandGraph::native_t {
+	bool supported = false;
+	bool simultaneous_use = false;
+	bool mutable_args = false;
+	cl_device_id device = nullptr;
+	cl_command_queue queue = nullptr;
+	std::vector<native_slot_t> slots;
+	clCreateCommandBufferKHR_t create = nullptr;
+	clFinalizeCommandBufferKHR_t finalize = nullptr;
+	clReleaseCommandBufferKHR_t release = nullptr;
+	clEnqueueCommandBufferKHR_t enqueue = nullptr;
+	clCommandNDRangeKernelKHR_t nd_range_kernel = nullptr;
+	clUpdateMutableCommandsKHR_t update = nullptr;
+};
+
+CommandGraph::CommandGraph()
+{
+}
+
+CommandGraph::~CommandGraph()
+{
+	release_native();
+}
+
+std::shared_ptr<CommandGraph> CommandGraph::create()
+{
+	return std::make_shared<CommandGraph>();
+}
+
+CommandGraph::node_t CommandGraph::add_kernel_nd(	std::shared_ptr<Kernel> kernel, const cl_uint dims,
+													const size_t* global_size, const size_t* local_size)
+{
+	node_info_t node;
+	node.type = NODE_KERNEL;
+	node.kernel = kernel;
+	node.args = kernel->get_arg_values();
+	node.dims = dims;
+	for(cl_uint i = 0; i < dims; ++i) {
+		if(local_size[i]) {
+			node.have_local = true;
+		}
+	}
+	for(cl_uint i = 0; i < dims; ++i) {
+		if(node.have_local) {
+			if(!local_size[i]) {
+				throw std::logic_error("CommandGraph: local_size == 0 for kernel '" + kernel->get_name() + "'");
+			}
+			node.local_size[i] = local_size[i];
+			node.global_size[i] = global_size[i] + (local_size[i] - (global_size[i] % local_size[i])) % local_size[i];
+		} else {
+			node.global_size[i] = global_size[i];
+		}
+	}
+	nodes.push_back(node);
+	native_valid = false;
+	return nodes.size() - 1;
+}
+
+CommandGraph::node_t CommandGraph::add_kernel(std::shared_ptr<Kernel> kernel, const size_t& global_size, const size_t& local_size)
+{
+	return add_kernel_nd(kernel, 1, &global_size, &local_size);
+}
+
+CommandGraph::node_t CommandGraph::add_kernel_2D(	std::shared_ptr<Kernel> kernel, const std::array<size_t, 2>& global_size,
+													const std::array<size_t, 2>& local_size)
+{
+	return add_kernel_nd(kernel, 2, global_size.data(), local_size.data());
+}
+
+CommandGraph::node_t CommandGraph::add_kernel_3D(	std::shared_ptr<Kernel> kernel, const std::array<size_t, 3>& global_size,
+													const std::array<size_t, 3>& local_size)
+{
+	return add_kernel_nd(kernel, 3, global_size.data(), local_size.data());
+}
+
+CommandGraph::node_t CommandGraph::add_copy(const Buffer& src, const Buffer& dst, size_t num_bytes, size_t src_offset, size_t dst_offset)
+{
+	node_info_t node;
+	node.type = NODE_COPY;
+	node.src = src.data();
+	node.dst = dst.data();
+	node.num_bytes = num_bytes;
+	node.src_offset = src_offset;
+	node.dst_offset = dst_offset;
+	nodes.push_back(node);
+	native_valid = false;
+	return nodes.size() - 1;
+}
+
+CommandGraph::node_t CommandGraph::add_fill(const Buffer& dst, const void* pattern, size_t pattern_size, size_t num_bytes, size_t offset)
+{
+	node_info_t node;
+	node.type = NODE_FILL;
+	node.dst = dst.data();
+	node.num_bytes = num_bytes;
+	node.dst_offset = offset;
+	node.pattern.assign((const char*)pattern, ((const char*)pattern) + pattern_size);
+	nodes.push_back(node);
+	native_valid = false;
+	return nodes.size() - 1;
+}
+
+std::shared_ptr<Kernel> CommandGraph::get_kernel(node_t node) const
+{
+	if(node >= nodes.size() || nodes[node].type != NODE_KERNEL) {
+		throw std::logic_error("CommandGraph: node " + std::to_string(node) + " is not a kernel launch");
+	}
+	return nodes[node].kernel;
+}
+
+void CommandGraph::set_arg_bytes(node_t node, const cl_uint arg, const size_t size, const void* value)
+{
+	get_kernel(node);
+	for(auto& entry : nodes[node].args) {
+		if(entry.index == arg) {
+			if(entry.kind == Kernel::ARG_LOCAL) {
+				throw std::logic_error("CommandGraph: cannot patch __local argument " + std::to_string(arg)
+						+ " of kernel '" + nodes[node].kernel->get_name() + "'");
+			}
+			if(entry.size != size || ::memcmp(entry.bytes.data(), value, size) != 0) {
+				entry.size = size;
+				entry.bytes.assign((const char*)value, ((const char*)value) + size);
+				nodes[node].version = ++args_version;
+			}
+			return;
+		}
+	}
+	throw std::logic_error("CommandGraph: no such argument " + std::to_string(arg) + " in kernel '" + nodes[node].kernel->get_name() + "'");
+}
+
+void CommandGraph::clear()
+{
+	nodes.clear();
+	release_native();
+}
+
+void CommandGraph::enqueue_node(std::shared_ptr<CommandQueue> queue, node_info_t& node, const EventList* wait_list, cl_event* event)
+{
+	if(node.type == NODE_KERNEL) {
+		node.kernel->set_arg_values(node.args);
+		node.kernel->enqueue_nd(queue, node.dims, node.global_size, node.have_local ? node.local_size : nullptr, wait_list, event);
+		return;
+	}
+	Event tmp;
+	if(!event) {
+		event = queue->get_event(tmp);
+	}
+	const cl_uint num_events = wait_list ? wait_list->size() : 0;
+	const cl_event* events = wait_list ? wait_list->data() : nullptr;
+	if(node.type == NODE_COPY) {
+		if(cl_int err = clEnqueueCopyBuffer(queue->get(), node.src, node.dst, node.src_offset, node.dst_offset, node.num_bytes,
+				num_events, events, event))
+		{
+			throw opencl_error_t("clEnqueueCopyBuffer() failed with " + get_error_string(err));
+		}
+	} else {
+		if(cl_int err = clEnqueueFillBuffer(queue->get(), node.dst, node.pattern.data(), node.pattern.size(), node.dst_offset, node.num_bytes,
+				num_events, events, event))
+		{
+			throw opencl_error_t("clEnqueueFillBuffer() failed with " + get_error_string(err));
+		}
+	}
+	if(queue->get_profiler() && event) {
+		queue->record(Event(*event, true), node.type == NODE_COPY ? Profiler::COPY : Profiler::FILL, node.num_bytes);
+	}
+}
+
+Event CommandGraph::replay_loop(std::shared_ptr<CommandQueue> queue, const std::vector<Event>& wait_list)
+{
+	if(nodes.empty()) {
+		return queue->enqueue_marker(wait_list);
+	}
+	Event event;
+	const EventList list(wait_list);
+	const bool chain = queue->is_out_of_order();
+	for(size_t i = 0; i < nodes.size(); ++i) {
+		if(chain && i > 0) {
+			const Event prev = event;
+			const EventList prev_list(std::vector<Event>{prev});
+			enqueue_node(queue, nodes[i], &prev_list, event.reset());
+		} else {
+			const bool is_last = i + 1 == nodes.size();
+			enqueue_node(queue, nodes[i], i == 0 ? &list : nullptr, (chain || is_last) ? event.reset() : nullptr);
+		}
+	}
+	return event;
+}
+
+void CommandGraph::release_native()
+{
+	if(native) {
+		for(auto& slot : native->slots) {
+			if(slot.command_buffer) {
+				native->release(slot.command_buffer);
+			}
+		}
+		native->slots.clear();
+		native->queue = nullptr;
+	}
+	native_valid = false;
+}
+
+bool CommandGraph::record_native(native_slot_t& slot)
+{
+	if(slot.command_buffer) {
+		native->release(slot.command_buffer);
+		slot.command_buffer = nullptr;
+	}
+	slot.commands.assign(nodes.size(), nullptr);
+	slot.event = Event();
+
+	cl_ulong flags = 0;
+	if(native->simultaneous_use) {
+		flags |= CL_COMMAND_BUFFER_SIMULTANEOUS_USE_KHR;
+	}
+	if(native->mutable_args) {
+		flags |= CL_COMMAND_BUFFER_MUTABLE_KHR;
+	}
+	const cl_ulong properties[] = {CL_COMMAND_BUFFER_FLAGS_KHR, flags, 0};
+
+	cl_int err = 0;
+	auto command_buffer = native->create(1, &native->queue, flags ? properties : nullptr, &err);
+	if((err || !command_buffer) && flags) {
+		native->simultaneous_use = false;		// flags not supported by this revision
+		native->mutable_args = false;
+		command_buffer = native->create(1, &native->queue, nullptr, &err);
+	}
+	if(err || !command_buffer) {
+		native->supported = false;		// eg. queue properties not supported
+		return false;
+	}
+	slot.command_buffer = command_buffer;
+
+	const cl_ulong command_properties[] = {CL_MUTABLE_DISPATCH_UPDATABLE_FIELDS_KHR, CL_MUTABLE_DISPATCH_ARGUMENTS_KHR, 0};
+
+	cl_uint sync_point = 0;
+	for(size_t i = 0; i < nodes.size(); ++i) {
+		auto& node = nodes[i];
+		node.kernel->set_arg_values(node.args);		// captured by the command
+		cl_uint next_sync_point = 0;
+		err = native->nd_range_kernel(command_buffer, nullptr, native->mutable_args ? command_properties : nullptr,
+				node.kernel->get(), node.dims, nullptr, node.global_size, node.have_local ? node.local_size : nullptr,
+				i > 0 ? 1 : 0, i > 0 ? &sync_point : nullptr, &next_sync_point,
+				native->mutable_args ? &slot.commands[i] : nullptr);
+		if(err) {
+			break;
+		}
+		sync_point = next_sync_point;
+	}
+	if(!err) {
+		err = native->finalize(command_buffer);
+	}
+	if(err) {
+		release_native();
+		native->supported = false;
+		return false;
+	}
+	slot.version = args_version;
+	return true;
+}
+
+bool CommandGraph::patch_native(native_slot_t& slot)
+{
+	std::vector<std::vector<mutable_dispatch_arg_t>> args;
+	std::vector<mutable_dispatch_config_t> configs;
+	args.reserve(nodes.size());
+	configs.reserve(nodes.size());
+	for(size_t i = 0; i < nodes.size(); ++i) {
+		const auto& node = nodes[i];
+		if(node.version <= slot.version) {
+			continue;
+		}
+		if(!slot.commands[i]) {
+			return false;
+		}
+		args.emplace_back();
+		for(const auto& entry : node.args) {
+			if(entry.kind != Kernel::ARG_LOCAL) {
+				mutable_dispatch_arg_t arg;
+				arg.arg_index = entry.index;
+				arg.arg_size = entry.size;
+				arg.arg_value = entry.bytes.data();
+				args.back().push_back(arg);
+			}
+		}
+		mutable_dispatch_config_t config;
+		config.command = slot.commands[i];
+		config.num_args = args.back().size();
+		config.arg_list = args.back().data();
+		configs.push_back(config);
+	}
+	const std::vector<cl_uint> types(configs.size(), CL_STRUCTURE_TYPE_MUTABLE_DISPATCH_CONFIG_KHR);
+	std::vector<const void*> list;
+	for(const auto& config : configs) {
+		list.push_back(&config);
+	}
+	if(!configs.empty() && native->update(slot.command_buffer, list.size(), types.data(), list.data())) {
+		return false;
+	}
+	slot.version = args_version;
+	return true;
+}
+
+bool CommandGraph::update_native(native_slot_t& slot)
+{
+	if(slot.command_buffer && slot.version == args_version) {
+		return true;
+	}
+	if(slot.command_buffer && native->mutable_args && patch_native(slot)) {
+		return true;
+	}
+	return record_native(slot);
+}
+
+bool CommandGraph::replay_native(std::shared_ptr<CommandQueue> queue, const std::vector<Event>& wait_list, Event& event)
+{
+	if(queue->get_profiler()) {
+		return false;		// keep per kernel timing
+	}
+	for(const auto& node : nodes) {
+		if(node.type != NODE_KERNEL) {
+			return false;
+		}
+	}
+	if(!native || native->device != queue->get_device()) {
+		release_native();
+		native = std::make_shared<native_t>();
+		native->device = queue->get_device();
+		if(has_device_extension(native->device, "cl_khr_command_buffer")) {
+			const auto platform = get_device_platform(native->device);
+			native->create = (clCreateCommandBufferKHR_t)clGetExtensionFunctionAddressForPlatform(platform, "clCreateCommandBufferKHR");
+			native->finalize = (clFinalizeCommandBufferKHR_t)clGetExtensionFunctionAddressForPlatform(platform, "clFinalizeCommandBufferKHR");
+			native->release = (clReleaseCommandBufferKHR_t)clGetExtensionFunctionAddressForPlatform(platform, "clReleaseCommandBufferKHR");
+			native->enqueue = (clEnqueueCommandBufferKHR_t)clGetExtensionFunctionAddressForPlatform(platform, "clEnqueueCommandBufferKHR");
+			native->nd_range_kernel = (clCommandNDRangeKernelKHR_t)clGetExtensionFunctionAddressForPlatform(platform, "clCommandNDRangeKernelKHR");
+			native->supported = native->create && native->finalize && native->release && native->enqueue && native->nd_range_kernel;
+
+			cl_ulong capabilities = 0;
+			if(!clGetDeviceInfo(native->device, CL_DEVICE_COMMAND_BUFFER_CAPABILITIES_KHR, sizeof(capabilities), &capabilities, nullptr)) {
+				native->simultaneous_use = capabilities & CL_COMMAND_BUFFER_CAPABILITY_SIMULTANEOUS_USE_KHR;
+			}
+			if(get_extension_version(native->device, "cl_khr_command_buffer_mutable_dispatch") >= mutable_dispatch_min_version) {
+				cl_ulong fields = 0;
+				native->update = (clUpdateMutableCommandsKHR_t)clGetExtensionFunctionAddressForPlatform(platform, "clUpdateMutableCommandsKHR");
+				native->mutable_args = native->update
+						&& !clGetDeviceInfo(native->device, CL_DEVICE_MUTABLE_DISPATCH_CAPABILITIES_KHR, sizeof(fields), &fields, nullptr)
+						&& (fields & CL_MUTABLE_DISPATCH_ARGUMENTS_KHR);
+			}
+		}
+	}
+	if(!native->supported) {
+		return false;
+	}
+	if(!native_valid || native->queue != queue->get()) {
+		release_native();
+		native->queue = queue->get();
+		native->slots.resize(num_native_slots);
+		native_valid = true;
+	}
+
+	// prefer an up to date command buffer, a pending one can only be re-submitted with simultaneous use
+	native_slot_t* slot = nullptr;
+	for(auto& entry : native->slots) {
+		if(entry.command_buffer && entry.version == args_version
+			&& (native->simultaneous_use || !entry.event.is_valid() || entry.event.is_complete()))
+		{
+			slot = &entry;
+			break;
+		}
+	}
+	if(!slot) {
+		for(auto& entry : native->slots) {
+			if(!entry.event.is_valid() || entry.event.is_complete()) {
+				slot = &entry;
+				break;
+			}
+		}
+	}
+	if(!slot) {
+		return false;		// all pending, enqueue one by one meanwhile
+	}
+	if(!update_native(*slot)) {
+		return false;
+	}
+	const EventList list(wait_list);
+	if(cl_int err = native->enqueue(1, &native->queue, slot->command_buffer, list.size(), list.data(), event.reset())) {
+		throw opencl_error_t("clEnqueueCommandBufferKHR() failed with " + get_error_string(err));
+	}
+	slot->event = event;
+	return true;
+}
+
+Event CommandGraph::replay(std::shared_ptr<CommandQueue> queue, const std::vector<Event>& wait_list)
+{
+	Event event;
+	last_native = replay_native(queue, wait_list, event);
+	if(!last_native) {
+		event = replay_loop(queue, wait_list);
+	}
+	return event;
+}
+
+
+} // basic_opencl
+} // automy
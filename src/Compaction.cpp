@@ -0,0 +1,82 @@
+/*
+ * Compaction.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#include <automy/basic_opencl/Compaction.h>
+
+#include <algorithm>
+
+
+namespace automy {
+namespace basic_opencl {
+
+Compaction::Compaction(std::shared_ptr<Scan> scan, const std::string& kernel_path, const std::string& type_name, const std::string& predicate)
+	:	scan(scan)
+{
+	program = Program::create(scan->get_context(), {"compact.cl"}, "", {kernel_path}, scan->binary_cache, nullptr,
+			"#define COMPACT_T " + type_name + "\n"
+			"bool compact_predicate(const COMPACT_T x) {\n"
+			"	return (" + predicate + ");\n"
+			"}\n");
+	program->build_or_throw({scan->get_device()});
+	flags_kernel = program->create_kernel("compact_flags");
+	scatter_kernel = program->create_kernel("compact_scatter");
+
+	const size_t max_local_size = std::min<size_t>(std::min(
+			flags_kernel->get_max_work_group_size(scan->get_device()),
+			scatter_kernel->get_max_work_group_size(scan->get_device())), 256);
+	while(local_size * 2 <= max_local_size) {
+		local_size *= 2;
+	}
+}
+
+std::shared_ptr<Compaction> Compaction::create(	std::shared_ptr<Scan> scan, const std::string& kernel_path,
+												const std::string& type_name, const std::string& predicate)
+{
+	return std::make_shared<Compaction>(scan, kernel_path, type_name, predicate);
+}
+
+Event Compaction::compact(	std::shared_ptr<CommandQueue> queue, const Buffer& in, Buffer& out, Buffer1D<cl_uint>& count,
+							size_t num, size_t type_size_, const std::vector<Event>& wait_list)
+{
+	if(num > 0xFFFFFFFF) {
+		throw std::logic_error("Compaction: input too large");
+	}
+	if(&in == &out) {
+		throw std::logic_error("Compaction: in-place not supported");
+	}
+	if(!type_size) {
+		Buffer1D<cl_uint> result(scan->get_context(), 1);
+		auto kernel = program->create_kernel("compact_type_size");
+		kernel->set_args(result);
+		const std::vector<Event> kernel_done = {kernel->enqueue(queue, 1, 1, std::vector<Event>())};
+		cl_uint value = 0;
+		result.download(queue, &value, kernel_done).wait();
+		type_size = value;
+	}
+	if(type_size_ != type_size) {
+		throw std::logic_error("Compaction: element size mismatch, sizeof(T) = " + std::to_string(type_size_)
+				+ " but " + std::to_string(type_size) + " bytes on the device");
+	}
+	if(!num) {
+		return count.set_zero(queue, wait_list);
+	}
+	auto offsets = Buffer1D<cl_uint>::create(scan->get_scratch_pool(), num);
+
+	flags_kernel->set_args(in, *offsets, cl_uint(num));
+	auto event = flags_kernel->enqueue_ceiled(queue, num, local_size, wait_list);
+
+	event = scan->scan(queue, "UINT", sizeof(cl_uint), *offsets, *offsets, num, false, {event});
+
+	scatter_kernel->set_args(in, *offsets, out, count, cl_uint(num));
+	event = scatter_kernel->enqueue_ceiled(queue, num, local_size, {event});
+	event.set_callback([offsets](cl_int) {});		// keeps offsets alive until finished
+	return event;
+}
+
+
+} // basic_opencl
+} // automy
@@ -6,8 +6,12 @@
  */
 
 #include <automy/basic_opencl/Context.h>
+#include <automy/basic_opencl/DeviceInfo.h>
+#include <automy/basic_opencl/BufferPool.h>
+#include <automy/basic_opencl/Program.h>
 
 #include <mutex>
+#include <algorithm>
 
 
 namespace automy {
@@ -16,9 +20,7 @@ namespace basic_opencl {
 std::vector<cl_platform_id> get_platforms()
 {
 	cl_uint num_platforms = 0;
-	std::vector<cl_platform_id> platforms(16);
-
-	if(cl_int err = clGetPlatformIDs(platforms.size(), platforms.data(), &num_platforms))
+	if(cl_int err = clGetPlatformIDs(0, nullptr, &num_platforms))
 	{
 #ifdef cl_khr_icd
 		if(err != CL_PLATFORM_NOT_FOUND_KHR)
@@ -28,8 +30,15 @@ std::vector<cl_platform_id> get_platforms()
 		{
 			throw opencl_error_t("clGetPlatformIDs() failed with: " + get_error_string(err));
 		}
+		return {};
+	}
+	std::vector<cl_platform_id> platforms(num_platforms);
+	if(num_platforms) {
+		if(cl_int err = clGetPlatformIDs(platforms.size(), platforms.data(), &num_platforms)) {
+			throw opencl_error_t("clGetPlatformIDs() failed with: " + get_error_string(err));
+		}
 	}
-	platforms.resize(num_platforms);
+	platforms.resize(std::min<size_t>(num_platforms, platforms.size()));
 	return platforms;
 }
 
@@ -42,6 +51,15 @@ std::string get_platform_name(cl_platform_id platform)
 	return std::string(name);
 }
 
+std::string get_platform_version(cl_platform_id platform)
+{
+	char version[1024] = {};
+	if(cl_int err = clGetPlatformInfo(platform, CL_PLATFORM_VERSION, sizeof(version), version, 0)) {
+		throw opencl_error_t("clGetPlatformInfo(CL_PLATFORM_VERSION) failed with " + get_error_string(err));
+	}
+	return std::string(version);
+}
+
 cl_platform_id find_platform_by_name(const std::string& name)
 {
 	for(auto platform : get_platforms()) {
@@ -76,13 +94,19 @@ void release_context(cl_context& context)
 std::vector<cl_device_id> get_devices(cl_platform_id platform, cl_device_type device_type)
 {
 	cl_uint num_devices = 0;
-	std::vector<cl_device_id> device_list(256);
-	if(cl_int err = clGetDeviceIDs(platform, device_type, device_list.size(), device_list.data(), &num_devices)) {
+	if(cl_int err = clGetDeviceIDs(platform, device_type, 0, nullptr, &num_devices)) {
 		if(err != CL_DEVICE_NOT_FOUND) {
 			throw opencl_error_t("clGetDeviceIDs() failed with: " + get_error_string(err));
 		}
+		return {};
+	}
+	std::vector<cl_device_id> device_list(num_devices);
+	if(num_devices) {
+		if(cl_int err = clGetDeviceIDs(platform, device_type, device_list.size(), device_list.data(), &num_devices)) {
+			throw opencl_error_t("clGetDeviceIDs() failed with: " + get_error_string(err));
+		}
 	}
-	device_list.resize(num_devices);
+	device_list.resize(std::min<size_t>(num_devices, device_list.size()));
 	return device_list;
 }
 
@@ -97,24 +121,212 @@ cl_device_id get_device(cl_platform_id platform, cl_device_type device_type, cl_
 
 std::string get_device_name(cl_device_id device_id)
 {
-	char dev_name[256] = {};
-	size_t dev_name_len = 0;
-	if(cl_int err = clGetDeviceInfo(device_id, CL_DEVICE_NAME, sizeof(dev_name), dev_name, &dev_name_len)) {
-		throw opencl_error_t("clGetDeviceInfo() failed with " + get_error_string(err));
+	return DeviceInfo::get(device_id)->name;
+}
+
+std::string get_device_version(cl_device_id device_id)
+{
+	return DeviceInfo::get(device_id)->version;
+}
+
+std::string get_driver_version(cl_device_id device_id)
+{
+	return DeviceInfo::get(device_id)->driver_version;
+}
+
+std::string get_device_extensions(cl_device_id device_id)
+{
+	std::string list;
+	for(const auto& extension : DeviceInfo::get(device_id)->extensions) {
+		list += (list.empty() ? "" : " ") + extension;
+	}
+	return list;
+}
+
+bool has_device_extension(cl_device_id device_id, const std::string& extension)
+{
+	return DeviceInfo::get(device_id)->has_extension(extension);
+}
+
+cl_platform_id get_device_platform(cl_device_id device_id)
+{
+	return DeviceInfo::get(device_id)->platform;
+}
+
+static std::vector<cl_device_id> create_sub_devices(cl_device_id device_id, const std::vector<cl_device_partition_property>& properties)
+{
+	cl_uint num_devices = 0;
+	if(cl_int err = clCreateSubDevices(device_id, properties.data(), 0, nullptr, &num_devices)) {
+		throw opencl_error_t("clCreateSubDevices() failed with " + get_error_string(err));
+	}
+	std::vector<cl_device_id> devices(num_devices);
+	if(cl_int err = clCreateSubDevices(device_id, properties.data(), devices.size(), devices.data(), &num_devices)) {
+		throw opencl_error_t("clCreateSubDevices() failed with " + get_error_string(err));
+	}
+	devices.resize(num_devices);
+	return devices;
+}
+
+std::vector<cl_device_id> create_sub_devices_equally(cl_device_id device_id, cl_uint compute_units)
+{
+	return create_sub_devices(device_id, {CL_DEVICE_PARTITION_EQUALLY, cl_device_partition_property(compute_units), 0});
+}
+
+std::vector<cl_device_id> create_sub_devices_by_counts(cl_device_id device_id, const std::vector<cl_uint>& compute_units)
+{
+	std::vector<cl_device_partition_property> properties = {CL_DEVICE_PARTITION_BY_COUNTS};
+	for(const auto count : compute_units) {
+		properties.push_back(count);
+	}
+	properties.push_back(CL_DEVICE_PARTITION_BY_COUNTS_LIST_END);
+	properties.push_back(0);
+	return create_sub_devices(device_id, properties);
+}
+
+std::vector<cl_device_id> create_sub_devices_by_affinity(cl_device_id device_id, cl_device_affinity_domain domain)
+{
+	return create_sub_devices(device_id, {CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN, cl_device_partition_property(domain), 0});
+}
+
+cl_device_id get_parent_device(cl_device_id device_id)
+{
+	cl_device_id parent = nullptr;
+	if(cl_int err = clGetDeviceInfo(device_id, CL_DEVICE_PARENT_DEVICE, sizeof(parent), &parent, 0)) {
+		throw opencl_error_t("clGetDeviceInfo(CL_DEVICE_PARENT_DEVICE) failed with " + get_error_string(err));
+	}
+	return parent;
+}
+
+void release_devices(std::vector<cl_device_id>& devices)
+{
+	for(auto device : devices) {
+		DeviceInfo::remove(device);
+		if(cl_int err = clReleaseDevice(device)) {
+			throw opencl_error_t("clReleaseDevice() failed with " + get_error_string(err));
+		}
 	}
-	return std::string(dev_name, dev_name_len > 0 ? dev_name_len - 1 : 0);
+	devices.clear();
+}
+
+cl_command_queue_properties get_device_queue_properties(cl_device_id device_id)
+{
+	return DeviceInfo::get(device_id)->queue_properties;
 }
 
-std::shared_ptr<CommandQueue> create_command_queue(cl_context context, cl_device_id device)
+std::shared_ptr<CommandQueue> create_command_queue(cl_context context, cl_device_id device, cl_command_queue_properties properties)
 {
+	if(properties & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) {
+		if(!(get_device_queue_properties(device) & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE)) {
+			properties &= ~cl_command_queue_properties(CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE);
+		}
+	}
 	cl_int err = 0;
-	cl_command_queue queue = clCreateCommandQueue(context, device, 0, &err);
+	cl_command_queue queue = clCreateCommandQueue(context, device, properties, &err);
 	if(err) {
 		throw opencl_error_t("clCreateCommandQueue() failed with " + get_error_string(err));
 	}
 	return CommandQueue::create(queue);
 }
 
+Context::Context(cl_platform_id platform, const std::vector<cl_device_id>& devices, cl_command_queue_properties queue_properties)
+	:	platform(platform), devices(devices)
+{
+	context = create_context(platform, devices);
+	try {
+		for(auto device : devices) {
+			queues.push_back(create_command_queue(context, device, queue_properties));
+		}
+	} catch(...) {
+		queues.clear();
+		release_context(context);
+		throw;
+	}
+}
+
+Context::~Context()
+{
+	for(const auto& queue : queues) {
+		clFinish(queue->get());
+	}
+	wait_programs();
+	programs.clear();
+	buffer_pool = nullptr;
+	queues.clear();
+	if(context) {
+		clReleaseContext(context);
+	}
+}
+
+std::shared_ptr<Context> Context::create(	cl_platform_id platform, const std::vector<cl_device_id>& devices,
+											cl_command_queue_properties queue_properties)
+{
+	return std::make_shared<Context>(platform, devices, queue_properties);
+}
+
+std::shared_ptr<BufferPool> Context::get_buffer_pool()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if(!buffer_pool) {
+		buffer_pool = std::make_shared<BufferPool>(context);
+	}
+	return buffer_pool;
+}
+
+std::shared_ptr<Program> Context::get_program(const std::vector<std::string>& files, const std::string& options)
+{
+	return get_program_future(files, options, false).get();
+}
+
+std::shared_future<std::shared_ptr<Program>> Context::get_program_async(const std::vector<std::string>& files, const std::string& options)
+{
+	return get_program_future(files, options, true);
+}
+
+std::shared_future<std::shared_ptr<Program>> Context::get_program_future(const std::vector<std::string>& files, const std::string& options, bool async)
+{
+	std::string key = options;
+	for(const auto& file : files) {
+		key += "\n" + file;
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto& future = programs[key];
+	if(!future.valid()) {
+		// sources are read here, so that missing files throw right away
+		auto program = Program::create(context, files, options, include_paths, binary_cache, tuner);
+		future = Program::build_shared(program, devices, async);
+	}
+	return future;
+}
+
+void Context::wait_programs()
+{
+	std::vector<std::shared_future<std::shared_ptr<Program>>> list;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for(const auto& entry : programs) {
+			if(entry.second.valid()) {
+				list.push_back(entry.second);
+			}
+		}
+	}
+	for(const auto& future : list) {
+		future.wait();
+	}
+}
+
+std::shared_ptr<Kernel> Context::create_kernel(const std::vector<std::string>& files, const std::string& name, const std::string& options)
+{
+	return get_program(files, options)->create_kernel(name);
+}
+
+void Context::finish()
+{
+	for(const auto& queue : queues) {
+		queue->finish();
+	}
+}
+
 std::string get_error_string(cl_int error)
 {
 	switch(error){
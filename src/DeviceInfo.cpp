@@ -0,0 +1,252 @@
+/*
+ * DeviceInfo.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#include <automy/basic_opencl/DeviceInfo.h>
+#include <automy/basic_opencl/Context.h>
+
+#include <map>
+#include <mutex>
+#include <cstdio>
+#include <sstream>
+#include <algorithm>
+
+// cl_ext_float_atomics
+#ifndef CL_DEVICE_SINGLE_FP_ATOMIC_CAPABILITIES_EXT
+#define CL_DEVICE_SINGLE_FP_ATOMIC_CAPABILITIES_EXT 0x4231
+#endif
+// cl_intel_required_subgroup_size
+#ifndef CL_DEVICE_SUB_GROUP_SIZES_INTEL
+#define CL_DEVICE_SUB_GROUP_SIZES_INTEL 0x4108
+#endif
+// cl_nv_device_attribute_query
+#ifndef CL_DEVICE_WARP_SIZE_NV
+#define CL_DEVICE_WARP_SIZE_NV 0x4003
+#endif
+// cl_amd_device_attribute_query
+#ifndef CL_DEVICE_WAVEFRONT_WIDTH_AMD
+#define CL_DEVICE_WAVEFRONT_WIDTH_AMD 0x4043
+#endif
+
+
+namespace automy {
+namespace basic_opencl {
+
+static std::mutex g_mutex;
+static std::map<cl_device_id, std::shared_ptr<const DeviceInfo>> g_info_map;
+
+template<typename T>
+static void get_info(cl_device_id device, cl_device_info param, const char* param_name, T& value)
+{
+	if(cl_int err = clGetDeviceInfo(device, param, sizeof(T), &value, 0)) {
+		throw opencl_error_t(std::string("clGetDeviceInfo(") + param_name + ") failed with " + get_error_string(err));
+	}
+}
+
+/*
+ * Keeps the default value if the query fails, for deprecated and non-essential parameters.
+ */
+template<typename T>
+static void get_info_optional(cl_device_id device, cl_device_info param, T& value)
+{
+	T tmp;
+	if(!clGetDeviceInfo(device, param, sizeof(T), &tmp, 0)) {
+		value = tmp;
+	}
+}
+
+static std::string get_info_string(cl_device_id device, cl_device_info param, const char* param_name)
+{
+	size_t length = 0;
+	if(cl_int err = clGetDeviceInfo(device, param, 0, 0, &length)) {
+		throw opencl_error_t(std::string("clGetDeviceInfo(") + param_name + ") failed with " + get_error_string(err));
+	}
+	std::string value(length, 0);
+	if(length) {
+		if(cl_int err = clGetDeviceInfo(device, param, value.size(), &value[0], 0)) {
+			throw opencl_error_t(std::string("clGetDeviceInfo(") + param_name + ") failed with " + get_error_string(err));
+		}
+	}
+	return std::string(value.c_str());
+}
+
+static std::string get_info_string_optional(cl_device_id device, cl_device_info param)
+{
+	size_t length = 0;
+	if(clGetDeviceInfo(device, param, 0, 0, &length) || !length) {
+		return std::string();
+	}
+	std::string value(length, 0);
+	if(clGetDeviceInfo(device, param, value.size(), &value[0], 0)) {
+		return std::string();
+	}
+	return std::string(value.c_str());
+}
+
+/*
+ * Returns 10 * major + minor of strings like "OpenCL 2.1 ..." or "OpenCL C 2.0 ...", 0 if not found.
+ */
+static int parse_version(const std::string& str, const std::string& prefix)
+{
+	if(str.compare(0, prefix.size(), prefix) != 0) {
+		return 0;
+	}
+	int major = 0;
+	int minor = 0;
+	if(std::sscanf(str.c_str() + prefix.size(), "%d.%d", &major, &minor) != 2) {
+		return 0;
+	}
+	return 10 * major + minor;
+}
+
+#define GET_INFO(param, value) get_info(device, param, #param, value)
+#define GET_INFO_STRING(param) get_info_string(device, param, #param)
+#define GET_INFO_OPTIONAL(param, value) get_info_optional(device, param, value)
+#define GET_INFO_STRING_OPTIONAL(param) get_info_string_optional(device, param)
+
+static std::shared_ptr<DeviceInfo> query(cl_device_id device)
+{
+	auto info = std::make_shared<DeviceInfo>();
+	info->device = device;
+	GET_INFO(CL_DEVICE_PLATFORM, info->platform);
+	GET_INFO(CL_DEVICE_TYPE, info->type);
+
+	info->name = GET_INFO_STRING(CL_DEVICE_NAME);
+	info->vendor = GET_INFO_STRING_OPTIONAL(CL_DEVICE_VENDOR);
+	info->version = GET_INFO_STRING(CL_DEVICE_VERSION);
+	info->driver_version = GET_INFO_STRING(CL_DRIVER_VERSION);
+	info->opencl_c_version = GET_INFO_STRING_OPTIONAL(CL_DEVICE_OPENCL_C_VERSION);
+	{
+		char version[1024] = {};
+		if(!clGetPlatformInfo(info->platform, CL_PLATFORM_VERSION, sizeof(version) - 1, version, 0)) {
+			info->platform_version = version;
+		}
+	}
+	info->cl_version = parse_version(info->version, "OpenCL ");
+	info->cl_c_version = parse_version(info->opencl_c_version, "OpenCL C ");
+	info->cl_platform_version = parse_version(info->platform_version, "OpenCL ");
+	{
+		std::istringstream list(GET_INFO_STRING(CL_DEVICE_EXTENSIONS));
+		std::string extension;
+		while(list >> extension) {
+			info->extensions.insert(extension);
+		}
+	}
+	GET_INFO(CL_DEVICE_MAX_COMPUTE_UNITS, info->compute_units);
+	GET_INFO_OPTIONAL(CL_DEVICE_MAX_CLOCK_FREQUENCY, info->max_clock_mhz);
+	GET_INFO(CL_DEVICE_MAX_WORK_GROUP_SIZE, info->max_work_group_size);
+	{
+		cl_uint max_dims = 0;
+		GET_INFO(CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS, max_dims);
+		std::vector<size_t> sizes(std::max<cl_uint>(max_dims, 3), 1);
+		if(cl_int err = clGetDeviceInfo(device, CL_DEVICE_MAX_WORK_ITEM_SIZES, sizeof(size_t) * max_dims, sizes.data(), 0)) {
+			throw opencl_error_t("clGetDeviceInfo(CL_DEVICE_MAX_WORK_ITEM_SIZES) failed with " + get_error_string(err));
+		}
+		for(size_t i = 0; i < 3; ++i) {
+			info->max_work_item_sizes[i] = sizes[i];
+		}
+	}
+	GET_INFO(CL_DEVICE_GLOBAL_MEM_SIZE, info->global_mem_size);
+	GET_INFO(CL_DEVICE_MAX_MEM_ALLOC_SIZE, info->max_alloc_size);
+	GET_INFO_OPTIONAL(CL_DEVICE_GLOBAL_MEM_CACHE_SIZE, info->global_cache_size);
+	GET_INFO_OPTIONAL(CL_DEVICE_GLOBAL_MEM_CACHELINE_SIZE, info->global_cache_line);
+	{
+		cl_uint align_bits = 0;
+		GET_INFO(CL_DEVICE_MEM_BASE_ADDR_ALIGN, align_bits);
+		info->mem_base_align = std::max<cl_uint>(align_bits / 8, 1);
+	}
+	GET_INFO(CL_DEVICE_LOCAL_MEM_SIZE, info->local_mem_size);
+	{
+		cl_device_local_mem_type local_type = 0;
+		GET_INFO_OPTIONAL(CL_DEVICE_LOCAL_MEM_TYPE, local_type);
+		info->local_mem_dedicated = local_type == CL_LOCAL;
+	}
+	{
+		cl_bool image_support = CL_FALSE;
+		GET_INFO_OPTIONAL(CL_DEVICE_IMAGE_SUPPORT, image_support);
+		info->image_support = image_support;
+
+		cl_bool unified = CL_FALSE;
+		GET_INFO_OPTIONAL(CL_DEVICE_HOST_UNIFIED_MEMORY, unified);		// deprecated by OpenCL 2.0
+		info->unified_memory = unified || info->is_cpu();
+	}
+	info->queue_properties = CL_QUEUE_PROFILING_ENABLE;		// required on all devices
+	GET_INFO_OPTIONAL(CL_DEVICE_QUEUE_PROPERTIES, info->queue_properties);		// deprecated by OpenCL 2.0
+
+	// performance hints are optional
+	auto& width = info->preferred_vector_width;
+	GET_INFO_OPTIONAL(CL_DEVICE_PREFERRED_VECTOR_WIDTH_CHAR, width.char_);
+	GET_INFO_OPTIONAL(CL_DEVICE_PREFERRED_VECTOR_WIDTH_SHORT, width.short_);
+	GET_INFO_OPTIONAL(CL_DEVICE_PREFERRED_VECTOR_WIDTH_INT, width.int_);
+	GET_INFO_OPTIONAL(CL_DEVICE_PREFERRED_VECTOR_WIDTH_LONG, width.long_);
+	GET_INFO_OPTIONAL(CL_DEVICE_PREFERRED_VECTOR_WIDTH_HALF, width.half_);
+	GET_INFO_OPTIONAL(CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT, width.float_);
+	GET_INFO_OPTIONAL(CL_DEVICE_PREFERRED_VECTOR_WIDTH_DOUBLE, width.double_);
+
+	// vendor specific queries are optional
+	if(info->has_extension("cl_ext_float_atomics")) {
+		if(clGetDeviceInfo(device, CL_DEVICE_SINGLE_FP_ATOMIC_CAPABILITIES_EXT, sizeof(info->float_atomic_caps), &info->float_atomic_caps, 0)) {
+			info->float_atomic_caps = 0;
+		}
+	}
+	if(info->has_extension("cl_intel_required_subgroup_size")) {
+		size_t length = 0;
+		if(!clGetDeviceInfo(device, CL_DEVICE_SUB_GROUP_SIZES_INTEL, 0, 0, &length)) {
+			std::vector<size_t> sizes(length / sizeof(size_t));
+			if(!clGetDeviceInfo(device, CL_DEVICE_SUB_GROUP_SIZES_INTEL, sizes.size() * sizeof(size_t), sizes.data(), 0)) {
+				info->subgroup_sizes = sizes;
+			}
+		}
+	} else if(info->has_extension("cl_nv_device_attribute_query")) {
+		cl_uint size = 0;
+		if(!clGetDeviceInfo(device, CL_DEVICE_WARP_SIZE_NV, sizeof(size), &size, 0) && size) {
+			info->subgroup_sizes.push_back(size);
+		}
+	} else if(info->has_extension("cl_amd_device_attribute_query")) {
+		cl_uint size = 0;
+		if(!clGetDeviceInfo(device, CL_DEVICE_WAVEFRONT_WIDTH_AMD, sizeof(size), &size, 0) && size) {
+			info->subgroup_sizes.push_back(size);
+		}
+	}
+	return info;
+}
+
+#undef GET_INFO
+#undef GET_INFO_STRING
+#undef GET_INFO_OPTIONAL
+#undef GET_INFO_STRING_OPTIONAL
+
+std::shared_ptr<const DeviceInfo> DeviceInfo::get(cl_device_id device)
+{
+	{
+		std::lock_guard<std::mutex> lock(g_mutex);
+		auto iter = g_info_map.find(device);
+		if(iter != g_info_map.end()) {
+			return iter->second;
+		}
+	}
+	// query without holding the lock, a concurrent query of the same device is harmless
+	std::shared_ptr<const DeviceInfo> info = query(device);
+
+	std::lock_guard<std::mutex> lock(g_mutex);
+	return g_info_map.emplace(device, info).first->second;
+}
+
+void DeviceInfo::remove(cl_device_id device)
+{
+	std::lock_guard<std::mutex> lock(g_mutex);
+	g_info_map.erase(device);
+}
+
+void DeviceInfo::clear()
+{
+	std::lock_guard<std::mutex> lock(g_mutex);
+	g_info_map.clear();
+}
+
+
+} // basic_opencl
+} // automy
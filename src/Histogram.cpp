@@ -0,0 +1,148 @@
+/*
+ * Histogram.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#include <automy/basic_opencl/Histogram.h>
+#include <automy/basic_opencl/DeviceInfo.h>
+
+#include <algorithm>
+
+
+namespace automy {
+namespace basic_opencl {
+
+Histogram::Histogram(cl_context context, cl_device_id device, const std::string& kernel_path_)
+	:	context(context), device(device), kernel_path(kernel_path_)
+{
+	const auto info = DeviceInfo::get(device);
+	num_compute_units = std::max<cl_uint>(info->compute_units, 1);
+
+	// emulated local memory does not help, leave room for more than one group per compute unit
+	max_local_bytes = info->local_mem_dedicated ? info->local_mem_size / 2 : 0;
+}
+
+std::shared_ptr<Histogram> Histogram::create(cl_context context, cl_device_id device, const std::string& kernel_path)
+{
+	return std::make_shared<Histogram>(context, device, kernel_path);
+}
+
+Histogram::kernels_t Histogram::get_kernels(const std::string& mode)
+{
+	auto& entry = kernels[mode];
+	if(!entry.program) {
+		auto program = Program::create(context, {"histogram.cl"}, "-DHIST_" + mode, {kernel_path}, binary_cache);
+		program->build_or_throw({device});
+		entry.global = program->create_kernel("hist_global");
+		entry.local = program->create_kernel("hist_local");
+		entry.mean_finish = program->create_kernel("hist_mean_finish");
+
+		const size_t max_local_size = std::min<size_t>(entry.local->get_max_work_group_size(device), 256);
+		while(entry.local_size * 2 <= max_local_size) {
+			entry.local_size *= 2;
+		}
+		entry.program = program;
+	}
+	return entry;
+}
+
+Event Histogram::accumulate(	std::shared_ptr<CommandQueue> queue, const std::string& mode, const Buffer1D<cl_float4>& points, const grid_t& grid,
+								Buffer& bins, size_t width, size_t height, size_t depth, const std::vector<Event>& wait_list)
+{
+	const size_t num = points.size();
+	const size_t num_bins = width * height * depth;
+	if(!num || !num_bins) {
+		return queue->enqueue_marker(wait_list);
+	}
+	if(num > 0xFFFFFFFF || num_bins > 0x7FFFFFFF) {
+		throw std::logic_error("Histogram: input too large");
+	}
+	const auto kernels = get_kernels(mode);
+
+	const size_t size[3] = {width, height, depth};
+	cl_float4 origin = {};
+	cl_float4 scale = {};
+	cl_uint4 size_ = {};
+	for(int i = 0; i < 3; ++i) {
+		origin.s[i] = grid.origin[i];
+		scale.s[i] = size[i] > 1 ? 1 / grid.bin_size[i] : 0;
+		size_.s[i] = size[i];
+	}
+
+	if(is_privatized(num_bins)) {
+		const size_t local_size = kernels.local_size;
+		const size_t num_groups = std::min((num + local_size - 1) / local_size, num_compute_units * 4);
+		kernels.local->set_args(points, cl_uint(num), origin, scale, size_, bins, Kernel::local_t(num_bins * 4));
+		return kernels.local->enqueue(queue, num_groups * local_size, local_size, wait_list);
+	} else {
+		kernels.global->set_args(points, cl_uint(num), origin, scale, size_, bins);
+		return kernels.global->enqueue_ceiled(queue, num, kernels.local_size, wait_list);
+	}
+}
+
+Event Histogram::count(	std::shared_ptr<CommandQueue> queue, const Buffer1D<cl_float4>& points, const grid_t& grid,
+						Buffer3D<cl_uint>& bins, bool clear, const std::vector<Event>& wait_list)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	const std::vector<Event> deps = clear ? std::vector<Event>{bins.set_zero(queue, wait_list)} : wait_list;
+	return accumulate(queue, "COUNT", points, grid, bins, bins.width(), bins.height(), bins.depth(), deps);
+}
+
+Event Histogram::sum(	std::shared_ptr<CommandQueue> queue, const Buffer1D<cl_float4>& points, const grid_t& grid,
+						Buffer3D<cl_float>& bins, bool clear, const std::vector<Event>& wait_list)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	const std::vector<Event> deps = clear ? std::vector<Event>{bins.set_zero(queue, wait_list)} : wait_list;
+	return accumulate(queue, "SUM_F", points, grid, bins, bins.width(), bins.height(), bins.depth(), deps);
+}
+
+Event Histogram::sum(	std::shared_ptr<CommandQueue> queue, const Buffer1D<cl_float4>& points, const grid_t& grid,
+						Buffer3D<cl_int>& bins, bool clear, const std::vector<Event>& wait_list)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	const std::vector<Event> deps = clear ? std::vector<Event>{bins.set_zero(queue, wait_list)} : wait_list;
+	return accumulate(queue, "SUM_I", points, grid, bins, bins.width(), bins.height(), bins.depth(), deps);
+}
+
+Event Histogram::mean(	std::shared_ptr<CommandQueue> queue, const Buffer1D<cl_float4>& points, const grid_t& grid,
+						Buffer3D<cl_float>& bins, const std::vector<Event>& wait_list)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto count = std::make_shared<Buffer3D<cl_uint>>();
+	auto event = mean_count(queue, points, grid, bins, *count, wait_list);
+	event.set_callback([count](cl_int) {});		// keeps count alive until finished
+	return event;
+}
+
+Event Histogram::mean(	std::shared_ptr<CommandQueue> queue, const Buffer1D<cl_float4>& points, const grid_t& grid,
+						Buffer3D<cl_float>& bins, Buffer3D<cl_uint>& count, const std::vector<Event>& wait_list)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return mean_count(queue, points, grid, bins, count, wait_list);
+}
+
+Event Histogram::mean_count(std::shared_ptr<CommandQueue> queue, const Buffer1D<cl_float4>& points, const grid_t& grid,
+							Buffer3D<cl_float>& bins, Buffer3D<cl_uint>& count, const std::vector<Event>& wait_list)
+{
+	const size_t num_bins = bins.size();
+	if(!num_bins) {
+		return queue->enqueue_marker(wait_list);
+	}
+	count.resize(context, bins.width(), bins.height(), bins.depth());
+
+	// sum and count are independent of each other
+	const std::vector<Event> sum_clear = {bins.set_zero(queue, wait_list)};
+	const std::vector<Event> count_clear = {count.set_zero(queue, wait_list)};
+	const std::vector<Event> accumulated = {
+		accumulate(queue, "SUM_F", points, grid, bins, bins.width(), bins.height(), bins.depth(), sum_clear),
+		accumulate(queue, "COUNT", points, grid, count, bins.width(), bins.height(), bins.depth(), count_clear)
+	};
+	const auto kernels = get_kernels("SUM_F");
+	kernels.mean_finish->set_args(bins, count, cl_uint(num_bins));
+	return kernels.mean_finish->enqueue_ceiled(queue, num_bins, kernels.local_size, accumulated);
+}
+
+} // basic_opencl
+} // automy
@@ -6,6 +6,10 @@
  */
 
 #include <automy/basic_opencl/Kernel.h>
+#include <automy/basic_opencl/DeviceInfo.h>
+
+#include <cctype>
+#include <chrono>
 
 
 namespace automy {
@@ -29,12 +33,13 @@ Kernel::Kernel(cl_kernel kernel_, bool with_arg_map)
 		name.resize(length - 1);
 	}
 	
+	cl_uint num_args = 0;
+	if(cl_int err = clGetKernelInfo(kernel, CL_KERNEL_NUM_ARGS, sizeof(num_args), &num_args, &length)) {
+		throw opencl_error_t("clGetKernelInfo(CL_KERNEL_NUM_ARGS) failed with " + get_error_string(err));
+	}
+	arg_cache.resize(num_args);
+	
 	if(with_arg_map) {
-		cl_uint num_args = 0;
-		if(cl_int err = clGetKernelInfo(kernel, CL_KERNEL_NUM_ARGS, sizeof(num_args), &num_args, &length)) {
-			throw opencl_error_t("clGetKernelInfo(CL_KERNEL_NUM_ARGS) failed with " + get_error_string(err));
-		}
-
 		for(cl_uint i = 0; i < num_args; ++i) {
 			std::string arg;
 			arg.resize(256);
@@ -48,7 +53,45 @@ Kernel::Kernel(cl_kernel kernel_, bool with_arg_map)
 			arg_list.push_back(arg);
 			arg_map[arg] = i;
 		}
+#ifndef NDEBUG
+		query_arg_info();		// only used by check_arg()
+#endif
+	}
+}
+
+void Kernel::query_arg_info() {
+	std::vector<arg_info_t> list;
+	for(cl_uint i = 0; i < arg_cache.size(); ++i) {
+		arg_info_t info;
+		size_t length = 0;
+		cl_int err = clGetKernelArgInfo(kernel, i, CL_KERNEL_ARG_TYPE_NAME, 0, 0, &length);
+		if(!err && length) {
+			info.type_name.resize(length);
+			err = clGetKernelArgInfo(kernel, i, CL_KERNEL_ARG_TYPE_NAME, info.type_name.size(), &info.type_name[0], &length);
+			info.type_name.resize(length ? length - 1 : 0);
+		}
+		if(!err) {
+			err = clGetKernelArgInfo(kernel, i, CL_KERNEL_ARG_ADDRESS_QUALIFIER, sizeof(info.address), &info.address, 0);
+		}
+		if(err == CL_KERNEL_ARG_INFO_NOT_AVAILABLE) {
+			return;		// no type info, skip checks
+		}
+		if(err) {
+			throw opencl_error_t("clGetKernelArgInfo() failed for '" + name + "' with " + get_error_string(err));
+		}
+		list.push_back(info);
 	}
+	arg_info = list;
+}
+
+Kernel::Kernel(cl_kernel kernel_, const Kernel& other)
+	:	kernel(kernel_),
+		name(other.name),
+		arg_list(other.arg_list),
+		arg_info(other.arg_info),
+		arg_map(other.arg_map)
+{
+	arg_cache.resize(other.arg_cache.size());
 }
 
 Kernel::~Kernel() {
@@ -61,27 +104,200 @@ std::shared_ptr<Kernel> Kernel::create(cl_kernel kernel, bool with_arg_map) {
 	return std::make_shared<Kernel>(kernel, with_arg_map);
 }
 
-void Kernel::set_local(const std::string& arg, const size_t& num_bytes) {
-	auto it = arg_map.find(arg);
-	if(it != arg_map.end()) {
-		if(clSetKernelArg(kernel, it->second, num_bytes, 0)) {
-			throw opencl_error_t("clSetKernelArg() failed for " + name + " : " + arg);
+// OpenCL 2.1, not declared with CL_TARGET_OPENCL_VERSION 120
+typedef cl_kernel (CL_API_CALL *clCloneKernel_t)(cl_kernel source_kernel, cl_int* errcode_ret);
+
+/*
+ * clCloneKernel() requires an OpenCL 2.1 platform and devices, a 2.1 ICD loader alone is not enough.
+ * Resolved at runtime, returns nullptr if not supported.
+ */
+static clCloneKernel_t get_clone_func(cl_program program) {
+	cl_uint num_devices = 0;
+	if(clGetProgramInfo(program, CL_PROGRAM_NUM_DEVICES, sizeof(num_devices), &num_devices, 0) || !num_devices) {
+		return nullptr;
+	}
+	std::vector<cl_device_id> devices(num_devices);
+	if(clGetProgramInfo(program, CL_PROGRAM_DEVICES, devices.size() * sizeof(cl_device_id), devices.data(), 0)) {
+		return nullptr;
+	}
+	for(const auto device : devices) {
+		const auto info = DeviceInfo::get(device);
+		if(info->cl_version < 21 || info->cl_platform_version < 21) {
+			return nullptr;
+		}
+	}
+	return (clCloneKernel_t)clGetExtensionFunctionAddressForPlatform(get_device_platform(devices[0]), "clCloneKernel");
+}
+
+std::shared_ptr<Kernel> Kernel::clone() const {
+	cl_kernel copy = nullptr;
+	bool with_args = false;
+	cl_program program = nullptr;
+	if(cl_int err = clGetKernelInfo(kernel, CL_KERNEL_PROGRAM, sizeof(program), &program, 0)) {
+		throw opencl_error_t("clGetKernelInfo(CL_KERNEL_PROGRAM) failed with " + get_error_string(err));
+	}
+	if(const auto clone_func = get_clone_func(program)) {
+		cl_int err = 0;
+		copy = clone_func(kernel, &err);
+		if(err) {
+			copy = nullptr;
+		} else {
+			with_args = true;
 		}
-	} else {
+	}
+	if(!copy) {
+		cl_int err = 0;
+		copy = clCreateKernel(program, name.c_str(), &err);
+		if(err) {
+			throw opencl_error_t("clCreateKernel() failed for '" + name + "' with " + get_error_string(err));
+		}
+	}
+	auto out = std::make_shared<Kernel>(copy, *this);
+	if(with_args) {
+		out->arg_cache = arg_cache;
+	}
+	out->tuner = tuner;
+	out->build_options = build_options;
+	return out;
+}
+
+size_t Kernel::get_max_work_group_size(cl_device_id device) const {
+	size_t size = 0;
+	if(cl_int err = clGetKernelWorkGroupInfo(kernel, device, CL_KERNEL_WORK_GROUP_SIZE, sizeof(size), &size, 0)) {
+		throw opencl_error_t("clGetKernelWorkGroupInfo(CL_KERNEL_WORK_GROUP_SIZE) failed with " + get_error_string(err));
+	}
+	return size;
+}
+
+Kernel::arg_t Kernel::get_arg(const std::string& arg) const {
+	auto it = arg_map.find(arg);
+	if(it == arg_map.end()) {
 		throw std::logic_error("no such argument '" + arg + "' in kernel '" + name + "'");
 	}
+	arg_t out;
+	out.index = it->second;
+	return out;
 }
 
-void Kernel::enqueue(std::shared_ptr<CommandQueue> queue, const size_t& global_size) {
-	if(cl_int err = clEnqueueNDRangeKernel(queue->get(), kernel, 1, 0, &global_size, 0, 0, 0, 0)) {
-		throw opencl_error_t("clEnqueueNDRangeKernel() failed for kernel '" + name + "' with " + get_error_string(err));
+std::string Kernel::get_arg_name(const cl_uint arg) const {
+	if(arg < arg_list.size()) {
+		return arg_list[arg];
 	}
+	return std::to_string(arg);
 }
 
-void Kernel::enqueue(std::shared_ptr<CommandQueue> queue, const size_t& global_size, const size_t& local_size) {
-	if(cl_int err = clEnqueueNDRangeKernel(queue->get(), kernel, 1, 0, &global_size, &local_size, 0, 0, 0)) {
+void Kernel::set_local(const std::string& arg, const size_t& num_bytes) {
+	set_arg_bytes(get_arg(arg).index, num_bytes, nullptr, ARG_LOCAL);
+}
+
+void Kernel::invalidate_args() {
+	for(auto& cache : arg_cache) {
+		cache.valid = false;
+	}
+}
+
+std::vector<Kernel::arg_value_t> Kernel::get_arg_values() const {
+	std::vector<arg_value_t> values;
+	for(cl_uint i = 0; i < arg_cache.size(); ++i) {
+		const auto& cache = arg_cache[i];
+		if(!cache.valid) {
+			throw std::logic_error("argument '" + get_arg_name(i) + "' of kernel '" + name + "' not set");
+		}
+		arg_value_t value;
+		value.index = i;
+		value.kind = cache.kind;
+		value.size = cache.size;
+		value.bytes = cache.bytes;
+		values.push_back(value);
+	}
+	return values;
+}
+
+void Kernel::set_arg_values(const std::vector<arg_value_t>& values) {
+	for(const auto& value : values) {
+		set_arg_bytes(value.index, value.size, value.bytes.empty() ? nullptr : value.bytes.data(), value.kind);
+	}
+}
+
+static size_t get_builtin_type_size(const std::string& type_name)
+{
+	static const std::map<std::string, size_t> scalar_size = {
+		{"char", 1}, {"uchar", 1}, {"short", 2}, {"ushort", 2}, {"half", 2},
+		{"int", 4}, {"uint", 4}, {"float", 4}, {"long", 8}, {"ulong", 8}, {"double", 8},
+	};
+	size_t pos = 0;
+	while(pos < type_name.size() && std::isalpha(type_name[pos])) {
+		pos++;
+	}
+	auto it = scalar_size.find(type_name.substr(0, pos));
+	if(it == scalar_size.end()) {
+		return 0;		// struct or unknown type
+	}
+	size_t width = 1;
+	if(pos < type_name.size()) {
+		try {
+			width = std::stoul(type_name.substr(pos));
+		} catch(...) {
+			return 0;
+		}
+	}
+	return it->second * (width == 3 ? 4 : width);
+}
+
+void Kernel::check_arg(const cl_uint arg, const size_t size, const arg_kind_e kind) const {
+	if(arg >= arg_info.size()) {
+		return;		// no argument info available
+	}
+	const auto& info = arg_info[arg];
+	const auto prefix = "argument '" + arg_list[arg] + "' of kernel '" + name + "' ";
+	const bool is_image = info.type_name.compare(0, 5, "image") == 0;
+	switch(kind) {
+		case ARG_VALUE: {
+			if(info.address != CL_KERNEL_ARG_ADDRESS_PRIVATE || is_image) {
+				throw std::logic_error(prefix + "is not a value (" + info.type_name + ")");
+			}
+			const size_t expected = get_builtin_type_size(info.type_name);
+			if(expected && expected != size) {
+				throw std::logic_error(prefix + "has type " + info.type_name + " of size " + std::to_string(expected)
+						+ " but value has size " + std::to_string(size));
+			}
+			break;
+		}
+		case ARG_MEMORY:
+			if(info.address != CL_KERNEL_ARG_ADDRESS_GLOBAL && info.address != CL_KERNEL_ARG_ADDRESS_CONSTANT && !is_image) {
+				throw std::logic_error(prefix + "is not a __global or __constant memory object (" + info.type_name + ")");
+			}
+			break;
+		case ARG_LOCAL:
+			if(info.address != CL_KERNEL_ARG_ADDRESS_LOCAL) {
+				throw std::logic_error(prefix + "is not a __local argument (" + info.type_name + ")");
+			}
+			break;
+	}
+}
+
+void Kernel::enqueue_nd(	std::shared_ptr<CommandQueue> queue, const cl_uint dims, const size_t* global_size, const size_t* local_size,
+							const EventList* wait_list, cl_event* event, const size_t* global_offset)
+{
+	Event tmp;
+	const auto profiler = queue->get_profiler();
+	if(cl_int err = clEnqueueNDRangeKernel(queue->get(), kernel, dims, global_offset, global_size, local_size,
+			wait_list ? wait_list->size() : 0, wait_list ? wait_list->data() : nullptr,
+			event ? event : (profiler ? tmp.reset() : nullptr)))
+	{
 		throw opencl_error_t("clEnqueueNDRangeKernel() failed for kernel '" + name + "' with " + get_error_string(err));
 	}
+	if(profiler) {
+		profiler->add(name, Profiler::KERNEL, event ? Event(*event, true) : tmp);
+	}
+}
+
+void Kernel::enqueue(std::shared_ptr<CommandQueue> queue, const size_t& global_size) {
+	enqueue_nd(queue, 1, &global_size, 0, 0, 0);
+}
+
+void Kernel::enqueue(std::shared_ptr<CommandQueue> queue, const size_t& global_size, const size_t& local_size) {
+	enqueue_nd(queue, 1, &global_size, &local_size, 0, 0);
 }
 
 void Kernel::enqueue_ceiled(std::shared_ptr<CommandQueue> queue, const size_t& global_size, const size_t& local_size) {
@@ -90,43 +306,193 @@ void Kernel::enqueue_ceiled(std::shared_ptr<CommandQueue> queue, const size_t& g
 }
 
 void Kernel::enqueue_2D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 2>& global_size) {
-	if(cl_int err = clEnqueueNDRangeKernel(queue->get(), kernel, 2, 0, global_size.data(), 0, 0, 0, 0)) {
-		throw opencl_error_t("clEnqueueNDRangeKernel() failed for kernel '" + name + "' with " + get_error_string(err));
-	}
+	enqueue_nd(queue, 2, global_size.data(), 0, 0, 0);
 }
 
 void Kernel::enqueue_2D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 2>& global_size, const std::array<size_t, 2>& local_size) {
-	if(cl_int err = clEnqueueNDRangeKernel(queue->get(), kernel, 2, 0, global_size.data(), local_size.data(), 0, 0, 0)) {
-		throw opencl_error_t("clEnqueueNDRangeKernel() failed for kernel '" + name + "' with " + get_error_string(err));
-	}
+	enqueue_nd(queue, 2, global_size.data(), local_size.data(), 0, 0);
 }
 
 void Kernel::enqueue_ceiled_2D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 2>& global_size, const std::array<size_t, 2>& local_size) {
-	std::array<size_t, 2> global_size_ = global_size;
-	for(int i = 0; i < 2; ++i) {
-		global_size_[i] += (local_size[i] - (global_size[i] % local_size[i])) % local_size[i];
-	}
-	enqueue_2D(queue, global_size_, local_size);
+	enqueue_2D(queue, get_ceiled(global_size, local_size), local_size);
 }
 
 void Kernel::enqueue_3D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 3>& global_size) {
-	if(cl_int err = clEnqueueNDRangeKernel(queue->get(), kernel, 3, 0, global_size.data(), 0, 0, 0, 0)) {
-		throw opencl_error_t("clEnqueueNDRangeKernel() failed for kernel '" + name + "' with " + get_error_string(err));
-	}
+	enqueue_nd(queue, 3, global_size.data(), 0, 0, 0);
 }
 
 void Kernel::enqueue_3D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 3>& global_size, const std::array<size_t, 3>& local_size) {
-	if(cl_int err = clEnqueueNDRangeKernel(queue->get(), kernel, 3, 0, global_size.data(), local_size.data(), 0, 0, 0)) {
-		throw opencl_error_t("clEnqueueNDRangeKernel() failed for kernel '" + name + "' with " + get_error_string(err));
-	}
+	enqueue_nd(queue, 3, global_size.data(), local_size.data(), 0, 0);
 }
 
 void Kernel::enqueue_ceiled_3D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 3>& global_size, const std::array<size_t, 3>& local_size) {
-	std::array<size_t, 3> global_size_ = global_size;
-	for(int i = 0; i < 3; ++i) {
-		global_size_[i] += (local_size[i] - (global_size[i] % local_size[i])) % local_size[i];
+	enqueue_3D(queue, get_ceiled(global_size, local_size), local_size);
+}
+
+Event Kernel::enqueue(std::shared_ptr<CommandQueue> queue, const size_t& global_size, const std::vector<Event>& wait_list) {
+	Event event;
+	const EventList list(wait_list);
+	enqueue_nd(queue, 1, &global_size, 0, &list, event.reset());
+	return event;
+}
+
+Event Kernel::enqueue(std::shared_ptr<CommandQueue> queue, const size_t& global_size, const size_t& local_size, const std::vector<Event>& wait_list) {
+	Event event;
+	const EventList list(wait_list);
+	enqueue_nd(queue, 1, &global_size, &local_size, &list, event.reset());
+	return event;
+}
+
+Event Kernel::enqueue_ceiled(std::shared_ptr<CommandQueue> queue, const size_t& global_size, const size_t& local_size, const std::vector<Event>& wait_list) {
+	const auto global_size_ = global_size + (local_size - (global_size % local_size)) % local_size;
+	return enqueue(queue, global_size_, local_size, wait_list);
+}
+
+Event Kernel::enqueue_2D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 2>& global_size, const std::vector<Event>& wait_list) {
+	Event event;
+	const EventList list(wait_list);
+	enqueue_nd(queue, 2, global_size.data(), 0, &list, event.reset());
+	return event;
+}
+
+Event Kernel::enqueue_2D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 2>& global_size, const std::array<size_t, 2>& local_size, const std::vector<Event>& wait_list) {
+	Event event;
+	const EventList list(wait_list);
+	enqueue_nd(queue, 2, global_size.data(), local_size.data(), &list, event.reset());
+	return event;
+}
+
+Event Kernel::enqueue_ceiled_2D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 2>& global_size, const std::array<size_t, 2>& local_size, const std::vector<Event>& wait_list) {
+	return enqueue_2D(queue, get_ceiled(global_size, local_size), local_size, wait_list);
+}
+
+Event Kernel::enqueue_3D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 3>& global_size, const std::vector<Event>& wait_list) {
+	Event event;
+	const EventList list(wait_list);
+	enqueue_nd(queue, 3, global_size.data(), 0, &list, event.reset());
+	return event;
+}
+
+Event Kernel::enqueue_3D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 3>& global_size, const std::array<size_t, 3>& local_size, const std::vector<Event>& wait_list) {
+	Event event;
+	const EventList list(wait_list);
+	enqueue_nd(queue, 3, global_size.data(), local_size.data(), &list, event.reset());
+	return event;
+}
+
+Event Kernel::enqueue_ceiled_3D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 3>& global_size, const std::array<size_t, 3>& local_size, const std::vector<Event>& wait_list) {
+	return enqueue_3D(queue, get_ceiled(global_size, local_size), local_size, wait_list);
+}
+
+void Kernel::enqueue_tuned(	std::shared_ptr<CommandQueue> queue, const cl_uint dims, const size_t* global_size,
+							const EventList* wait_list, cl_event* event)
+{
+	if(!tuner) {
+		enqueue_nd(queue, dims, global_size, 0, wait_list, event);
+		return;
+	}
+	const auto launch = tuner->begin(kernel, name, build_options, queue->get_device(), dims, global_size);
+	
+	size_t global_size_[3] = {};
+	for(cl_uint i = 0; i < dims; ++i) {
+		const auto local_size = launch.local_size[i];
+		global_size_[i] = global_size[i] + (local_size - (global_size[i] % local_size)) % local_size;
+	}
+	if(!launch.is_trial()) {
+		enqueue_nd(queue, dims, global_size_, launch.local_size.data(), wait_list, event);
+		return;
+	}
+	Event tmp;
+	if(!event) {
+		event = tmp.reset();
+	}
+	const bool profiling = queue->get_properties() & CL_QUEUE_PROFILING_ENABLE;
+	if(!profiling) {
+		if(wait_list && wait_list->size()) {
+			if(cl_int err = clWaitForEvents(wait_list->size(), wait_list->data())) {
+				throw opencl_error_t("clWaitForEvents() failed for kernel '" + name + "' with " + get_error_string(err));
+			}
+		}
+		queue->finish();		// only measure this kernel
+	}
+	const auto time_begin = std::chrono::steady_clock::now();
+	enqueue_nd(queue, dims, global_size_, launch.local_size.data(), wait_list, event);
+	
+	if(cl_int err = clWaitForEvents(1, event)) {
+		throw opencl_error_t("clWaitForEvents() failed for kernel '" + name + "' with " + get_error_string(err));
+	}
+	double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - time_begin).count();
+	if(profiling) {
+		cl_ulong start = 0;
+		cl_ulong end = 0;
+		if(!clGetEventProfilingInfo(*event, CL_PROFILING_COMMAND_START, sizeof(start), &start, 0)
+			&& !clGetEventProfilingInfo(*event, CL_PROFILING_COMMAND_END, sizeof(end), &end, 0))
+		{
+			time = (end - start) * 1e-6;
+		}
+	}
+	tuner->end(launch, time);
+}
+
+void Kernel::enqueue_ceiled(std::shared_ptr<CommandQueue> queue, const size_t& global_size) {
+	enqueue_tuned(queue, 1, &global_size, 0, 0);
+}
+
+void Kernel::enqueue_ceiled_2D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 2>& global_size) {
+	enqueue_tuned(queue, 2, global_size.data(), 0, 0);
+}
+
+void Kernel::enqueue_ceiled_3D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 3>& global_size) {
+	enqueue_tuned(queue, 3, global_size.data(), 0, 0);
+}
+
+Event Kernel::enqueue_ceiled(std::shared_ptr<CommandQueue> queue, const size_t& global_size, const std::vector<Event>& wait_list) {
+	Event event;
+	const EventList list(wait_list);
+	enqueue_tuned(queue, 1, &global_size, &list, event.reset());
+	return event;
+}
+
+Event Kernel::enqueue_ceiled_2D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 2>& global_size, const std::vector<Event>& wait_list) {
+	Event event;
+	const EventList list(wait_list);
+	enqueue_tuned(queue, 2, global_size.data(), &list, event.reset());
+	return event;
+}
+
+Event Kernel::enqueue_ceiled_3D(std::shared_ptr<CommandQueue> queue, const std::array<size_t, 3>& global_size, const std::vector<Event>& wait_list) {
+	Event event;
+	const EventList list(wait_list);
+	enqueue_tuned(queue, 3, global_size.data(), &list, event.reset());
+	return event;
+}
+
+Event Kernel::enqueue_range(std::shared_ptr<CommandQueue> queue, const size_t& offset, const size_t& global_size, const size_t& local_size, const std::vector<Event>& wait_list) {
+	Event event;
+	const EventList list(wait_list);
+	if(!local_size) {
+		enqueue_nd(queue, 1, &global_size, nullptr, &list, event.reset(), &offset);
+		return event;
+	}
+	const auto global_size_ = global_size + (local_size - (global_size % local_size)) % local_size;
+	enqueue_nd(queue, 1, &global_size_, &local_size, &list, event.reset(), &offset);
+	return event;
+}
+
+Event Kernel::enqueue_range_2D(	std::shared_ptr<CommandQueue> queue, const std::array<size_t, 2>& offset, const std::array<size_t, 2>& global_size,
+								const std::array<size_t, 2>& local_size, const std::vector<Event>& wait_list) {
+	Event event;
+	const EventList list(wait_list);
+	if(!local_size[0] && !local_size[1]) {
+		enqueue_nd(queue, 2, global_size.data(), nullptr, &list, event.reset(), offset.data());
+		return event;
+	}
+	if(!local_size[0] || !local_size[1]) {
+		throw std::logic_error("local_size == 0 for kernel '" + name + "'");
 	}
-	enqueue_3D(queue, global_size_, local_size);
+	const auto global_size_ = get_ceiled(global_size, local_size);
+	enqueue_nd(queue, 2, global_size_.data(), local_size.data(), &list, event.reset(), offset.data());
+	return event;
 }
 
 void Kernel::print_info(std::ostream& out) {
@@ -0,0 +1,46 @@
+/*
+ * MappedView.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#include <automy/basic_opencl/MappedView.h>
+#include <automy/basic_opencl/DeviceInfo.h>
+
+
+namespace automy {
+namespace basic_opencl {
+
+bool is_likely_zero_copy(cl_mem buffer, cl_device_id device)
+{
+	const auto info = DeviceInfo::get(device);
+	if(info->is_cpu()) {
+		return true;
+	}
+	cl_mem_flags flags = 0;
+	if(cl_int err = clGetMemObjectInfo(buffer, CL_MEM_FLAGS, sizeof(flags), &flags, 0)) {
+		throw opencl_error_t("clGetMemObjectInfo(CL_MEM_FLAGS) failed with " + get_error_string(err));
+	}
+	return info->unified_memory && (flags & (CL_MEM_ALLOC_HOST_PTR | CL_MEM_USE_HOST_PTR));
+}
+
+bool is_host_ptr_alias(cl_mem buffer, const void* mapped, size_t offset)
+{
+	cl_mem_flags flags = 0;
+	if(cl_int err = clGetMemObjectInfo(buffer, CL_MEM_FLAGS, sizeof(flags), &flags, 0)) {
+		throw opencl_error_t("clGetMemObjectInfo(CL_MEM_FLAGS) failed with " + get_error_string(err));
+	}
+	if(!(flags & CL_MEM_USE_HOST_PTR) || !mapped) {
+		return false;
+	}
+	void* host_ptr = nullptr;
+	if(cl_int err = clGetMemObjectInfo(buffer, CL_MEM_HOST_PTR, sizeof(host_ptr), &host_ptr, 0)) {
+		throw opencl_error_t("clGetMemObjectInfo(CL_MEM_HOST_PTR) failed with " + get_error_string(err));
+	}
+	return host_ptr && (const char*)host_ptr + offset == (const char*)mapped;
+}
+
+
+} // basic_opencl
+} // automy
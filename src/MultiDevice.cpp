@@ -0,0 +1,266 @@
+/*
+ * MultiDevice.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#include <automy/basic_opencl/MultiDevice.h>
+#include <automy/basic_opencl/DeviceInfo.h>
+
+#include <chrono>
+#include <algorithm>
+#include <condition_variable>
+
+
+namespace automy {
+namespace basic_opencl {
+
+struct MultiDevice::state_t {
+	struct done_t {
+		range_t range;
+		cl_int status = CL_COMPLETE;
+		std::chrono::steady_clock::time_point time;
+	};
+	std::mutex mutex;
+	std::condition_variable signal;
+	std::vector<done_t> done;
+	size_t num_pending = 0;
+};
+
+static size_t gcd(size_t a, size_t b)
+{
+	while(b) {
+		const size_t t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+MultiDevice::MultiDevice(cl_context context, const std::vector<cl_device_id>& devices, cl_command_queue_properties properties)
+	:	context(context), devices(devices)
+{
+	if(devices.empty()) {
+		throw std::logic_error("MultiDevice: no devices");
+	}
+	for(auto device : devices) {
+		queues.push_back(create_command_queue(context, device, properties));
+
+		const auto info = DeviceInfo::get(device);
+		base_align.push_back(info->mem_base_align);
+		weights.push_back(double(std::max<cl_uint>(info->compute_units, 1)) * std::max<cl_uint>(info->max_clock_mhz, 1));
+		measured.push_back(false);
+	}
+}
+
+std::shared_ptr<MultiDevice> MultiDevice::create(	cl_context context, const std::vector<cl_device_id>& devices,
+													cl_command_queue_properties properties)
+{
+	return std::make_shared<MultiDevice>(context, devices, properties);
+}
+
+size_t MultiDevice::get_granularity(size_t item_size) const
+{
+	size_t granularity = 1;
+	for(const auto align : base_align) {
+		const size_t items = align / gcd(align, std::max<size_t>(item_size, 1));
+		granularity = (granularity / gcd(granularity, items)) * items;
+	}
+	return granularity;
+}
+
+std::vector<double> MultiDevice::get_weights() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return weights;
+}
+
+void MultiDevice::set_weights(const std::vector<double>& weights_)
+{
+	if(weights_.size() != devices.size()) {
+		throw std::logic_error("MultiDevice: weights.size() != num_devices");
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	weights = weights_;
+	measured.assign(devices.size(), true);
+}
+
+std::vector<MultiDevice::range_t> MultiDevice::split(size_t num, size_t granularity) const
+{
+	const auto weights = get_weights();
+	granularity = std::max<size_t>(granularity, 1);
+
+	double total = 0;
+	for(const auto weight : weights) {
+		total += std::max(weight, 0.);
+	}
+	std::vector<range_t> out;
+	double sum = 0;
+	size_t offset = 0;
+	for(size_t i = 0; i < weights.size(); ++i) {
+		sum += std::max(weights[i], 0.);
+		size_t end = num;
+		if(i + 1 < weights.size()) {
+			end = total > 0 ? size_t(num * (sum / total)) : (num * (i + 1)) / weights.size();
+			end = std::min(std::max((end / granularity) * granularity, offset), num);
+		}
+		if(end > offset) {
+			range_t range;
+			range.device = i;
+			range.offset = offset;
+			range.count = end - offset;
+			out.push_back(range);
+		}
+		offset = end;
+	}
+	return out;
+}
+
+void MultiDevice::submit(std::shared_ptr<state_t> state, std::shared_ptr<CommandQueue> queue, const range_t& range, const func_t& func)
+{
+	Event event = func(queue, range);
+	if(!event.is_valid()) {
+		event = queue->enqueue_marker();
+	}
+	{
+		std::lock_guard<std::mutex> lock(state->mutex);
+		state->num_pending++;
+	}
+	try {
+		event.set_callback(
+			[state, range](cl_int status) {
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state_t::done_t done;
+				done.range = range;
+				done.status = status;
+				done.time = std::chrono::steady_clock::now();
+				state->done.push_back(done);
+				state->num_pending--;
+				state->signal.notify_all();
+			});
+	} catch(...) {
+		std::lock_guard<std::mutex> lock(state->mutex);
+		state->num_pending--;
+		throw;
+	}
+	queue->flush();
+}
+
+void MultiDevice::update_weights(const std::vector<double>& items, const std::vector<double>& time_ms)
+{
+	std::vector<double> throughput(devices.size());
+	double total = 0;
+	for(size_t i = 0; i < devices.size(); ++i) {
+		if(items[i] <= 0 || time_ms[i] <= 0) {
+			return;		// need a measurement for every device to compare them
+		}
+		throughput[i] = items[i] / time_ms[i];
+		total += throughput[i];
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	double prev_total = 0;
+	for(const auto weight : weights) {
+		prev_total += weight;
+	}
+	for(size_t i = 0; i < devices.size(); ++i) {
+		const double value = throughput[i] / total;
+		if(measured[i] && prev_total > 0) {
+			weights[i] = 0.5 * (weights[i] / prev_total) + 0.5 * value;
+		} else {
+			weights[i] = value;
+		}
+		measured[i] = true;
+	}
+}
+
+void MultiDevice::run(size_t num, const func_t& func, size_t granularity)
+{
+	const auto ranges = split(num, granularity);
+	if(ranges.empty()) {
+		return;
+	}
+	auto state = std::make_shared<state_t>();
+	const auto time_begin = std::chrono::steady_clock::now();
+	for(const auto& range : ranges) {
+		submit(state, queues[range.device], range, func);
+	}
+	std::vector<double> items(devices.size());
+	std::vector<double> time_ms(devices.size());
+	cl_int error = CL_COMPLETE;
+	{
+		std::unique_lock<std::mutex> lock(state->mutex);
+		while(state->num_pending) {
+			state->signal.wait(lock);
+		}
+		for(const auto& done : state->done) {
+			items[done.range.device] += done.range.count;
+			time_ms[done.range.device] = std::chrono::duration<double, std::milli>(done.time - time_begin).count();
+			error = std::min(error, done.status);
+		}
+	}
+	if(error < 0) {
+		throw opencl_error_t("MultiDevice::run(): command failed with " + get_error_string(error));
+	}
+	update_weights(items, time_ms);
+}
+
+void MultiDevice::run_dynamic(size_t num, size_t chunk_size, const func_t& func)
+{
+	if(!chunk_size) {
+		throw std::logic_error("MultiDevice::run_dynamic(): chunk_size == 0");
+	}
+	auto state = std::make_shared<state_t>();
+	size_t offset = 0;
+	auto submit_next = [&](size_t device) -> bool {
+		if(offset >= num) {
+			return false;
+		}
+		range_t range;
+		range.device = device;
+		range.offset = offset;
+		range.count = std::min(chunk_size, num - offset);
+		offset += range.count;
+		submit(state, queues[device], range, func);
+		return true;
+	};
+	const auto time_begin = std::chrono::steady_clock::now();
+	for(int k = 0; k < 2; ++k) {
+		for(size_t i = 0; i < devices.size(); ++i) {
+			submit_next(i);
+		}
+	}
+	std::vector<double> items(devices.size());
+	std::vector<double> time_ms(devices.size());
+	cl_int error = CL_COMPLETE;
+	while(true) {
+		std::vector<state_t::done_t> done;
+		{
+			std::unique_lock<std::mutex> lock(state->mutex);
+			while(state->done.empty() && state->num_pending) {
+				state->signal.wait(lock);
+			}
+			if(state->done.empty()) {
+				break;
+			}
+			done.swap(state->done);
+		}
+		for(const auto& entry : done) {
+			const auto device = entry.range.device;
+			items[device] += entry.range.count;
+			time_ms[device] = std::chrono::duration<double, std::milli>(entry.time - time_begin).count();
+			error = std::min(error, entry.status);
+			if(error >= 0) {
+				submit_next(device);
+			}
+		}
+	}
+	if(error < 0) {
+		throw opencl_error_t("MultiDevice::run_dynamic(): command failed with " + get_error_string(error));
+	}
+	update_weights(items, time_ms);
+}
+
+
+} // basic_opencl
+} // automy
@@ -0,0 +1,231 @@
+/*
+ * Profiler.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#include <automy/basic_opencl/Profiler.h>
+
+#include <map>
+#include <iomanip>
+#include <algorithm>
+
+
+namespace automy {
+namespace basic_opencl {
+
+static cl_ulong get_profiling_info(const Event& event, cl_profiling_info param)
+{
+	cl_ulong value = 0;
+	if(cl_int err = clGetEventProfilingInfo(event.get(), param, sizeof(value), &value, 0)) {
+		throw opencl_error_t("clGetEventProfilingInfo() failed with " + get_error_string(err));
+	}
+	return value;
+}
+
+static std::string escape_json(const std::string& str)
+{
+	std::string out;
+	for(const char c : str) {
+		if(c == '"' || c == '\\') {
+			out += '\\';
+		}
+		out += c;
+	}
+	return out;
+}
+
+std::shared_ptr<Profiler> Profiler::create()
+{
+	return std::make_shared<Profiler>();
+}
+
+const char* Profiler::get_type_name(command_e type)
+{
+	switch(type) {
+		case KERNEL: return "kernel";
+		case WRITE: return "write";
+		case READ: return "read";
+		case COPY: return "copy";
+		case FILL: return "fill";
+	}
+	return "unknown";
+}
+
+void Profiler::add(const std::string& name, command_e type, const Event& event, size_t num_bytes)
+{
+	if(!event.is_valid()) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+
+	pending_t entry;
+	entry.record.name = name;
+	entry.record.type = type;
+	entry.record.num_bytes = num_bytes;
+	entry.event = event;
+	pending.push_back(entry);
+
+	collect_pending(false);
+	while(pending.size() > max_pending) {
+		add_record(pending.front());		// limit number of events held
+		pending.pop_front();
+	}
+}
+
+void Profiler::collect()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	collect_pending(true);
+}
+
+void Profiler::collect_pending(bool blocking)
+{
+	// commands mostly complete in submission order, stop at the first one still running
+	while(!pending.empty() && (blocking || pending.front().event.is_complete())) {
+		add_record(pending.front());
+		pending.pop_front();
+	}
+}
+
+void Profiler::add_record(pending_t& entry)
+{
+	entry.event.wait();
+	auto& record = entry.record;
+	record.queued = get_profiling_info(entry.event, CL_PROFILING_COMMAND_QUEUED);
+	record.submit = get_profiling_info(entry.event, CL_PROFILING_COMMAND_SUBMIT);
+	record.start = get_profiling_info(entry.event, CL_PROFILING_COMMAND_START);
+	record.end = get_profiling_info(entry.event, CL_PROFILING_COMMAND_END);
+	records.push_back(record);
+	while(records.size() > max_records) {
+		records.pop_front();
+		num_dropped++;
+	}
+}
+
+void Profiler::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	pending.clear();
+	records.clear();
+	num_dropped = 0;
+}
+
+std::vector<Profiler::record_t> Profiler::get_records()
+{
+	collect();
+	std::lock_guard<std::mutex> lock(mutex);
+	return std::vector<record_t>(records.begin(), records.end());
+}
+
+size_t Profiler::get_num_dropped()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return num_dropped;
+}
+
+std::vector<Profiler::stats_t> Profiler::get_stats(const std::vector<record_t>& records, bool by_type)
+{
+	std::map<std::string, std::vector<const record_t*>> groups;
+	for(const auto& record : records) {
+		if(by_type) {
+			if(record.type != KERNEL) {
+				groups[get_type_name(record.type)].push_back(&record);
+			}
+		} else if(record.type == KERNEL) {
+			groups[record.name].push_back(&record);
+		}
+	}
+	std::vector<stats_t> result;
+	for(const auto& group : groups) {
+		std::vector<double> times;
+		stats_t stats;
+		stats.name = group.first;
+		stats.count = group.second.size();
+		for(const auto* record : group.second) {
+			const double time = (record->end - record->start) * 1e-6;
+			times.push_back(time);
+			stats.total += time;
+			stats.num_bytes += record->num_bytes;
+		}
+		std::sort(times.begin(), times.end());
+		stats.min = times.front();
+		stats.max = times.back();
+		stats.p50 = times[(times.size() - 1) * 50 / 100];
+		stats.p99 = times[(times.size() - 1) * 99 / 100];
+		result.push_back(stats);
+	}
+	std::sort(result.begin(), result.end(),
+		[](const stats_t& lhs, const stats_t& rhs) -> bool {
+			return lhs.total > rhs.total;
+		});
+	return result;
+}
+
+std::vector<Profiler::stats_t> Profiler::get_kernel_stats()
+{
+	return get_stats(get_records(), false);
+}
+
+std::vector<Profiler::stats_t> Profiler::get_transfer_stats()
+{
+	return get_stats(get_records(), true);
+}
+
+void Profiler::print(std::ostream& out)
+{
+	const auto records = get_records();
+	const auto kernels = get_stats(records, false);
+	const auto transfers = get_stats(records, true);
+	const auto flags = out.flags();
+	const auto precision = out.precision();
+
+	out << std::left << std::setw(40) << "kernel" << std::right
+		<< std::setw(10) << "count" << std::setw(12) << "total ms" << std::setw(10) << "min ms"
+		<< std::setw(10) << "max ms" << std::setw(10) << "p50 ms" << std::setw(10) << "p99 ms" << std::endl;
+	for(const auto& stats : kernels) {
+		out << std::left << std::setw(40) << stats.name << std::right << std::fixed << std::setprecision(3)
+			<< std::setw(10) << stats.count << std::setw(12) << stats.total << std::setw(10) << stats.min
+			<< std::setw(10) << stats.max << std::setw(10) << stats.p50 << std::setw(10) << stats.p99 << std::endl;
+	}
+	out << std::left << std::setw(40) << "transfer" << std::right
+		<< std::setw(10) << "count" << std::setw(12) << "total ms" << std::setw(14) << "MB" << std::setw(10) << "GB/s" << std::endl;
+	for(const auto& stats : transfers) {
+		out << std::left << std::setw(40) << stats.name << std::right << std::fixed << std::setprecision(3)
+			<< std::setw(10) << stats.count << std::setw(12) << stats.total << std::setw(14) << stats.num_bytes / 1e6
+			<< std::setw(10) << stats.get_bandwidth() << std::endl;
+	}
+	out.flags(flags);
+	out.precision(precision);
+}
+
+void Profiler::write_chrome_trace(std::ostream& out)
+{
+	const auto records = get_records();
+
+	cl_ulong time_base = -1;
+	for(const auto& record : records) {
+		time_base = std::min(time_base, record.queued);
+	}
+	const auto flags = out.flags();
+	const auto precision = out.precision();
+
+	out << "{\"traceEvents\": [" << std::endl;
+	for(size_t i = 0; i < records.size(); ++i) {
+		const auto& record = records[i];
+		out << "  {\"name\": \"" << escape_json(record.name) << "\", \"cat\": \"" << get_type_name(record.type)
+			<< "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << (record.type == KERNEL ? 0 : 1) << std::fixed << std::setprecision(3)
+			<< ", \"ts\": " << (record.start - time_base) * 1e-3 << ", \"dur\": " << (record.end - record.start) * 1e-3
+			<< ", \"args\": {\"queued_us\": " << (record.queued - time_base) * 1e-3
+			<< ", \"submit_us\": " << (record.submit - time_base) * 1e-3
+			<< ", \"bytes\": " << record.num_bytes << "}}" << (i + 1 < records.size() ? "," : "") << std::endl;
+	}
+	out << "]}" << std::endl;
+	out.flags(flags);
+	out.precision(precision);
+}
+
+
+} // basic_opencl
+} // automy
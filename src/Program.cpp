@@ -6,20 +6,118 @@
  */
 
 #include <automy/basic_opencl/Program.h>
+#include <automy/basic_opencl/DeviceInfo.h>
 
 #include <map>
 #include <set>
+#include <queue>
 #include <mutex>
+#include <chrono>
+#include <thread>
 #include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+
+// cl_ext_float_atomics
+#ifndef CL_DEVICE_GLOBAL_FP_ATOMIC_ADD_EXT
+#define CL_DEVICE_GLOBAL_FP_ATOMIC_ADD_EXT (1 << 1)
+#endif
+#ifndef CL_DEVICE_LOCAL_FP_ATOMIC_ADD_EXT
+#define CL_DEVICE_LOCAL_FP_ATOMIC_ADD_EXT (1 << 17)
+#endif
 
 
 namespace automy {
 namespace basic_opencl {
 
+/*
+ * Worker threads for build_async() and build_shared(), started on demand up to one per hardware thread.
+ * Remaining tasks are finished before the threads exit.
+ */
+class BuildPool {
+public:
+	~BuildPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			do_stop = true;
+		}
+		signal.notify_all();
+		for(auto& thread : threads) {
+			thread.join();
+		}
+	}
+	
+	void submit(const std::function<void()>& task) {
+		std::lock_guard<std::mutex> lock(mutex);
+		tasks.push(task);
+		if(num_idle == 0 && threads.size() < max_threads) {
+			threads.emplace_back(&BuildPool::run, this);
+		}
+		signal.notify_one();
+	}
+	
+private:
+	void run() {
+		std::unique_lock<std::mutex> lock(mutex);
+		while(true) {
+			num_idle++;
+			signal.wait(lock, [this]() { return do_stop || !tasks.empty(); });
+			num_idle--;
+			if(tasks.empty()) {
+				return;
+			}
+			const auto task = tasks.front();
+			tasks.pop();
+			lock.unlock();
+			task();
+			lock.lock();
+		}
+	}
+	
+private:
+	const size_t max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+	
+	std::mutex mutex;
+	std::condition_variable signal;
+	std::queue<std::function<void()>> tasks;
+	std::vector<std::thread> threads;
+	size_t num_idle = 0;
+	bool do_stop = false;
+	
+};
+
+static BuildPool& get_build_pool() {
+	static BuildPool pool;
+	return pool;
+}
+
 std::shared_ptr<Program> Program::create(cl_context context) {
 	return std::make_shared<Program>(context);
 }
 
+std::shared_ptr<Program> Program::create(	cl_context context, const std::vector<std::string>& files, const std::string& options,
+											const std::vector<std::string>& include_paths, std::shared_ptr<BinaryCache> binary_cache,
+											std::shared_ptr<WorkGroupTuner> tuner, const std::string& source_code)
+{
+	auto program = create(context);
+	program->options = options;
+	program->binary_cache = binary_cache;
+	program->tuner = tuner;
+	for(const auto& path : include_paths) {
+		program->add_include_path(path);
+	}
+	if(!source_code.empty()) {
+		program->add_source_code(source_code);
+	}
+	for(const auto& file : files) {
+		program->add_source(file);
+	}
+	program->create_from_source();
+	return program;
+}
+
 Program::Program(cl_context context)
 	:	context(context)
 {
@@ -32,7 +130,11 @@ Program::~Program() {
 }
 
 void Program::add_include_path(const std::string& path) {
-	includes.insert(path);
+	if(!path.empty() && path.back() != '/' && path.back() != '\\') {
+		includes.insert(path + '/');
+	} else {
+		includes.insert(path);
+	}
 }
 
 void Program::add_source(const std::string& file_name)
@@ -44,6 +146,7 @@ void Program::add_source(const std::string& file_name)
 		std::ifstream in(dir + file_name);
 		if(in.good()) {
 			sources.push_back(std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()));
+			file_names.push_back(file_name);
 			return;
 		}
 	}
@@ -77,6 +180,7 @@ bool Program::build(const std::vector<cl_device_id>& devices, bool with_arg_name
 	if(!program) {
 		throw std::logic_error("program == nullptr");
 	}
+	const auto time_begin = std::chrono::steady_clock::now();
 	have_arg_info = with_arg_names;
 	
 	std::string options_ = options;
@@ -88,6 +192,28 @@ bool Program::build(const std::vector<cl_device_id>& devices, bool with_arg_name
 			options_ += " -I " + path;
 		}
 	}
+	if(feature_defines) {
+		options_ += get_feature_defines(devices, options_);
+	}
+	build_options = options_;
+	
+	// included files are part of the key, so that edits to them invalidate the cache
+	std::vector<std::string> key_sources;
+	if(binary_cache) {
+		key_sources = sources;
+		const auto included = BinaryCache::get_includes(sources, includes);
+		key_sources.insert(key_sources.end(), included.begin(), included.end());
+	}
+	
+	from_cache = false;
+	if(binary_cache) {
+		from_cache = build_from_cache(devices, key_sources, options_);
+		binary_cache->add_result(from_cache);
+	}
+	if(from_cache) {
+		build_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - time_begin).count();
+		return true;
+	}
 	
 	bool success = true;
 	if(cl_int err = clBuildProgram(program, devices.size(), devices.data(), options_.c_str(), 0, 0)) {
@@ -96,7 +222,125 @@ bool Program::build(const std::vector<cl_device_id>& devices, bool with_arg_name
 		}
 		success = false;
 	}
+	if(!get_build_info(devices)) {
+		success = false;
+	}
+	if(success && binary_cache) {
+		store_to_cache(devices, key_sources, options_);
+	}
+	build_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - time_begin).count();
+	return success;
+}
+
+void Program::build_or_throw(const std::vector<cl_device_id>& devices, bool with_arg_names)
+{
+	if(!build(devices, with_arg_names)) {
+		std::string names;
+		for(const auto& file_name : file_names) {
+			names += (names.empty() ? "" : ", ") + file_name;
+		}
+		std::ostringstream log;
+		print_build_log(log);
+		throw std::runtime_error("failed to build " + (names.empty() ? std::string("program") : names)
+				+ (options.empty() ? std::string() : " with '" + options + "'") + ":\n" + log.str());
+	}
+}
+
+std::future<bool> Program::build_async(const std::vector<cl_device_id>& devices, bool with_arg_names)
+{
+	if(!program) {
+		throw std::logic_error("program == nullptr");
+	}
+	// packaged_task is move-only, std::function needs a copyable target
+	auto task = std::make_shared<std::packaged_task<bool()>>(std::bind(&Program::build, this, devices, with_arg_names));
+	auto future = task->get_future();
+	get_build_pool().submit([task]() { (*task)(); });
+	return future;
+}
+
+std::shared_future<std::shared_ptr<Program>> Program::build_shared(	std::shared_ptr<Program> program,
+																	const std::vector<cl_device_id>& devices, bool async)
+{
+	const auto func = [program, devices]() -> std::shared_ptr<Program> {
+		program->build_or_throw(devices);
+		return program;
+	};
+	if(!async) {
+		return std::async(std::launch::deferred, func).share();
+	}
+	auto task = std::make_shared<std::packaged_task<std::shared_ptr<Program>()>>(func);
+	auto future = task->get_future().share();
+	get_build_pool().submit([task]() { (*task)(); });
+	return future;
+}
+
+std::string Program::get_feature_defines(const std::vector<cl_device_id>& devices, const std::string& options_)
+{
+	// only features supported by all devices, since they share the options
+	int device_version = 1000;
+	int c_version = 1000;
+	bool int64_atomics = true;
+	bool subgroups = true;
+	bool fp64 = true;
+	bool fp16 = true;
+	bool float_atomic_add_global = true;
+	bool float_atomic_add_local = true;
 	
+	for(cl_device_id device : devices) {
+		const auto info = DeviceInfo::get(device);
+		device_version = std::min(device_version, info->cl_version);
+		c_version = std::min(c_version, info->cl_c_version);
+		int64_atomics &= info->has_extension("cl_khr_int64_base_atomics");
+		subgroups &= info->has_extension("cl_khr_subgroups") || info->has_extension("cl_intel_subgroups");
+		fp64 &= info->has_extension("cl_khr_fp64");
+		fp16 &= info->has_extension("cl_khr_fp16");
+		
+		const cl_bitfield fp_atomic_caps = info->float_atomic_caps;
+		float_atomic_add_global &= bool(fp_atomic_caps & CL_DEVICE_GLOBAL_FP_ATOMIC_ADD_EXT);
+		float_atomic_add_local &= bool(fp_atomic_caps & CL_DEVICE_LOCAL_FP_ATOMIC_ADD_EXT);
+	}
+	std::string defines;
+	if(devices.empty()) {
+		return defines;
+	}
+	if(int64_atomics) {
+		defines += " -DHAVE_INT64_ATOMICS";
+	}
+	if(subgroups) {
+		defines += " -DHAVE_SUBGROUPS";
+	}
+	if(fp64) {
+		defines += " -DHAVE_FP64";
+	}
+	if(fp16) {
+		defines += " -DHAVE_FP16";
+	}
+	if(float_atomic_add_global || float_atomic_add_local) {
+		// native float atomics need OpenCL C 2.0 or later, selected here unless the options already choose a version
+		bool have_cl_std = options_.find("-cl-std=") != std::string::npos;
+		if(!have_cl_std && device_version >= 30) {
+			defines += " -cl-std=CL3.0";
+			have_cl_std = true;
+		}
+		else if(!have_cl_std && c_version >= 20) {
+			defines += " -cl-std=CL2.0";
+			have_cl_std = true;
+		}
+		if(have_cl_std) {
+			if(float_atomic_add_global) {
+				defines += " -DHAVE_FLOAT_ATOMIC_ADD_GLOBAL";
+			}
+			if(float_atomic_add_local) {
+				defines += " -DHAVE_FLOAT_ATOMIC_ADD_LOCAL";
+			}
+		}
+	}
+	return defines;
+}
+
+bool Program::get_build_info(const std::vector<cl_device_id>& devices)
+{
+	bool success = true;
 	for(cl_device_id device : devices) {
 		size_t length = 0;
 		cl_build_status status;
@@ -124,6 +368,110 @@ bool Program::build(const std::vector<cl_device_id>& devices, bool with_arg_name
 	return success;
 }
 
+bool Program::build_from_cache(const std::vector<cl_device_id>& devices, const std::vector<std::string>& key_sources, const std::string& options_)
+{
+	std::vector<std::string> keys;
+	std::vector<std::vector<unsigned char>> binaries(devices.size());
+	for(size_t i = 0; i < devices.size(); ++i) {
+		keys.push_back(BinaryCache::get_key(key_sources, options_, devices[i]));
+		if(!binary_cache->load(keys[i], binaries[i])) {
+			return false;
+		}
+	}
+	std::vector<size_t> lengths;
+	std::vector<const unsigned char*> list;
+	for(const auto& binary : binaries) {
+		lengths.push_back(binary.size());
+		list.push_back(binary.data());
+	}
+	
+	cl_int err = 0;
+	std::vector<cl_int> status(devices.size());
+	cl_program binary_program = clCreateProgramWithBinary(
+			context, devices.size(), devices.data(), lengths.data(), list.data(), status.data(), &err);
+	if(!err) {
+		err = clBuildProgram(binary_program, devices.size(), devices.data(), options_.c_str(), 0, 0);
+	}
+	if(!err && have_arg_info && !has_arg_info(binary_program)) {
+		err = CL_KERNEL_ARG_INFO_NOT_AVAILABLE;
+	}
+	if(err) {
+		// stale or unusable entry, fall back to source
+		if(binary_program) {
+			clReleaseProgram(binary_program);
+		}
+		for(const auto& key : keys) {
+			binary_cache->invalidate(key);
+		}
+		return false;
+	}
+	std::swap(program, binary_program);
+	clReleaseProgram(binary_program);
+	
+	get_build_info(devices);
+	return true;
+}
+
+bool Program::has_arg_info(cl_program program_)
+{
+	size_t length = 0;
+	if(clGetProgramInfo(program_, CL_PROGRAM_KERNEL_NAMES, 0, 0, &length) || length < 2) {
+		return true;		// no kernels to check
+	}
+	std::string names;
+	names.resize(length);
+	if(clGetProgramInfo(program_, CL_PROGRAM_KERNEL_NAMES, names.size(), &names[0], 0)) {
+		return false;
+	}
+	names = names.substr(0, names.find(';')).c_str();
+	
+	cl_int err = 0;
+	cl_kernel kernel = clCreateKernel(program_, names.c_str(), &err);
+	if(err) {
+		return false;
+	}
+	cl_uint num_args = 0;
+	err = clGetKernelInfo(kernel, CL_KERNEL_NUM_ARGS, sizeof(num_args), &num_args, 0);
+	if(!err && num_args) {
+		// some drivers only provide argument info for programs created from source
+		err = clGetKernelArgInfo(kernel, 0, CL_KERNEL_ARG_NAME, 0, 0, &length);
+	}
+	clReleaseKernel(kernel);
+	return !err;
+}
+
+void Program::store_to_cache(const std::vector<cl_device_id>& devices, const std::vector<std::string>& key_sources, const std::string& options_)
+{
+	cl_uint num_devices = 0;
+	if(cl_int err = clGetProgramInfo(program, CL_PROGRAM_NUM_DEVICES, sizeof(num_devices), &num_devices, 0)) {
+		throw opencl_error_t("clGetProgramInfo(CL_PROGRAM_NUM_DEVICES) failed with " + get_error_string(err));
+	}
+	std::vector<cl_device_id> program_devices(num_devices);
+	if(cl_int err = clGetProgramInfo(program, CL_PROGRAM_DEVICES, program_devices.size() * sizeof(cl_device_id), program_devices.data(), 0)) {
+		throw opencl_error_t("clGetProgramInfo(CL_PROGRAM_DEVICES) failed with " + get_error_string(err));
+	}
+	std::vector<size_t> lengths(num_devices);
+	if(cl_int err = clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, lengths.size() * sizeof(size_t), lengths.data(), 0)) {
+		throw opencl_error_t("clGetProgramInfo(CL_PROGRAM_BINARY_SIZES) failed with " + get_error_string(err));
+	}
+	std::vector<std::vector<unsigned char>> binaries(num_devices);
+	std::vector<unsigned char*> list(num_devices);
+	for(cl_uint i = 0; i < num_devices; ++i) {
+		binaries[i].resize(lengths[i]);
+		list[i] = binaries[i].data();
+	}
+	if(cl_int err = clGetProgramInfo(program, CL_PROGRAM_BINARIES, list.size() * sizeof(unsigned char*), list.data(), 0)) {
+		throw opencl_error_t("clGetProgramInfo(CL_PROGRAM_BINARIES) failed with " + get_error_string(err));
+	}
+	for(cl_uint i = 0; i < num_devices; ++i) {
+		for(cl_device_id device : devices) {
+			if(device == program_devices[i]) {
+				binary_cache->store(BinaryCache::get_key(key_sources, options_, device), binaries[i]);
+			}
+		}
+	}
+}
+
 void Program::print_sources(std::ostream& out) const {
 	for(const std::string& source : sources) {
 		out << source << std::endl;
@@ -142,7 +490,33 @@ std::shared_ptr<Kernel> Program::create_kernel(const std::string& name) const {
 	if(err) {
 		throw opencl_error_t("clCreateKernel() failed for '" + name + "' with " + get_error_string(err));
 	}
-	return Kernel::create(kernel, have_arg_info);
+	auto out = Kernel::create(kernel, have_arg_info);
+	out->tuner = tuner;
+	out->build_options = build_options;
+	return out;
+}
+
+std::shared_ptr<Kernel> Program::get_kernel(const std::string& name) {
+	const auto key = std::make_pair(std::this_thread::get_id(), name);
+	std::lock_guard<std::mutex> lock(kernel_mutex);
+	
+	auto iter = thread_kernels.find(key);
+	if(iter != thread_kernels.end()) {
+		return iter->second;
+	}
+	auto& prototype = kernel_prototypes[name];
+	if(!prototype) {
+		prototype = create_kernel(name);
+	}
+	const auto kernel = prototype->clone();
+	thread_kernels[key] = kernel;
+	return kernel;
+}
+
+void Program::clear_kernels() {
+	std::lock_guard<std::mutex> lock(kernel_mutex);
+	thread_kernels.clear();
+	kernel_prototypes.clear();
 }
 
 
@@ -0,0 +1,92 @@
+/*
+ * ProgramTemplate.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#include <automy/basic_opencl/ProgramTemplate.h>
+
+
+
+namespace automy {
+namespace basic_opencl {
+
+std::string ProgramTemplate::params_t::get_options() const
+{
+	std::string out;
+	for(const auto& entry : values) {
+		out += (out.empty() ? "-D" : " -D") + entry.first + "=" + entry.second;
+	}
+	return out;
+}
+
+ProgramTemplate::ProgramTemplate(cl_context context, const std::vector<cl_device_id>& devices, const std::vector<std::string>& files)
+	:	context(context), devices(devices), files(files)
+{
+}
+
+ProgramTemplate::~ProgramTemplate()
+{
+	for(const auto& entry : programs) {
+		if(entry.second.valid()) {
+			entry.second.wait();
+		}
+	}
+}
+
+std::shared_ptr<ProgramTemplate> ProgramTemplate::create(	cl_context context, const std::vector<cl_device_id>& devices,
+															const std::vector<std::string>& files)
+{
+	return std::make_shared<ProgramTemplate>(context, devices, files);
+}
+
+void ProgramTemplate::add_include_path(const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	include_paths.push_back(path);
+}
+
+std::shared_ptr<Program> ProgramTemplate::get(const params_t& params)
+{
+	return get_future(params, false).get();
+}
+
+std::shared_future<std::shared_ptr<Program>> ProgramTemplate::get_async(const params_t& params)
+{
+	return get_future(params, true);
+}
+
+std::shared_future<std::shared_ptr<Program>> ProgramTemplate::get_future(const params_t& params, bool async)
+{
+	const auto options_ = params.get_options() + (options.empty() ? "" : " " + options);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto& future = programs[options_];
+	if(!future.valid()) {
+		auto program = Program::create(context, files, options_, include_paths, binary_cache, tuner);
+		future = Program::build_shared(program, devices, async);
+	}
+	return future;
+}
+
+std::shared_ptr<Kernel> ProgramTemplate::get_kernel(const params_t& params, const std::string& name)
+{
+	return get(params)->get_kernel(name);
+}
+
+size_t ProgramTemplate::get_num_programs() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	size_t count = 0;
+	for(const auto& entry : programs) {
+		if(entry.second.valid()) {
+			count++;
+		}
+	}
+	return count;
+}
+
+
+} // basic_opencl
+} // automy
@@ -0,0 +1,66 @@
+/*
+ * QueueSet.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#include <automy/basic_opencl/QueueSet.h>
+#include <automy/basic_opencl/Context.h>
+
+
+namespace automy {
+namespace basic_opencl {
+
+QueueSet::QueueSet(cl_context context, cl_device_id device, size_t num_transfer, cl_command_queue_properties properties)
+	:	device(device)
+{
+	compute_queue = create_command_queue(context, device, properties);
+	for(size_t i = 0; i < num_transfer; ++i) {
+		transfer_queues.push_back(create_command_queue(context, device, properties));
+	}
+}
+
+std::shared_ptr<QueueSet> QueueSet::create(	cl_context context, cl_device_id device, size_t num_transfer,
+											cl_command_queue_properties properties)
+{
+	return std::make_shared<QueueSet>(context, device, num_transfer, properties);
+}
+
+std::shared_ptr<CommandQueue> QueueSet::next_transfer()
+{
+	if(transfer_queues.empty()) {
+		return compute_queue;
+	}
+	const auto queue = transfer_queues[next_index];
+	next_index = (next_index + 1) % transfer_queues.size();
+	return queue;
+}
+
+void QueueSet::wait(std::shared_ptr<CommandQueue> queue, const std::vector<Event>& events) const
+{
+	if(EventList(events).size()) {
+		queue->enqueue_barrier(events);
+	}
+}
+
+void QueueSet::flush()
+{
+	// submit transfers first, so they can start before the compute queue needs them
+	for(const auto& queue : transfer_queues) {
+		queue->flush();
+	}
+	compute_queue->flush();
+}
+
+void QueueSet::finish()
+{
+	for(const auto& queue : transfer_queues) {
+		queue->finish();
+	}
+	compute_queue->finish();
+}
+
+
+} // basic_opencl
+} // automy
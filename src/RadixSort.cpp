@@ -0,0 +1,227 @@
+/*
+ * RadixSort.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#include <automy/basic_opencl/RadixSort.h>
+#include <automy/basic_opencl/DeviceInfo.h>
+
+#include <algorithm>
+
+
+namespace automy {
+namespace basic_opencl {
+
+static const int RADIX_BITS = 4;		// see radix_sort.cl
+static const int RADIX_SIZE = 16;
+static const size_t RADIX_ITEMS = 4;
+static const size_t RADIX_MAX_LOCAL_SIZE = 128;
+
+static std::string get_value_type(size_t value_size)
+{
+	switch(value_size) {
+		case 1: return "uchar";
+		case 2: return "ushort";
+		case 4: return "uint";
+		case 8: return "ulong";
+		case 16: return "uint4";
+	}
+	throw std::logic_error("RadixSort: unsupported value size: " + std::to_string(value_size));
+}
+
+RadixSort::RadixSort(std::shared_ptr<Scan> scan, const std::string& kernel_path_)
+	:	scan(scan), kernel_path(kernel_path_)
+{
+	const size_t max_local_size = std::min(DeviceInfo::get(scan->get_device())->max_work_group_size, RADIX_MAX_LOCAL_SIZE);
+	while(tile_local_size * 2 <= max_local_size) {
+		tile_local_size *= 2;
+	}
+}
+
+std::shared_ptr<RadixSort> RadixSort::create(std::shared_ptr<Scan> scan, const std::string& kernel_path)
+{
+	return std::make_shared<RadixSort>(scan, kernel_path);
+}
+
+void RadixSort::check_values(size_t num_keys, size_t num_values)
+{
+	if(num_values < num_keys) {
+		throw std::logic_error("RadixSort: num_values < num_keys");
+	}
+	if(num_keys > 0xFFFFFFFF) {
+		throw std::logic_error("RadixSort: input too large");
+	}
+}
+
+RadixSort::kernels_t& RadixSort::get_kernels(int key_bits, size_t value_size)
+{
+	std::string options = "-DRADIX_KEY_" + std::to_string(key_bits) + " -DRADIX_LOCAL_SIZE=" + std::to_string(tile_local_size);
+	if(value_size) {
+		options += " -DRADIX_VALUE_T=" + get_value_type(value_size);
+	}
+	auto& entry = kernels[options];
+	if(!entry.program) {
+		auto program = Program::create(scan->get_context(), {"radix_sort.cl"}, options, {kernel_path}, scan->binary_cache);
+		program->build_or_throw({scan->get_device()});
+		entry.encode = program->create_kernel("radix_encode");
+		entry.decode = program->create_kernel("radix_decode");
+		entry.count = program->create_kernel("radix_count");
+		entry.scatter = program->create_kernel("radix_scatter");
+		if(value_size) {
+			entry.gather = program->create_kernel("radix_gather");
+		}
+		if(key_bits == 64) {
+			entry.make_segmented = program->create_kernel("radix_make_segmented");
+			entry.split_segmented = program->create_kernel("radix_split_segmented");
+		}
+		const size_t max_local_size = std::min<size_t>(entry.encode->get_max_work_group_size(scan->get_device()), 256);
+		while(entry.local_size * 2 <= max_local_size) {
+			entry.local_size *= 2;
+		}
+		entry.program = program;
+	}
+	return entry;
+}
+
+Event RadixSort::sort_keys(	std::shared_ptr<CommandQueue> queue, int key_bits, key_mode_e mode, Buffer& keys,
+							Buffer* values, size_t value_size, size_t num, const std::vector<Event>& wait_list)
+{
+	if(num < 2) {
+		return queue->enqueue_marker(wait_list);
+	}
+	auto& kernels = get_kernels(key_bits, values ? value_size : 0);
+
+	std::vector<Event> deps = wait_list;
+	if(mode != MODE_UNSIGNED) {
+		kernels.encode->set_args(keys, cl_uint(num), cl_uint(mode));
+		deps = {kernels.encode->enqueue_ceiled(queue, num, kernels.local_size, deps)};
+	}
+	std::vector<std::shared_ptr<Buffer>> scratch;
+	auto event = sort_passes(queue, key_bits, keys, values, value_size, num, key_bits, deps, scratch);
+
+	if(mode != MODE_UNSIGNED) {
+		kernels.decode->set_args(keys, cl_uint(num), cl_uint(mode));
+		event = kernels.decode->enqueue_ceiled(queue, num, kernels.local_size, {event});
+	}
+	event.set_callback([scratch](cl_int) {});		// keeps scratch memory alive until finished
+	return event;
+}
+
+Event RadixSort::sort_passes(	std::shared_ptr<CommandQueue> queue, int key_bits, Buffer& keys, Buffer* values, size_t value_size,
+								size_t num, int end_bit, const std::vector<Event>& wait_list, std::vector<std::shared_ptr<Buffer>>& scratch)
+{
+	const auto pool = scan->get_scratch_pool();
+	const size_t key_size = key_bits / 8;
+	auto& kernels = get_kernels(key_bits, values ? value_size : 0);
+
+	const size_t tile_size = tile_local_size * RADIX_ITEMS;
+	const size_t num_tiles = (num + tile_size - 1) / tile_size;
+
+	auto hist = Buffer1D<cl_uint>::create(pool, RADIX_SIZE * num_tiles);
+	auto keys_tmp = Buffer1D<cl_uchar>::create(pool, num * key_size);
+	std::shared_ptr<Buffer1D<cl_uchar>> values_tmp;
+	if(values) {
+		values_tmp = Buffer1D<cl_uchar>::create(pool, num * value_size);
+		scratch.push_back(values_tmp);
+	}
+	scratch.push_back(hist);
+	scratch.push_back(keys_tmp);
+
+	Buffer* keys_in = &keys;
+	Buffer* keys_out = keys_tmp.get();
+	Buffer* values_in = values;
+	Buffer* values_out = values_tmp.get();
+
+	std::vector<Event> deps = wait_list;
+	for(int shift = 0; shift < end_bit; shift += RADIX_BITS) {
+		kernels.count->set_args(*keys_in, cl_uint(num), cl_uint(shift), *hist);
+		auto event = kernels.count->enqueue(queue, num_tiles * tile_local_size, tile_local_size, deps);
+
+		event = scan->scan(queue, "UINT", sizeof(cl_uint), *hist, *hist, RADIX_SIZE * num_tiles, false, {event});
+
+		if(values) {
+			kernels.scatter->set_args(*keys_in, *keys_out, *values_in, *values_out, cl_uint(num), cl_uint(shift), *hist);
+		} else {
+			kernels.scatter->set_args(*keys_in, *keys_out, cl_uint(num), cl_uint(shift), *hist);
+		}
+		deps = {kernels.scatter->enqueue(queue, num_tiles * tile_local_size, tile_local_size, {event})};
+
+		std::swap(keys_in, keys_out);
+		std::swap(values_in, values_out);
+	}
+
+	if(keys_in != &keys) {
+		std::vector<Event> copies = {copy(queue, *keys_in, keys, num * key_size, deps)};
+		if(values) {
+			copies.push_back(copy(queue, *values_in, *values, num * value_size, deps));
+		}
+		deps = copies;
+	}
+	return deps.size() == 1 ? deps[0] : queue->enqueue_marker(deps);
+}
+
+Event RadixSort::sort_segments(	std::shared_ptr<CommandQueue> queue, key_mode_e mode, Buffer& keys, const Buffer& segments,
+								cl_uint num_segments, Buffer* values, size_t value_size, size_t num, const std::vector<Event>& wait_list)
+{
+	if(num < 2) {
+		return queue->enqueue_marker(wait_list);
+	}
+	const auto pool = scan->get_scratch_pool();
+	auto& kernels_32 = get_kernels(32, values ? value_size : 0);
+	auto& kernels_64 = get_kernels(64, sizeof(cl_uint));
+
+	std::vector<Event> deps = wait_list;
+	if(mode != MODE_UNSIGNED) {
+		kernels_32.encode->set_args(keys, cl_uint(num), cl_uint(mode));
+		deps = {kernels_32.encode->enqueue_ceiled(queue, num, kernels_32.local_size, deps)};
+	}
+	auto segment_keys = Buffer1D<cl_ulong>::create(pool, num);
+	auto segment_index = Buffer1D<cl_uint>::create(pool, num);
+	std::vector<std::shared_ptr<Buffer>> scratch = {segment_keys, segment_index};
+
+	kernels_64.make_segmented->set_args(keys, segments, *segment_keys, *segment_index, cl_uint(num));
+	auto sorted = kernels_64.make_segmented->enqueue_ceiled(queue, num, kernels_64.local_size, deps);
+
+	// skip passes over segment bits which are always zero
+	int segment_bits = 0;
+	while(segment_bits < 32 && (cl_ulong(num_segments) - 1) >> segment_bits) {
+		segment_bits += RADIX_BITS;
+	}
+	sorted = sort_passes(queue, 64, *segment_keys, segment_index.get(), sizeof(cl_uint), num, 32 + segment_bits, {sorted}, scratch);
+
+	kernels_64.split_segmented->set_args(*segment_keys, keys, cl_uint(num));
+	auto event = kernels_64.split_segmented->enqueue_ceiled(queue, num, kernels_64.local_size, {sorted});
+
+	if(mode != MODE_UNSIGNED) {
+		kernels_32.decode->set_args(keys, cl_uint(num), cl_uint(mode));
+		event = kernels_32.decode->enqueue_ceiled(queue, num, kernels_32.local_size, {event});
+	}
+	if(values) {
+		auto values_tmp = Buffer1D<cl_uchar>::create(pool, num * value_size);
+		scratch.push_back(values_tmp);
+		const auto copied = copy(queue, *values, *values_tmp, num * value_size, wait_list);
+
+		// needs the sorted segment_index as well as the copy
+		kernels_32.gather->set_args(*segment_index, *values_tmp, *values, cl_uint(num));
+		const auto gathered = kernels_32.gather->enqueue_ceiled(queue, num, kernels_32.local_size, {sorted, copied});
+		event = queue->enqueue_marker({event, gathered});
+	}
+	event.set_callback([scratch](cl_int) {});		// keeps scratch memory alive until finished
+	return event;
+}
+
+Event RadixSort::copy(std::shared_ptr<CommandQueue> queue, const Buffer& src, Buffer& dst, size_t num_bytes, const std::vector<Event>& wait_list)
+{
+	Event event;
+	const EventList list(wait_list);
+	if(cl_int err = clEnqueueCopyBuffer(queue->get(), src.data(), dst.data(), 0, 0, num_bytes, list.size(), list.data(), event.reset())) {
+		throw opencl_error_t("clEnqueueCopyBuffer() failed with " + get_error_string(err));
+	}
+	queue->record(event, Profiler::COPY, num_bytes);
+	return event;
+}
+
+} // basic_opencl
+} // automy
@@ -0,0 +1,131 @@
+/*
+ * Reduction.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#include <automy/basic_opencl/Reduction.h>
+#include <automy/basic_opencl/DeviceInfo.h>
+
+#include <algorithm>
+
+
+namespace automy {
+namespace basic_opencl {
+
+Reduction::Reduction(cl_context context, cl_device_id device, const std::string& kernel_path_)
+	:	context(context), device(device), kernel_path(kernel_path_)
+{
+	const auto info = DeviceInfo::get(device);
+	num_compute_units = std::max<cl_uint>(info->compute_units, 1);
+	have_subgroups = info->has_extension("cl_khr_subgroups");
+}
+
+std::shared_ptr<Reduction> Reduction::create(cl_context context, cl_device_id device, const std::string& kernel_path)
+{
+	return std::make_shared<Reduction>(context, device, kernel_path);
+}
+
+const char* Reduction::get_op_name(op_e op)
+{
+	switch(op) {
+		case SUM: return "SUM";
+		case MIN: return "MIN";
+		case MAX: return "MAX";
+		case ARGMIN: return "ARGMIN";
+		case ARGMAX: return "ARGMAX";
+		case MEAN_VAR: return "MEAN_VAR";
+	}
+	return "unknown";
+}
+
+Reduction::kernels_t Reduction::get_kernels(op_e op, const std::string& type)
+{
+	const std::string options = std::string("-DREDUCE_") + get_op_name(op) + " -DREDUCE_" + type
+			+ (have_subgroups ? " -DREDUCE_SUBGROUPS" : "");
+
+	auto& entry = kernels[options];
+	if(!entry.program) {
+		auto program = Program::create(context, {"reduce.cl"}, options, {kernel_path}, binary_cache);
+		program->build_or_throw({device});
+		entry.first = program->create_kernel("reduce_first");
+		entry.final = program->create_kernel("reduce_final");
+		entry.program = program;
+	}
+	return entry;
+}
+
+void Reduction::reduce(	std::shared_ptr<CommandQueue> queue, op_e op, const std::string& type, const Buffer& in, size_t num,
+						Buffer* result, size_t result_size, void* host_result, size_t acc_size)
+{
+	if(num > 0xFFFFFFFF) {
+		throw std::logic_error("Reduction: input too large");
+	}
+	if(result && result_size < acc_size) {
+		throw std::logic_error("Reduction: result buffer too small");
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+
+	const auto kernels = get_kernels(op, type);
+
+	size_t local_size = 1;
+	const size_t max_local_size = std::min<size_t>(
+			std::min(kernels.first->get_max_work_group_size(device), kernels.final->get_max_work_group_size(device)), 256);
+	while(local_size * 2 <= max_local_size) {
+		local_size *= 2;
+	}
+	// a few groups per compute unit is enough to saturate memory bandwidth
+	const size_t num_groups = std::max<size_t>(
+			std::min((num + local_size * 4 - 1) / (local_size * 4), num_compute_units * 8), 1);
+
+	// scratch is per call, it goes back to the pool once the last command has finished
+	auto scratch_pool = pool;
+	if(!scratch_pool) {
+		if(!default_pool) {
+			default_pool = BufferPool::create(context);
+		}
+		scratch_pool = default_pool;
+	}
+	std::shared_ptr<Buffer1D<cl_uchar>> partial;
+	std::shared_ptr<Buffer1D<cl_uchar>> result_acc;
+
+	Buffer* out = result;
+	if(!out) {
+		result_acc = Buffer1D<cl_uchar>::create(scratch_pool, acc_size);
+		out = result_acc.get();
+	}
+	const Kernel::local_t local_mem(local_size * acc_size);
+
+	// explicit dependencies, for out-of-order queues
+	Event last;
+	if(num_groups == 1) {
+		kernels.first->set_args(in, cl_uint(num), *out, local_mem);
+		last = kernels.first->enqueue(queue, local_size, local_size, {});
+	} else {
+		partial = Buffer1D<cl_uchar>::create(scratch_pool, num_groups * acc_size);
+		kernels.first->set_args(in, cl_uint(num), *partial, local_mem);
+		const auto first = kernels.first->enqueue(queue, num_groups * local_size, local_size, {});
+
+		kernels.final->set_args(*partial, cl_uint(num_groups), *out, local_mem);
+		last = kernels.final->enqueue(queue, local_size, local_size, {first});
+	}
+
+	if(host_result) {
+		const EventList wait_list({last});
+		Event event;
+		if(cl_int err = clEnqueueReadBuffer(queue->get(), out->data(), CL_TRUE, 0, acc_size, host_result,
+											wait_list.size(), wait_list.data(), queue->get_event(event)))
+		{
+			throw opencl_error_t("clEnqueueReadBuffer() failed with " + get_error_string(err));
+		}
+		queue->record(event, Profiler::READ, acc_size);
+	}
+	else if(partial) {
+		last.set_callback([partial](cl_int) {});		// keeps partial alive until finished
+	}
+}
+
+
+} // basic_opencl
+} // automy
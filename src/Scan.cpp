@@ -0,0 +1,104 @@
+/*
+ * Scan.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#include <automy/basic_opencl/Scan.h>
+
+#include <algorithm>
+
+
+namespace automy {
+namespace basic_opencl {
+
+static const size_t SCAN_ITEMS = 4;		// see scan.cl
+
+Scan::Scan(cl_context context, cl_device_id device, const std::string& kernel_path_)
+	:	context(context), device(device), kernel_path(kernel_path_)
+{
+}
+
+std::shared_ptr<Scan> Scan::create(cl_context context, cl_device_id device, const std::string& kernel_path)
+{
+	return std::make_shared<Scan>(context, device, kernel_path);
+}
+
+Scan::kernels_t Scan::get_kernels(const std::string& type)
+{
+	auto& entry = kernels[type];
+	if(!entry.program) {
+		auto program = Program::create(context, {"scan.cl"}, "-DSCAN_" + type, {kernel_path}, binary_cache);
+		program->build_or_throw({device});
+		entry.scan_blocks = program->create_kernel("scan_blocks");
+		entry.add_block_offsets = program->create_kernel("add_block_offsets");
+
+		const size_t max_local_size = std::min<size_t>(std::min(
+				entry.scan_blocks->get_max_work_group_size(device),
+				entry.add_block_offsets->get_max_work_group_size(device)), 256);
+		entry.local_size = 1;
+		while(entry.local_size * 2 <= max_local_size) {
+			entry.local_size *= 2;
+		}
+		entry.program = program;
+	}
+	return entry;
+}
+
+std::shared_ptr<BufferPool> Scan::get_scratch_pool()
+{
+	if(pool) {
+		return pool;
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	if(!default_pool) {
+		default_pool = BufferPool::create(context);
+	}
+	return default_pool;
+}
+
+Event Scan::scan(	std::shared_ptr<CommandQueue> queue, const std::string& type, size_t type_size,
+					const Buffer& in, Buffer& out, size_t num, bool inclusive, const std::vector<Event>& wait_list)
+{
+	if(num > 0xFFFFFFFF) {
+		throw std::logic_error("Scan: input too large");
+	}
+	if(!num) {
+		return queue->enqueue_marker(wait_list);
+	}
+	const auto scratch_pool = get_scratch_pool();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	std::vector<std::shared_ptr<Buffer1D<cl_uchar>>> scratch;
+	auto event = scan_level(queue, get_kernels(type), type_size, in, out, num, inclusive, wait_list, scratch);
+	event.set_callback([scratch](cl_int) {});		// keeps block sums alive until finished
+	return event;
+}
+
+Event Scan::scan_level(	std::shared_ptr<CommandQueue> queue, const kernels_t& kernels, size_t type_size,
+						const Buffer& in, Buffer& out, size_t num, bool inclusive, const std::vector<Event>& wait_list,
+						std::vector<std::shared_ptr<Buffer1D<cl_uchar>>>& scratch)
+{
+	const size_t local_size = kernels.local_size;
+	const size_t block_size = local_size * SCAN_ITEMS;
+	const size_t num_blocks = (num + block_size - 1) / block_size;
+
+	auto sums = Buffer1D<cl_uchar>::create(pool ? pool : default_pool, num_blocks * type_size);
+	scratch.push_back(sums);
+
+	kernels.scan_blocks->set_args(in, out, *sums, cl_uint(num), cl_uint(inclusive), Kernel::local_t(local_size * type_size));
+	auto event = kernels.scan_blocks->enqueue(queue, num_blocks * local_size, local_size, wait_list);
+
+	if(num_blocks > 1) {
+		event = scan_level(queue, kernels, type_size, *sums, *sums, num_blocks, false, {event}, scratch);
+
+		kernels.add_block_offsets->set_args(out, *sums, cl_uint(num));
+		event = kernels.add_block_offsets->enqueue(queue, num_blocks * local_size, local_size, {event});
+	}
+	return event;
+}
+
+
+} // basic_opencl
+} // automy
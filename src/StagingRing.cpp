@@ -0,0 +1,175 @@
+/*
+ * StagingRing.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#include <automy/basic_opencl/StagingRing.h>
+
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+
+namespace automy {
+namespace basic_opencl {
+
+StagingRing::StagingRing(cl_context context, size_t chunk_size, size_t num_slots)
+	:	context(context), chunk_size(chunk_size), slots(std::max<size_t>(num_slots, 1)),
+		last_stats(std::make_shared<shared_stats_t>())
+{
+	if(!chunk_size) {
+		throw std::logic_error("chunk_size == 0");
+	}
+	for(auto& slot : slots) {
+		cl_int err = 0;
+		slot.buffer = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, chunk_size, nullptr, &err);
+		if(err) {
+			for(const auto& other : slots) {
+				if(other.buffer) {
+					clReleaseMemObject(other.buffer);
+				}
+			}
+			throw opencl_error_t("clCreateBuffer() failed with " + get_error_string(err));
+		}
+	}
+}
+
+StagingRing::~StagingRing()
+{
+	for(auto& slot : slots) {
+		try {
+			slot.event.wait();
+		} catch(...) {
+			// ignore
+		}
+		if(slot.host) {
+			clEnqueueUnmapMemObject(map_queue->get(), slot.buffer, slot.host, 0, 0, 0);
+		}
+	}
+	if(map_queue) {
+		clFinish(map_queue->get());
+	}
+	for(auto& slot : slots) {
+		clReleaseMemObject(slot.buffer);
+	}
+}
+
+std::shared_ptr<StagingRing> StagingRing::create(cl_context context, size_t chunk_size, size_t num_slots)
+{
+	return std::make_shared<StagingRing>(context, chunk_size, num_slots);
+}
+
+void StagingRing::map_slots(std::shared_ptr<CommandQueue> queue)
+{
+	if(map_queue) {
+		return;
+	}
+	// pinned memory stays mapped for the lifetime of the ring
+	for(auto& slot : slots) {
+		cl_int err = 0;
+		slot.host = clEnqueueMapBuffer(queue->get(), slot.buffer, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, chunk_size, 0, 0, 0, &err);
+		if(err) {
+			throw opencl_error_t("clEnqueueMapBuffer() failed with " + get_error_string(err));
+		}
+	}
+	map_queue = queue;
+}
+
+Event StagingRing::upload(	std::shared_ptr<CommandQueue> queue, cl_mem dst, size_t dst_offset, const void* src, size_t num_bytes,
+							const callback_t& on_chunk)
+{
+	map_slots(queue);
+	const auto time_begin = std::chrono::steady_clock::now();
+
+	size_t index = 0;
+	for(size_t offset = 0; offset < num_bytes; offset += chunk_size) {
+		auto& slot = slots[index++ % slots.size()];
+		const size_t length = std::min(chunk_size, num_bytes - offset);
+
+		slot.event.wait();		// previous transfer out of this slot is done
+		::memcpy(slot.host, ((const char*)src) + offset, length);
+
+		if(cl_int err = clEnqueueWriteBuffer(queue->get(), dst, CL_FALSE, dst_offset + offset, length, slot.host, 0, 0, slot.event.reset())) {
+			throw opencl_error_t("clEnqueueWriteBuffer() failed with " + get_error_string(err));
+		}
+		queue->record(slot.event, Profiler::WRITE, length);
+		queue->flush();
+
+		if(on_chunk) {
+			on_chunk(offset, length, slot.event);
+		}
+	}
+
+	std::vector<Event> pending;
+	for(const auto& slot : slots) {
+		pending.push_back(slot.event);
+	}
+	const EventList list(pending);
+	Event done;
+	if(cl_int err = clEnqueueMarkerWithWaitList(queue->get(), list.size(), list.data(), done.reset())) {
+		throw opencl_error_t("clEnqueueMarkerWithWaitList() failed with " + get_error_string(err));
+	}
+	auto stats = last_stats;
+	done.set_callback(
+		[stats, time_begin, num_bytes](cl_int status) {
+			if(status == CL_COMPLETE) {
+				std::lock_guard<std::mutex> lock(stats->mutex);
+				stats->stats.num_bytes = num_bytes;
+				stats->stats.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - time_begin).count();
+			}
+		});
+	return done;
+}
+
+void StagingRing::download(std::shared_ptr<CommandQueue> queue, cl_mem src, size_t src_offset, void* dst, size_t num_bytes)
+{
+	map_slots(queue);
+	const auto time_begin = std::chrono::steady_clock::now();
+
+	const size_t num_chunks = (num_bytes + chunk_size - 1) / chunk_size;
+	const auto enqueue_read =
+		[this, queue, src, src_offset, num_bytes](size_t chunk) {
+			auto& slot = slots[chunk % slots.size()];
+			const size_t offset = chunk * chunk_size;
+			const size_t length = std::min(chunk_size, num_bytes - offset);
+			if(cl_int err = clEnqueueReadBuffer(queue->get(), src, CL_FALSE, src_offset + offset, length, slot.host, 0, 0, slot.event.reset())) {
+				throw opencl_error_t("clEnqueueReadBuffer() failed with " + get_error_string(err));
+			}
+			queue->record(slot.event, Profiler::READ, length);
+		};
+
+	for(size_t chunk = 0; chunk < std::min(num_chunks, slots.size()); ++chunk) {
+		enqueue_read(chunk);
+	}
+	queue->flush();
+
+	for(size_t chunk = 0; chunk < num_chunks; ++chunk) {
+		auto& slot = slots[chunk % slots.size()];
+		const size_t offset = chunk * chunk_size;
+		const size_t length = std::min(chunk_size, num_bytes - offset);
+
+		slot.event.wait();
+		::memcpy(((char*)dst) + offset, slot.host, length);
+
+		if(chunk + slots.size() < num_chunks) {
+			enqueue_read(chunk + slots.size());
+			queue->flush();
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(last_stats->mutex);
+	last_stats->stats.num_bytes = num_bytes;
+	last_stats->stats.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - time_begin).count();
+}
+
+StagingRing::stats_t StagingRing::get_last_stats() const
+{
+	std::lock_guard<std::mutex> lock(last_stats->mutex);
+	return last_stats->stats;
+}
+
+
+} // basic_opencl
+} // automy
@@ -0,0 +1,225 @@
+/*
+ * WorkGroupTuner.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mad
+ */
+
+#include <automy/basic_opencl/WorkGroupTuner.h>
+#include <automy/basic_opencl/DeviceInfo.h>
+#include <automy/basic_opencl/BinaryCache.h>
+
+#include <cstdio>
+#include <limits>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+
+namespace automy {
+namespace basic_opencl {
+
+static size_t next_pow2(size_t value)
+{
+	size_t res = 1;
+	while(res < value) {
+		res <<= 1;
+	}
+	return res;
+}
+
+WorkGroupTuner::WorkGroupTuner(const std::string& file_name, size_t num_runs)
+	:	file_name(file_name), num_runs(std::max<size_t>(num_runs, 1))
+{
+	load();
+}
+
+std::shared_ptr<WorkGroupTuner> WorkGroupTuner::create(const std::string& file_name, size_t num_runs)
+{
+	return std::make_shared<WorkGroupTuner>(file_name, num_runs);
+}
+
+std::string WorkGroupTuner::get_device_key(cl_device_id device)
+{
+	auto iter = device_keys.find(device);
+	if(iter == device_keys.end()) {
+		iter = device_keys.emplace(device, get_device_name(device) + "|" + get_driver_version(device)).first;
+	}
+	return iter->second;
+}
+
+WorkGroupTuner::launch_t WorkGroupTuner::begin(	cl_kernel kernel, const std::string& name, const std::string& options,
+												cl_device_id device, cl_uint dims, const size_t* global_size)
+{
+	size3_t bucket = {{1, 1, 1}};
+	for(cl_uint i = 0; i < dims && i < 3; ++i) {
+		bucket[i] = next_pow2(global_size[i]);
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+
+	launch_t launch;
+	launch.key = get_device_key(device) + "|" + name + "|" + BinaryCache::get_hash({options}) + "|" + std::to_string(dims) + "|"
+			+ std::to_string(bucket[0]) + "," + std::to_string(bucket[1]) + "," + std::to_string(bucket[2]);
+
+	auto& entry = table[launch.key];
+	if(!entry.done && entry.candidates.empty()) {
+		entry.candidates = get_candidates(kernel, device, dims, bucket);
+		entry.times.resize(entry.candidates.size(), std::numeric_limits<double>::infinity());
+	}
+	if(entry.done) {
+		launch.local_size = entry.best;
+	}
+	else if(entry.num_started < entry.candidates.size() * num_runs) {
+		launch.candidate = entry.num_started++ % entry.candidates.size();
+		launch.local_size = entry.candidates[launch.candidate];
+	}
+	else {
+		// all trials in flight, use best so far
+		const auto best = std::min_element(entry.times.begin(), entry.times.end()) - entry.times.begin();
+		launch.local_size = entry.candidates[best];
+	}
+	return launch;
+}
+
+void WorkGroupTuner::end(const launch_t& launch, double time)
+{
+	if(!launch.is_trial()) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto iter = table.find(launch.key);
+	if(iter == table.end()) {
+		return;		// cleared in the meantime
+	}
+	auto& entry = iter->second;
+	if(entry.done || launch.candidate >= entry.times.size()) {
+		return;
+	}
+	entry.times[launch.candidate] = std::min(entry.times[launch.candidate], time);
+
+	if(++entry.num_finished >= entry.candidates.size() * num_runs) {
+		const auto best = std::min_element(entry.times.begin(), entry.times.end()) - entry.times.begin();
+		entry.best = entry.candidates[best];
+		entry.done = true;
+		entry.candidates.clear();
+		entry.times.clear();
+		save_locked();
+	}
+}
+
+bool WorkGroupTuner::find(const std::string& key, size3_t& local_size) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto iter = table.find(key);
+	if(iter != table.end() && iter->second.done) {
+		local_size = iter->second.best;
+		return true;
+	}
+	return false;
+}
+
+std::vector<WorkGroupTuner::size3_t> WorkGroupTuner::get_candidates(cl_kernel kernel, cl_device_id device, cl_uint dims, const size3_t& bucket)
+{
+	size_t max_group_size = 0;
+	if(cl_int err = clGetKernelWorkGroupInfo(kernel, device, CL_KERNEL_WORK_GROUP_SIZE, sizeof(max_group_size), &max_group_size, 0)) {
+		throw opencl_error_t("clGetKernelWorkGroupInfo(CL_KERNEL_WORK_GROUP_SIZE) failed with " + get_error_string(err));
+	}
+	size_t multiple = 1;
+	if(cl_int err = clGetKernelWorkGroupInfo(kernel, device, CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE, sizeof(multiple), &multiple, 0)) {
+		throw opencl_error_t("clGetKernelWorkGroupInfo(CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE) failed with " + get_error_string(err));
+	}
+	const auto& max_item_size = DeviceInfo::get(device)->max_work_item_sizes;
+	max_group_size = std::max<size_t>(max_group_size, 1);
+	multiple = std::max<size_t>(multiple, 1);
+
+	size3_t limit = {{1, 1, 1}};
+	size_t bucket_size = 1;
+	for(cl_uint i = 0; i < dims && i < 3; ++i) {
+		limit[i] = std::min(std::min(max_item_size[i], max_group_size), bucket[i]);
+		bucket_size *= bucket[i];
+	}
+	// smaller groups leave SIMD lanes idle, unless the whole range is smaller
+	const size_t min_group_size = std::min(std::min(multiple, max_group_size), bucket_size);
+
+	std::vector<size3_t> out;
+	for(size_t x = 1; x <= limit[0]; x <<= 1) {
+		for(size_t y = 1; y <= limit[1]; y <<= 1) {
+			for(size_t z = 1; z <= limit[2]; z <<= 1) {
+				const size_t total = x * y * z;
+				if(total <= max_group_size && total >= min_group_size && (total % multiple == 0 || total < multiple)) {
+					out.push_back(size3_t{{x, y, z}});
+				}
+			}
+		}
+	}
+	if(out.empty()) {
+		out.push_back(size3_t{{1, 1, 1}});
+	}
+	return out;
+}
+
+void WorkGroupTuner::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	table.clear();
+	save_locked();
+}
+
+void WorkGroupTuner::save() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	save_locked();
+}
+
+void WorkGroupTuner::load()
+{
+	if(file_name.empty()) {
+		return;
+	}
+	std::ifstream in(file_name);
+	std::string line;
+	while(std::getline(in, line)) {
+		const auto pos = line.rfind('\t');
+		if(pos == std::string::npos) {
+			continue;
+		}
+		entry_t entry;
+		std::istringstream ss(line.substr(pos + 1));
+		if(ss >> entry.best[0] >> entry.best[1] >> entry.best[2]) {
+			entry.done = true;
+			table[line.substr(0, pos)] = entry;
+		}
+	}
+}
+
+void WorkGroupTuner::save_locked() const
+{
+	if(file_name.empty()) {
+		return;
+	}
+	const auto tmp_name = BinaryCache::get_tmp_file_name(file_name);
+	{
+		std::ofstream out(tmp_name);
+		for(const auto& entry : table) {
+			if(entry.second.done) {
+				const auto& best = entry.second.best;
+				out << entry.first << '\t' << best[0] << ' ' << best[1] << ' ' << best[2] << std::endl;
+			}
+		}
+		if(!out.good()) {
+			std::remove(tmp_name.c_str());
+			return;		// not fatal, will tune again next time
+		}
+	}
+#ifdef _WIN32
+	std::remove(file_name.c_str());
+#endif
+	if(std::rename(tmp_name.c_str(), file_name.c_str())) {
+		std::remove(tmp_name.c_str());
+	}
+}
+
+
+} // basic_opencl
+} // automy